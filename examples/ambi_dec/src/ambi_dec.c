@@ -39,24 +39,12 @@ void ambi_dec_create
     ambi_dec_data* pData = (ambi_dec_data*)malloc(sizeof(ambi_dec_data));
     if (pData == NULL) { return;/*error*/ }
     *phAmbi = (void*)pData;
-    int i, j, t, ch, band;
+    int i, j, ch, band;
     
     /* afSTFT stuff */
     pData->hSTFT = NULL;
-    pData->STFTInputFrameTF = (complexVector**)malloc2d(TIME_SLOTS, MAX_NUM_SH_SIGNALS, sizeof(complexVector));
-    for(t=0; t<TIME_SLOTS; t++) {
-        for(ch=0; ch< MAX_NUM_SH_SIGNALS; ch++) {
-            pData->STFTInputFrameTF[t][ch].re = (float*)calloc(HYBRID_BANDS, sizeof(float));
-            pData->STFTInputFrameTF[t][ch].im = (float*)calloc(HYBRID_BANDS, sizeof(float));
-        }
-    }
-    pData->STFTOutputFrameTF = NULL;
-    pData->tempHopFrameTD = NULL;
-    
-    /* time-frequency domain frame per order (starting at 1st) */
-    for(i=1; i<=SH_ORDER; i++)
-        for(band=0; band<HYBRID_BANDS; band++)
-            pData->SHframeTF[i-1][band] = malloc( (i+1)*(i+1)*TIME_SLOTS*sizeof(float_complex));
+    pData->SHFrameTD = (float**)malloc2d(MAX_NUM_SH_SIGNALS, FRAME_SIZE, sizeof(float));
+    pData->outputFrameTD = (float**)malloc2d(MAX(MAX_NUM_LOUDSPEAKERS, NUM_EARS), FRAME_SIZE, sizeof(float));
     
     /* codec data */
     pData->pars = (codecPars*)malloc(sizeof(codecPars));
@@ -72,8 +60,7 @@ void ambi_dec_create
     pars->sofa_filepath = NULL;
     pars->hrirs = NULL;
     pars->hrir_dirs_deg = NULL;
-    pars->hrtf_vbap_gtableIdx = NULL;
-    pars->hrtf_vbap_gtableComp = NULL;
+    pars->hVbap = NULL;
     pars->itds_s = NULL;
     pars->hrtf_fb = NULL;
     pars->hrtf_fb_mag = NULL;
@@ -113,44 +100,15 @@ void ambi_dec_destroy
 {
     ambi_dec_data *pData = (ambi_dec_data*)(*phAmbi);
     codecPars *pars = pData->pars;
-    int i, j, t, ch, band;
+    int i, j;
     
     if (pData != NULL) {
         if(pData->hSTFT!=NULL)
             afSTFTfree(pData->hSTFT);
-        for (t = 0; t<TIME_SLOTS; t++) {
-            for (ch = 0; ch< MAX_NUM_SH_SIGNALS; ch++) {
-                free(pData->STFTInputFrameTF[t][ch].re);
-                free(pData->STFTInputFrameTF[t][ch].im);
-            }
-            if(pData->binauraliseLS &&  (pData->STFTOutputFrameTF!=NULL) ){
-                for (ch = 0; ch< NUM_EARS; ch++) {
-                    free(pData->STFTOutputFrameTF[t][ch].re);
-                    free(pData->STFTOutputFrameTF[t][ch].im);
-                }
-            }
-            else if((pData->STFTOutputFrameTF!=NULL)){
-                for (ch = 0; ch< pData->nLoudpkrs; ch++) {
-                    free(pData->STFTOutputFrameTF[t][ch].re);
-                    free(pData->STFTOutputFrameTF[t][ch].im);
-                }
-            }
-        }
-        free2d((void**)pData->STFTInputFrameTF, TIME_SLOTS);
-        free2d((void**)pData->STFTOutputFrameTF, TIME_SLOTS);
-        if(pData->binauraliseLS && (pData->tempHopFrameTD!=NULL) )
-            free2d((void**)pData->tempHopFrameTD, MAX(NUM_EARS, MAX_NUM_SH_SIGNALS));
-        else if(pData->tempHopFrameTD!=NULL)
-            free2d((void**)pData->tempHopFrameTD, MAX(pData->nLoudpkrs, MAX_NUM_SH_SIGNALS));
-        
-        for(i=1; i<=SH_ORDER; i++)
-            for(band=0; band<HYBRID_BANDS; band++)
-                free(pData->SHframeTF[i-1][band]);
+        free2d((void**)pData->SHFrameTD, MAX_NUM_SH_SIGNALS);
+        free2d((void**)pData->outputFrameTD, MAX(MAX_NUM_LOUDSPEAKERS, NUM_EARS));
 
-        if(pars->hrtf_vbap_gtableComp!= NULL)
-            free(pars->hrtf_vbap_gtableComp);
-        if(pars->hrtf_vbap_gtableIdx!= NULL)
-            free(pars->hrtf_vbap_gtableIdx);
+        vbap_destroy(&(pars->hVbap));
         if(pars->hrtf_fb!= NULL)
             free(pars->hrtf_fb);
         if(pars->hrtf_fb_mag!= NULL)
@@ -207,7 +165,7 @@ void ambi_dec_process
 {
     ambi_dec_data *pData = (ambi_dec_data*)(hAmbi);
     codecPars* pars = pData->pars;
-    int n, t, sample, ch, ear, i, band, orderBand, nSH_band, decIdx;
+    int n, t, ch, ear, i, band, orderBand, nSH_band, decIdx;
     int o[SH_ORDER+2];
     const float_complex calpha = cmplxf(1.0f,0.0f), cbeta = cmplxf(0.0f, 0.0f);
     
@@ -278,17 +236,7 @@ void ambi_dec_process
         }
         
         /* Apply time-frequency transform (TFT) */
-        for ( t=0; t< TIME_SLOTS; t++) {
-            for( ch=0; ch < MAX_NUM_SH_SIGNALS; ch++)
-                for ( sample=0; sample < HOP_SIZE; sample++)
-                    pData->tempHopFrameTD[ch][sample] = pData->SHFrameTD[ch][sample + t*HOP_SIZE];
-            afSTFTforward(pData->hSTFT, (float**)pData->tempHopFrameTD, (complexVector*)pData->STFTInputFrameTF[t]);
-        }
-        for(n=1; n<=SH_ORDER; n++)
-            for(band=0; band<HYBRID_BANDS; band++)
-                for( ch=0; ch < (n+1)*(n+1); ch++)
-                    for ( t=0; t<TIME_SLOTS; t++)
-                        pData->SHframeTF[n-1][band][ch*TIME_SLOTS + t] = cmplxf(pData->STFTInputFrameTF[t][ch].re[band], pData->STFTInputFrameTF[t][ch].im[band]);
+        afSTFTforward_frame(pData->hSTFT, pData->SHFrameTD, FRAME_SIZE, MAX_NUM_SH_SIGNALS, AFSTFT_BANDS_CH_TIME, (void*)pData->SHframeTF);
         
         /* Decode to loudspeaker set-up */
         memset(pData->outputframeTF, 0, HYBRID_BANDS*MAX_NUM_LOUDSPEAKERS*TIME_SLOTS*sizeof(float_complex));
@@ -299,13 +247,13 @@ void ambi_dec_process
             if(rE_WEIGHT[decIdx]){
                 cblas_cgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, nLoudspeakers, TIME_SLOTS, nSH_band, &calpha,
                             pars->M_dec_cmplx_maxrE[decIdx][orderBand-1], nSH_band,
-                            pData->SHframeTF[orderBand-1][band], TIME_SLOTS, &cbeta,
+                            pData->SHframeTF[band], TIME_SLOTS, &cbeta,
                             pData->outputframeTF[band], TIME_SLOTS);
             }
             else{
                 cblas_cgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, nLoudspeakers, TIME_SLOTS, nSH_band, &calpha,
                             pars->M_dec_cmplx[decIdx][orderBand-1], nSH_band,
-                            pData->SHframeTF[orderBand-1][band], TIME_SLOTS, &cbeta,
+                            pData->SHframeTF[band], TIME_SLOTS, &cbeta,
                             pData->outputframeTF[band], TIME_SLOTS);
             }
             for(i=0; i<nLoudspeakers; i++){
@@ -341,33 +289,14 @@ void ambi_dec_process
         }
         
         /* inverse-TFT */
-        for (band = 0; band < HYBRID_BANDS; band++) {
-            if(binauraliseLS){
-                for (ch = 0; ch < NUM_EARS; ch++) {
-                    for (t = 0; t < TIME_SLOTS; t++) {
-                        pData->STFTOutputFrameTF[t][ch].re[band] = crealf(pData->binframeTF[band][ch][t]);
-                        pData->STFTOutputFrameTF[t][ch].im[band] = cimagf(pData->binframeTF[band][ch][t]);
-                    }
-                }
-            }
-            else{
-                for (ch = 0; ch < nLoudspeakers; ch++) {
-                    for (t = 0; t < TIME_SLOTS; t++) {
-                        pData->STFTOutputFrameTF[t][ch].re[band] = crealf(pData->outputframeTF[band][ch][t]);
-                        pData->STFTOutputFrameTF[t][ch].im[band] = cimagf(pData->outputframeTF[band][ch][t]);
-                    }
-                }
-            }
-        }
-        for (t = 0; t < TIME_SLOTS; t++) {
-            afSTFTinverse(pData->hSTFT, pData->STFTOutputFrameTF[t], pData->tempHopFrameTD);
-            for (ch = 0; ch < MIN(binauraliseLS==1 ? NUM_EARS : nLoudspeakers, nOutputs); ch++)
-                for (sample = 0; sample < HOP_SIZE; sample++)
-                    outputs[ch][sample + t* HOP_SIZE] = pData->tempHopFrameTD[ch][sample];
-            for (; ch < nOutputs; ch++) /* fill remaining channels with zeros */
-                for (sample = 0; sample < HOP_SIZE; sample++)
-                    outputs[ch][sample + t* HOP_SIZE] = 0.0f;
-        }
+        if(binauraliseLS)
+            afSTFTinverse_frame(pData->hSTFT, (void*)pData->binframeTF, NUM_EARS, AFSTFT_BANDS_CH_TIME, FRAME_SIZE, pData->outputFrameTD);
+        else
+            afSTFTinverse_frame(pData->hSTFT, (void*)pData->outputframeTF, MAX_NUM_LOUDSPEAKERS, AFSTFT_BANDS_CH_TIME, FRAME_SIZE, pData->outputFrameTD);
+        for (ch = 0; ch < MIN(binauraliseLS==1 ? NUM_EARS : nLoudspeakers, nOutputs); ch++)
+            memcpy(outputs[ch], pData->outputFrameTD[ch], FRAME_SIZE * sizeof(float));
+        for (; ch < nOutputs; ch++) /* fill remaining channels with zeros */
+            memset(outputs[ch], 0, FRAME_SIZE * sizeof(float));
 #ifdef ENABLE_FADE_IN_OUT
         if(pData->reInitTFT || pData->reInitHRTFs)
             for(ch=0; ch < nOutputs; ch++)
@@ -135,7 +135,6 @@ void ambi_dec_initHRTFs
     ambi_dec_data *pData = (ambi_dec_data*)(hAmbi);
     codecPars* pars = pData->pars;
     int i, j, k;
-    float* hrtf_vbap_gtable;
     
     /* load sofa file or load default hrir data */
     if(!pData->useDefaultHRIRsFLAG && pars->sofa_filepath!=NULL){
@@ -179,29 +178,16 @@ void ambi_dec_initHRTFs
     }
     hrirlib_estimateITDs(pars->hrirs, pars->N_hrir_dirs, pars->hrir_len, pars->hrir_fs, &(pars->itds_s));
     
-    /* generate VBAP gain table for the hrir_dirs */
-    hrtf_vbap_gtable = NULL;
-    pars->hrtf_vbapTableRes[0] = 2; /* azimuth resolution in degrees */
-    pars->hrtf_vbapTableRes[1] = 5; /* elevation resolution in degrees */
-    generateVBAPgainTable3D(pars->hrir_dirs_deg, pars->N_hrir_dirs, pars->hrtf_vbapTableRes[0], pars->hrtf_vbapTableRes[1], 1, 0,
-                            &hrtf_vbap_gtable, &(pars->N_hrtf_vbap_gtable), &(pars->hrtf_nTriangles));
-    if(hrtf_vbap_gtable==NULL){
-        /* if generating vbap gain tabled failed, re-calculate with default HRIR set (which is known to triangulate correctly) */
+    /* generate the VBAP handle for the hrir_dirs */
+    vbap_destroy(&(pars->hVbap));
+    vbap_create(&(pars->hVbap), pars->hrir_dirs_deg, pars->N_hrir_dirs, 1, 0, &(pars->hrtf_nTriangles));
+    if(pars->hVbap==NULL){
+        /* if generating vbap handle failed, re-calculate with default HRIR set (which is known to triangulate correctly) */
         pData->useDefaultHRIRsFLAG = 1;
         ambi_dec_initHRTFs(hAmbi);
+        return;
     }
     
-    /* compress VBAP table (i.e. remove the zero elements) */
-    if(pars->hrtf_vbap_gtableComp!= NULL){
-        free(pars->hrtf_vbap_gtableComp);
-        pars->hrtf_vbap_gtableComp = NULL;
-    }
-    if(pars->hrtf_vbap_gtableIdx!= NULL){
-        free(pars->hrtf_vbap_gtableIdx);
-        pars->hrtf_vbap_gtableIdx = NULL;
-    }
-    compressVBAPgainTable3D(hrtf_vbap_gtable, pars->N_hrtf_vbap_gtable, pars->N_hrir_dirs, &(pars->hrtf_vbap_gtableComp), &(pars->hrtf_vbap_gtableIdx));
-    
     /* convert hrirs to filterbank coefficients */
     if(pars->hrtf_fb!= NULL){
         free(pars->hrtf_fb);
@@ -215,10 +201,6 @@ void ambi_dec_initHRTFs
     pars->hrtf_fb_mag = malloc(HYBRID_BANDS*NUM_EARS* (pars->N_hrir_dirs)*sizeof(float));
     for(i=0; i<HYBRID_BANDS*NUM_EARS* (pars->N_hrir_dirs); i++)
         pars->hrtf_fb_mag[i] = cabsf(pars->hrtf_fb[i]);
-    
-    /* clean-up */
-    if(hrtf_vbap_gtable!=NULL)
-        free(hrtf_vbap_gtable);
 }
 
 void ambi_dec_initTFT
@@ -227,61 +209,22 @@ void ambi_dec_initTFT
 )
 {
     ambi_dec_data *pData = (ambi_dec_data*)(hAmbi);
-    int t, ch;
 
-    /* free afSTFT + buffers, if already allocated */
-    if (pData->hSTFT != NULL){
-        afSTFTfree(pData->hSTFT);
-        pData->hSTFT = NULL;
-        if(pData->binauraliseLS){
-            for (t = 0; t<TIME_SLOTS; t++) {
-                for (ch = 0; ch< NUM_EARS; ch++) {
-                    free(pData->STFTOutputFrameTF[t][ch].re);
-                    free(pData->STFTOutputFrameTF[t][ch].im);
-                }
-            }
-            free2d((void**)pData->tempHopFrameTD, MAX(MAX_NUM_SH_SIGNALS, NUM_EARS));
-        }
-        else{
-            for (t = 0; t<TIME_SLOTS; t++) {
-                for (ch = 0; ch< pData->nLoudpkrs; ch++) {
-                    free(pData->STFTOutputFrameTF[t][ch].re);
-                    free(pData->STFTOutputFrameTF[t][ch].im);
-                }
-            }
-            free2d((void**)pData->tempHopFrameTD, MAX(MAX_NUM_SH_SIGNALS, pData->nLoudpkrs));
-        }
-        free2d((void**)pData->STFTOutputFrameTF, TIME_SLOTS);
-    }
+    /* allocate afSTFT for the maximum number of channels, if not already allocated */
+    if (pData->hSTFT == NULL)
+        afSTFTinit(&(pData->hSTFT), HOP_SIZE, MAX_NUM_SH_SIGNALS, MAX(NUM_EARS, MAX_NUM_LOUDSPEAKERS), 0, 1);
     
-    /* reallocate afSTFT + buffers */
-    if (pData->hSTFT == NULL){
-        if(pData->new_binauraliseLS){
-            afSTFTinit(&(pData->hSTFT), HOP_SIZE, MAX_NUM_SH_SIGNALS, NUM_EARS, 0, 1);
-            pData->STFTOutputFrameTF = (complexVector**)malloc2d(TIME_SLOTS, NUM_EARS, sizeof(complexVector));
-            for(t=0; t<TIME_SLOTS; t++) {
-                for(ch=0; ch< NUM_EARS; ch++) {
-                    pData->STFTOutputFrameTF[t][ch].re = (float*)calloc(HYBRID_BANDS, sizeof(float));
-                    pData->STFTOutputFrameTF[t][ch].im = (float*)calloc(HYBRID_BANDS, sizeof(float));
-                }
-            }
-            pData->tempHopFrameTD = (float**)malloc2d( MAX(MAX_NUM_SH_SIGNALS, NUM_EARS), HOP_SIZE, sizeof(float));
-            pData->nLoudpkrs = pData->new_nLoudpkrs;
-        }
-        else{
-            afSTFTinit(&(pData->hSTFT), HOP_SIZE, MAX_NUM_SH_SIGNALS, pData->new_nLoudpkrs, 0, 1);
-            pData->STFTOutputFrameTF = (complexVector**)malloc2d(TIME_SLOTS, pData->new_nLoudpkrs, sizeof(complexVector));
-            for(t=0; t<TIME_SLOTS; t++) {
-                for(ch=0; ch< pData->new_nLoudpkrs; ch++) {
-                    pData->STFTOutputFrameTF[t][ch].re = (float*)calloc(HYBRID_BANDS, sizeof(float));
-                    pData->STFTOutputFrameTF[t][ch].im = (float*)calloc(HYBRID_BANDS, sizeof(float));
-                }
-            }
-            pData->tempHopFrameTD = (float**)malloc2d( MAX(MAX_NUM_SH_SIGNALS, pData->new_nLoudpkrs), HOP_SIZE, sizeof(float));
-            pData->nLoudpkrs = pData->new_nLoudpkrs;
-        }
-        pData->binauraliseLS = pData->new_binauraliseLS;
-    }
+    /* change the number of output channels in-place. When switching between the binaural and loudspeaker modes, the
+     * output channels are first all deactivated, so that their overlap-add tails (which belong to the other mode) are
+     * cleared, rather than rendered on the wrong outputs */
+    if(pData->new_binauraliseLS != pData->binauraliseLS)
+        afSTFTchannelChange(pData->hSTFT, MAX_NUM_SH_SIGNALS, 0);
+    if(pData->new_binauraliseLS)
+        afSTFTchannelChange(pData->hSTFT, MAX_NUM_SH_SIGNALS, NUM_EARS);
+    else
+        afSTFTchannelChange(pData->hSTFT, MAX_NUM_SH_SIGNALS, pData->new_nLoudpkrs);
+    pData->nLoudpkrs = pData->new_nLoudpkrs;
+    pData->binauraliseLS = pData->new_binauraliseLS;
 }
 
 void ambi_dec_interpHRTFs
@@ -295,27 +238,24 @@ void ambi_dec_interpHRTFs
     ambi_dec_data *pData = (ambi_dec_data*)(hAmbi);
     codecPars* pars = pData->pars;
     int i, band;
-    int aziIndex, elevIndex, N_azi, idx3d;
+    int idx3[3];
     float_complex ipd;
-    float aziRes, elevRes, weights[1][3], itds3[3],  itdInterp[1];
+    float gains_sum, weights[1][3], itds3[3],  itdInterp[1];
     float magnitudes3[HYBRID_BANDS][3][NUM_EARS], magInterp[HYBRID_BANDS][NUM_EARS];
 
-    /* find closest pre-computed VBAP direction */
-    aziRes = (float)pars->hrtf_vbapTableRes[0];
-    elevRes = (float)pars->hrtf_vbapTableRes[1];
-    N_azi = (int)(360.0f / aziRes + 0.5f) + 1;
-    aziIndex = (int)(matlab_fmodf(azimuth_deg + 180.0f, 360.0f) / aziRes + 0.5f);
-    elevIndex = (int)((elevation_deg + 90.0f) / elevRes + 0.5f);
-    idx3d = elevIndex * N_azi + aziIndex;
-    for (i = 0; i < 3; i++)
-        weights[0][i] = pars->hrtf_vbap_gtableComp[idx3d*3 + i];
+    /* find the VBAP gains for the exact direction, and amplitude normalise them */
+    vbap_query(pars->hVbap, azimuth_deg, elevation_deg, idx3, weights[0]);
+    gains_sum = weights[0][0] + weights[0][1] + weights[0][2];
+    if(gains_sum > 2.23e-13f)
+        for (i = 0; i < 3; i++)
+            weights[0][i] /= gains_sum;
     
     /* retrieve the 3 itds and hrtf magnitudes */
     for (i = 0; i < 3; i++) {
-        itds3[i] = pars->itds_s[pars->hrtf_vbap_gtableIdx[idx3d*3+i]];
+        itds3[i] = pars->itds_s[idx3[i]];
         for (band = 0; band < HYBRID_BANDS; band++) {
-            magnitudes3[band][i][0] = pars->hrtf_fb_mag[band*NUM_EARS*(pars->N_hrir_dirs) + 0*(pars->N_hrir_dirs) + pars->hrtf_vbap_gtableIdx[idx3d*3+i]];
-            magnitudes3[band][i][1] = pars->hrtf_fb_mag[band*NUM_EARS*(pars->N_hrir_dirs) + 1*(pars->N_hrir_dirs) + pars->hrtf_vbap_gtableIdx[idx3d*3+i]];
+            magnitudes3[band][i][0] = pars->hrtf_fb_mag[band*NUM_EARS*(pars->N_hrir_dirs) + 0*(pars->N_hrir_dirs) + idx3[i]];
+            magnitudes3[band][i][1] = pars->hrtf_fb_mag[band*NUM_EARS*(pars->N_hrir_dirs) + 1*(pars->N_hrir_dirs) + idx3[i]];
         }
     }
     
@@ -94,12 +94,9 @@ typedef struct _codecPars
     int hrir_len;                                             /* length of the HRIRs, this can be truncated, see "saf_sofa_reader.h" */
     int hrir_fs;                                              /* sampling rate of the HRIRs, should ideally match the host sampling rate, although not required */
     
-    /* vbap gain table for panning the HRIRs */
-    int hrtf_vbapTableRes[2];                                 /* [azi elev] step sizes in degrees */
-    int N_hrtf_vbap_gtable;                                   /* number of interpolation directions */
+    /* vbap handle for panning the HRIRs */
     int hrtf_nTriangles;                                      /* number of triangle groups after triangulation */
-    int* hrtf_vbap_gtableIdx;                                 /* N_hrtf_vbap_gtable x 3 */
-    float* hrtf_vbap_gtableComp;                              /* N_hrtf_vbap_gtable x 3 */
+    void* hVbap;                                              /* VBAP over the HRIR directions, queried per direction */
     
     /* hrir filterbank coefficients */
     float* itds_s;                                            /* interaural-time differences for each HRIR (in seconds); N_hrirs x 1 */
@@ -112,15 +109,13 @@ typedef struct _codecPars
 typedef struct _ambi_dec
 {
     /* audio buffers + afSTFT time-frequency transform handle */
-    float SHFrameTD[MAX_NUM_SH_SIGNALS][FRAME_SIZE]; 
-    float_complex* SHframeTF[SH_ORDER][HYBRID_BANDS];         /* Frame per order; SH_ORDER x nBands x [ FLAT: (order+1)^2 x TIME_SLOTS ] */
+    float** SHFrameTD;                                        /* MAX_NUM_SH_SIGNALS x FRAME_SIZE */
+    float** outputFrameTD;                                    /* MAX(MAX_NUM_LOUDSPEAKERS, NUM_EARS) x FRAME_SIZE */
+    float_complex SHframeTF[HYBRID_BANDS][MAX_NUM_SH_SIGNALS][TIME_SLOTS]; /* the first (order+1)^2 rows are used for lower orders */
     float_complex outputframeTF[HYBRID_BANDS][MAX_NUM_LOUDSPEAKERS][TIME_SLOTS];
     float_complex binframeTF[HYBRID_BANDS][NUM_EARS][TIME_SLOTS];
-    complexVector** STFTInputFrameTF;
-    complexVector** STFTOutputFrameTF;
     void* hSTFT;                                              /* afSTFT handle */
     int afSTFTdelay;                                          /* for host delay compensation */
-    float** tempHopFrameTD;                                   /* temporary multi-channel time-domain buffer of size "HOP_SIZE". */
     int fs;                                                   /* host sampling rate */
     float freqVector[HYBRID_BANDS];                           /* frequency vector for time-frequency transform, in Hz */
     
@@ -162,7 +157,7 @@ typedef struct _ambi_dec
 /* Note: take care to initalise time-frequency transform "ambi_dec_initTFT" first */
 void ambi_dec_initCodec(void* const hAmbi);                   /* ambi_dec handle */
 
-/* Intialises the hrtf filterbank coefficients and vbap look-up tables */
+/* Intialises the hrtf filterbank coefficients and vbap handle */
 /* Note: take care to initalise time-frequency transform "ambi_dec_initTFT" first */
 void ambi_dec_initHRTFs(void* const hAmbi);                   /* ambi_dec handle */
 
@@ -41,7 +41,7 @@ void array2sh_create
     array2sh_data* pData = (array2sh_data*)malloc(sizeof(array2sh_data));
     if (pData == NULL) { return;/*error*/ }
     *phA2sh = (void*)pData;
-    int band, t, ch;
+    int band;
      
     /* defualt parameters */
     array2sh_createArray(&(pData->arraySpecs)); 
@@ -58,15 +58,8 @@ void array2sh_create
      
     /* time-frequency transform + buffers */
     pData->hSTFT = NULL;
-    pData->STFTInputFrameTF=NULL;
-    pData->STFTOutputFrameTF = (complexVector**)malloc2d(TIME_SLOTS, NUM_SH_SIGNALS, sizeof(complexVector));
-    for(t=0; t<TIME_SLOTS; t++) {
-        for(ch=0; ch< NUM_SH_SIGNALS; ch++) {
-            pData->STFTOutputFrameTF[t][ch].re = (float*)calloc(HYBRID_BANDS, sizeof(float));
-            pData->STFTOutputFrameTF[t][ch].im = (float*)calloc(HYBRID_BANDS, sizeof(float));
-        }
-    }
-    pData->tempHopFrameTD = NULL;
+    pData->inputFrameTD = (float**)malloc2d(MAX_NUM_SENSORS, FRAME_SIZE, sizeof(float));
+    pData->SHframeTD = (float**)malloc2d(NUM_SH_SIGNALS, FRAME_SIZE, sizeof(float));
     for(band=0; band <HYBRID_BANDS; band++)
         pData->freqVector[band] =  (float)__afCenterFreq48e3[band];
     pData->reinitTFTFLAG = 1;
@@ -79,6 +72,12 @@ void array2sh_create
     pData->disp_freqVector = (float*)malloc((HYBRID_BANDS-1)*sizeof(float));
     
     pData->recalcEvalFLAG = 1;
+    
+    /* caches */
+    memset(&(pData->bN_key), 0, sizeof(modalCoeffsKey));
+    memset(&(pData->H_array_key), 0, sizeof(modalCoeffsKey));
+    pData->bN_key.order = pData->H_array_key.order = -1; /* i.e. empty */
+    pData->H_array = NULL;
 }
 
 void array2sh_destroy
@@ -87,37 +86,20 @@ void array2sh_destroy
 )
 {
     array2sh_data *pData = (array2sh_data*)(*phM2sh);
-    arrayPars* arraySpecs = (arrayPars*)(pData->arraySpecs);
-    int t, ch;
 
     if (pData != NULL) {
         /* TFT stuff */
-        if (pData->hSTFT != NULL) {
+        if (pData->hSTFT != NULL)
             afSTFTfree(pData->hSTFT);
-            if(pData->STFTInputFrameTF!=NULL){
-                for (t = 0; t<TIME_SLOTS; t++) {
-                    for (ch = 0; ch< arraySpecs->Q; ch++) {
-                        free(pData->STFTInputFrameTF[t][ch].re);
-                        free(pData->STFTInputFrameTF[t][ch].im);
-                    }
-                }
-            }
-            free2d((void**)pData->STFTInputFrameTF, TIME_SLOTS);
-            free2d((void**)pData->tempHopFrameTD, arraySpecs->Q);
-        }
-        for (t = 0; t<TIME_SLOTS; t++) {
-            for(ch=0; ch< NUM_SH_SIGNALS; ch++) {
-                free(pData->STFTOutputFrameTF[t][ch].re);
-                free(pData->STFTOutputFrameTF[t][ch].im);
-            }
-        }
-        free2d((void**)pData->STFTOutputFrameTF, TIME_SLOTS);
+        free2d((void**)pData->inputFrameTD, MAX_NUM_SENSORS);
+        free2d((void**)pData->SHframeTD, NUM_SH_SIGNALS);
         array2sh_destroyArray(&(pData->arraySpecs));
         
         /* Display stuff */
         free2d((void**)pData->bN_modal_dB, HYBRID_BANDS-1);
         free2d((void**)pData->bN_inv_dB, HYBRID_BANDS-1);
         free(pData->disp_freqVector);
+        free(pData->H_array);
         
         free(pData);
         pData = NULL;
@@ -160,7 +142,7 @@ void array2sh_process
 {
     array2sh_data *pData = (array2sh_data*)(hA2sh);
     arrayPars* arraySpecs = (arrayPars*)(pData->arraySpecs);
-    int n, t, sample, ch, i, band, Q;
+    int n, ch, i, band, Q, nActiveBands;
     int o[SH_ORDER+2];
     const float_complex calpha = cmplxf(1.0f,0.0f), cbeta = cmplxf(0.0f, 0.0f);
     CH_ORDER chOrdering;
@@ -203,21 +185,7 @@ void array2sh_process
             memset(pData->inputFrameTD[i], 0, FRAME_SIZE * sizeof(float));
         
         /* Apply time-frequency transform (TFT) */
-        for ( t=0; t< TIME_SLOTS; t++) {
-            for( ch=0; ch < Q; ch++)
-                for ( sample=0; sample < HOP_SIZE; sample++)
-                    pData->tempHopFrameTD[ch][sample] = pData->inputFrameTD[ch][sample + t*HOP_SIZE];
-            afSTFTforward(pData->hSTFT, (float**)pData->tempHopFrameTD, (complexVector*)pData->STFTInputFrameTF[t]);
-        }
-        for(band=0; band<HYBRID_BANDS; band++){
-            if(pData->freqVector[band] < maxFreq){
-                for( ch=0; ch < Q; ch++)
-                    for ( t=0; t<TIME_SLOTS; t++)
-                        pData->inputframeTF[band][ch][t] = cmplxf(pData->STFTInputFrameTF[t][ch].re[band], pData->STFTInputFrameTF[t][ch].im[band]);
-                for(; ch < MAX_NUM_SENSORS; ch++)
-                    memset(pData->inputframeTF[band][ch], 0, TIME_SLOTS*sizeof(float_complex));
-            }
-        }
+        afSTFTforward_frame(pData->hSTFT, pData->inputFrameTD, FRAME_SIZE, MAX_NUM_SENSORS, AFSTFT_BANDS_CH_TIME, (void*)pData->inputframeTF);
         
         /* Apply spherical harmonic transform */
         for(band=0; band<HYBRID_BANDS; band++){
@@ -229,34 +197,17 @@ void array2sh_process
             }
         }
         
-        /* inverse-TFT */
-        for (band = 0; band < HYBRID_BANDS; band++) {
-            if(pData->freqVector[band] < maxFreq){
-                for (ch = 0; ch < NUM_SH_SIGNALS; ch++) {
-                    for (t = 0; t < TIME_SLOTS; t++) {
-                        pData->STFTOutputFrameTF[t][ch].re[band] = crealf(pData->SHframeTF[band][ch][t]);
-                        pData->STFTOutputFrameTF[t][ch].im[band] = cimagf(pData->SHframeTF[band][ch][t]);
-                    }
-                }
-            }
-            else{
-                for (ch = 0; ch < NUM_SH_SIGNALS; ch++) {
-                    for (t = 0; t < TIME_SLOTS; t++) {
-                        pData->STFTOutputFrameTF[t][ch].re[band] = 0.0f;
-                        pData->STFTOutputFrameTF[t][ch].im[band] = 0.0f;
-                    }
-                }
-            }
-        }
-        for (t = 0; t < TIME_SLOTS; t++) {
-            afSTFTinverse(pData->hSTFT, pData->STFTOutputFrameTF[t], pData->tempHopFrameTD);
-            for (ch = 0; ch < MIN(NUM_SH_SIGNALS, nOutputs); ch++)
-                for (sample = 0; sample < HOP_SIZE; sample++)
-                    outputs[ch][sample + t* HOP_SIZE] = pData->tempHopFrameTD[ch][sample] * gain_lin;
-            for (; ch < nOutputs; ch++)
-                for (sample = 0; sample < HOP_SIZE; sample++)
-                    outputs[ch][sample + t* HOP_SIZE] = 0.0f;
-        }
+        /* inverse-TFT (the bands above maxFreq are declared inactive, rather than being cleared) */
+        for (nActiveBands = 0; nActiveBands < HYBRID_BANDS; nActiveBands++)
+            if(pData->freqVector[nActiveBands] >= maxFreq)
+                break;
+        afSTFTsetActiveBands(pData->hSTFT, -1, 0, nActiveBands);
+        afSTFTinverse_frame(pData->hSTFT, (void*)pData->SHframeTF, NUM_SH_SIGNALS, AFSTFT_BANDS_CH_TIME, FRAME_SIZE, pData->SHframeTD);
+        for (ch = 0; ch < MIN(NUM_SH_SIGNALS, nOutputs); ch++)
+            for (i = 0; i < FRAME_SIZE; i++)
+                outputs[ch][i] = pData->SHframeTD[ch][i] * gain_lin;
+        for (; ch < nOutputs; ch++)
+            memset(outputs[ch], 0, FRAME_SIZE * sizeof(float));
         
         /* apply normalisation scheme */
         switch(norm){
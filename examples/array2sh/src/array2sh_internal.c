@@ -33,153 +33,42 @@
 
 #include "array2sh_internal.h"
 
-static long factorial(int n)
-{
-    if (n == 0)
-        return 1;
-    else
-        return(n * factorial(n-1));
-}
-
 static double_complex bessel_Hl2(int l, double z){
     double_complex Hl2;
-#ifdef __APPLE__
+#ifndef _WIN32
     Hl2 = cmplx(jn(l,z), - yn(l,z));
 #else
 	Hl2 = cmplx(_jn(l, z), -_yn(l, z));
 #endif
     return Hl2;
 }
-
-/* Spherical Bessel of the first kind j_l, l=-1..8 */
-static double bessel_jl(int l, double z)
-{
-    double jl;
-    z = MAX(z, 2.23e-13);
 
-    /* if z << l, then an approximation of jl is more suitable, for higher values this approach breaks down */
-    if (z < l/(z+2.23e-13)){
-        if (l == -1){
-            jl = sqrt(2.0/(M_PI*z))*cos(z);
-            jl = jl*sqrt(M_PI/(2.0*z));
-        }
-        else {
-            jl = pow(z,l) / ((double)factorial(2*l+1)/ (pow(2.0,l) * (double)factorial(l)));
-        }
-    }
-    else {
-        /* for higher 'z' values, the exact analytical solution is a better idea.
-           (the insufficient numerical precision breaks this approach at lower 'z' values) */
-        switch (l){
-            case -1:
-                /* reverts to negative half order cylindrical bessel J_l */
-                jl = sqrt(2.0/(M_PI*z))*cos(z);
-                jl = jl*sqrt(M_PI/(2.0*z));
-                break;
-            case 0:
-                jl = sin(z)/z;
-                break;
-            case 1:
-                jl = (sin(z) - z*cos(z))/pow(z,2.0);
-                break;
-            case 2:
-                jl = -(pow(z,2.0)*sin(z) - 3.0*sin(z) + 3.0*z*cos(z))/pow(z,3.0);
-                break;
-            case 3:
-                jl = (15.0*sin(z) + pow(z,3.0)*cos(z) - 6.0*pow(z,2.0)*sin(z) - 15.0*z*cos(z))/pow(z,4.0);
-                break;
-            case 4:
-                jl = (105.0*sin(z) + 10.0*pow(z,3.0)*cos(z) - 45.0*pow(z,2.0)*sin(z) + pow(z,4.0)*sin(z) -
-                      105.0*z*cos(z))/pow(z,5.0);
-                break;
-            case 5:
-                jl = (945.0*sin(z) + 105.0*pow(z,3.0)*cos(z) - pow(z,5.0)*cos(z) - 420.0*pow(z,2.0)*sin(z) +
-                      15.0*pow(z,4.0)*sin(z) - 945.0*z*cos(z))/pow(z,6.0);
-                break;
-            case 6:
-                jl = -(21.0*pow(z,5.0)*cos(z) - 1260.0*pow(z,3.0)*cos(z) - 10395.0*sin(z) + 4725.0*pow(z,2.0)*sin(z)
-                       - 210.0*pow(z,4.0)*sin(z) + pow(z,6.0)*sin(z) + 10395.0*z*cos(z))/pow(z,7.0);
-                break;
-            case 7:
-                jl = (135135.0*sin(z) + 17325.0*pow(z,3.0)*cos(z) - 378.0*pow(z,5.0)*cos(z) + pow(z,7.0)*cos(z) -
-                      62370.0*pow(z,2.0)*sin(z) + 3150.0*pow(z,4.0)*sin(z) - 28.0*pow(z,6.0)*sin(z) -
-                      135135.0*z*cos(z))/pow(z,8.0);
-                break;
-            case 8:
-                jl = (2027025.0*sin(z) + 270270.0*pow(z,3.0)*cos(z) - 6930.0*pow(z,5.0)*cos(z) + 36.0*pow(z,7.0)*cos(z) -
-                      945945.0*pow(z,2.0)*sin(z) + 51975.0*pow(z,4.0)*sin(z) - 630.0*pow(z,6.0)*sin(z) +
-                      pow(z,8.0)*sin(z) - 2027025.0*z*cos(z))/pow(z,9.0);
-                break;
-            default:
-                jl = 2.23e-13;
-                break;
-        }
-    }
-    return jl;
-}
-
-/* Spherical Bessel of the third kind (Hankel of the second kind) h_l^(2), l=-1..8 */
-static double_complex bessel_hl2(int l, double z)
+/* fills in the cache key for the current configuration. The sensor directions are only included if 'includeSensors'
+ * is 1, as the modal coefficients do not depend on them */
+static void array2sh_getModalCoeffsKey
+(
+    void* const hA2sh,
+    int order,
+    int includeSensors,
+    modalCoeffsKey* key
+)
 {
-    double_complex hl_2;
-    z = MAX(z, 2.3e-13);
-    switch (l){
-        case -1:
-            hl_2 = cmplx(sqrt(2.0/(M_PI*z))*cos(z), -sqrt(2.0/(M_PI*z))*sin(z));
-            hl_2 = crmul(hl_2, sqrt(M_PI/(2.0*z)));
-            break;
-        case 0:
-            hl_2 = ccmul(cexp(cmplx(0.0, -z)), cmplx(0.0, 1.0));
-            hl_2 = ccdiv(hl_2, cmplx(z, 0.0));
-            break;
-        case 1:
-            hl_2 = ccmul(cexp(cmplx(0.0, -z)), (cmplx(z, -1.0)));
-            hl_2 = crmul(hl_2, -1.0);
-            hl_2 = ccdiv(hl_2, cmplx(pow(z, 2.0), 0.0));
-            break;
-        case 2:
-            hl_2 = ccmul(cexp(cmplx(0.0,-z)), (cmplx(3.0*z, pow(z,2.0) - 3.0)));
-            hl_2 = crmul(hl_2, -1.0);
-            hl_2 = ccdiv(hl_2, cmplx(pow(z, 3.0), 0.0));
-            break;
-        case 3:
-            hl_2 = ccmul(cexp(cmplx(0.0,-z)), (cmplx( -pow(z,3.0) + 15.0*z, pow(z,2.0)*6.0 - 15.0)));
-            hl_2 = crmul(hl_2, -1.0);
-            hl_2 = ccdiv(hl_2, cmplx(pow(z, 4.0), 0.0));
-            break;
-        case 4:
-            hl_2 = ccmul(cexp(cmplx(0.0,-z)), (cmplx(10.0*pow(z,3.0) - 105.0*z, pow(z,4.0)  - pow(z,2.0)*45.0 + 105.0)));
-            hl_2 = ccdiv(hl_2, cmplx(pow(z, 5.0), 0.0));
-            break;
-        case 5:
-            hl_2 = ccmul(cexp(cmplx(0.0,-z)), (cmplx(pow(z,5.0) - 105.0*pow(z,3.0) + 945.0*z, -pow(z,4.0)*15.0 +
-                                                     pow(z,2.0)*420.0 - 945.0)));
-            hl_2 = crmul(hl_2, -1.0);
-            hl_2 = ccdiv(hl_2, cmplx(pow(z, 6.0), 0.0));
-            break;
-        case 6:
-            hl_2 = ccmul(cexp(cmplx(0.0, -z)), (cmplx(21.0*pow(z, 5.0) - 1260.0*pow(z, 3.0) + 10395.0*z, pow(z, 6.0) -
-                                                      pow(z, 4.0)*210.0 + pow(z, 2.0)*4725.0 - 10395.0)));
-            hl_2 = crmul(hl_2, -1.0);
-            hl_2 = ccdiv(hl_2, cmplx(pow(z, 7.0), 0.0));
-            break;
-        case 7:
-            hl_2 = ccmul(cexp(cmplx(0.0, -z)), (cmplx(-pow(z, 7.0) + 378.0*pow(z, 5.0) - 17325.0*pow(z, 3.0) + 135135.0*z,
-                                                      pow(z, 6.0)*28.0 - pow(z, 4.0)*3150.0 + pow(z, 2.0)*62370.0 - 135135.0)));
-            hl_2 = crmul(hl_2, -1.0);
-            hl_2 = ccdiv(hl_2, cmplx(pow(z, 8.0), 0.0));
-            break;
-        case 8:
-            hl_2 = ccmul(cexp(cmplx(0.0,-z)), (cmplx(36.0*pow(z,7.0) - 6930.0*pow(z,5.0) + 270270.0*pow(z,3.0) - 2027025.0*z,
-                                                     pow(z,8.0) - pow(z,6.0)*630.0  + pow(z,4.0)*51975.0 - pow(z,2.0)*945945.0
-                                                     + 2027025.0)));
-            hl_2 = ccdiv(hl_2, cmplx(pow(z, 9.0), 0.0));
-            break;
-        default:
-            hl_2 = cmplx(2.23e-13, 0.0);
-            break;
+    array2sh_data *pData = (array2sh_data*)(hA2sh);
+    arrayPars* arraySpecs = (arrayPars*)(pData->arraySpecs);
+    
+    memset(key, 0, sizeof(modalCoeffsKey)); /* so that memcmp may be used for comparisons */
+    key->order = order;
+    key->arrayType = arraySpecs->arrayType;
+    key->weightType = arraySpecs->weightType;
+    key->r = arraySpecs->r;
+    key->R = arraySpecs->R;
+    key->admittance = arraySpecs->admittance;
+    key->c = pData->c;
+    memcpy(key->freqVector, pData->freqVector, HYBRID_BANDS*sizeof(float));
+    if(includeSensors){
+        key->Q = arraySpecs->Q;
+        memcpy(key->sensorCoords_rad, arraySpecs->sensorCoords_rad, arraySpecs->Q*2*sizeof(float));
     }
-    return hl_2;
 }
 
 static void array2sh_calculate_bN
@@ -190,11 +79,13 @@ static void array2sh_calculate_bN
 {
     array2sh_data *pData = (array2sh_data*)(hA2sh);
     arrayPars* arraySpecs = (arrayPars*)(pData->arraySpecs);
-    int band, n;
+    int band, n, i, maxN;
     double kr[HYBRID_BANDS], kR[HYBRID_BANDS];
-    double sph2cyl_kR, admittance;
+    double admittance;
     admittance = arraySpecs->admittance;
     double_complex jl2, hl2, Jl2, Jl2_imag;
+    double* jn_kR, *jnprime_kR;
+    double_complex* hn2_kR, *hn2prime_kR, *hn2_kr;
     
     for(band=0; band<HYBRID_BANDS; band++){
         kr[band] = 2.0*M_PI*(double)freqVector[band] * (double)arraySpecs->r / (double)pData->c;
@@ -208,7 +99,7 @@ static void array2sh_calculate_bN
                     for(band=0; band<HYBRID_BANDS; band++){
                         for(n=0; n < SH_ORDER+1; n++){
                             if (n==0){
-#ifdef __APPLE__
+#ifndef _WIN32
                                 Jl2 = cmplx(-jn(1,kR[band])-jn(1,kR[band]),0.0);
                                 Jl2_imag = cmplx(-jn(1,kR[band])- jn(1,kR[band]), -(-yn(1,kR[band]) - yn(1,kR[band])));
                                 pData->bN[band][n] = crmul(cpow(cmplx(0.0,1.0),cmplx((double)n,0.0)),4.0*M_PI);
@@ -221,7 +112,7 @@ static void array2sh_calculate_bN
 #endif
                             }
                             else {
-#ifdef __APPLE__
+#ifndef _WIN32
                                 Jl2 = cmplx(jn(n-1,kR[band])-jn(n+1,kR[band]),0.0);
                                 Jl2_imag = cmplx(jn(n-1,kR[band])- jn(n+1,kR[band]), -(yn(n-1,kR[band]) - yn(n+1,kR[band])));
                                 pData->bN[band][n] = crmul(cpow(cmplx(0.0,1.0),cmplx((double)n,0.0)),4.0*M_PI);
@@ -240,7 +131,7 @@ static void array2sh_calculate_bN
                 case WEIGHT_OPEN_OMNI:
                     for(band=0; band<HYBRID_BANDS; band++){
                         for(n=0; n < SH_ORDER+1; n++){
-#ifdef __APPLE__
+#ifndef _WIN32
                             pData->bN[band][n] = crmul(cpow(cmplx(0.0,1.0),cmplx((double)n,0.0)), 4.0 * M_PI * jn(n, kr[band]));
 #else
                             pData->bN[band][n] = crmul(cpow(cmplx(0.0,1.0),cmplx((double)n,0.0)), 4.0 * M_PI * _jn(n, kr[band]));
@@ -260,45 +151,54 @@ static void array2sh_calculate_bN
             break;
             
         case ARRAY_SPHERICAL:
+            /* the spherical Bessel/Hankel functions are evaluated for all bands at once, by the vectorised engine of
+             * saf_sh (see sphModalCoeffs) */
             switch (arraySpecs->weightType){
                 case WEIGHT_OPEN_OMNI:
-                    for(band=0; band<HYBRID_BANDS; band++){
-                        for(n=0; n < SH_ORDER+1; n++){
-							pData->bN[band][n] = crmul(cpow(cmplx(0.0, 1.0), cmplx((double)n, 0.0)), 4.0*M_PI* bessel_jl(n, kr[band]));
-                        }
-                    }
+                    sphModalCoeffs(SH_ORDER, kr, HYBRID_BANDS, ARRAY_CONSTRUCTION_OPEN, 1.0, (double_complex*)pData->bN);
                     break;
                     
                 case WEIGHT_OPEN_CARD:
-                    for(band=0; band<HYBRID_BANDS; band++){
-                        for(n=0; n < SH_ORDER+1; n++){
-							pData->bN[band][n] = crmul(cpow(cmplx(0.0, 1.0), cmplx((double)n, 0.0)), 4.0*M_PI);
-							pData->bN[band][n] = ccmul(pData->bN[band][n], ccsub(cmplx(bessel_jl(n, kr[band]),0.0), crmul(cmplx(0.0f, 0.5), (bessel_jl(n - 1, kr[band]) - bessel_jl(n + 1, kr[band]) - 1.0 / kr[band] * bessel_jl(n, kr[band]))) ) );
-                        }
-                    }
+                    /* 1i^n * (jn - 1i*jnprime), i.e. twice that of the (0.5*omni + 0.5*dipole) directional array */
+                    sphModalCoeffs(SH_ORDER, kr, HYBRID_BANDS, ARRAY_CONSTRUCTION_DIRECTIONAL, 0.5, (double_complex*)pData->bN);
+                    for(band=0; band<HYBRID_BANDS; band++)
+                        for(n=0; n < SH_ORDER+1; n++)
+                            pData->bN[band][n] = crmul(pData->bN[band][n], 2.0);
                     break;
                     
                 case WEIGHT_OPEN_DIPOLE:
-                    for(band=0; band<HYBRID_BANDS; band++){
-                        for(n=0; n < SH_ORDER+1; n++){
-							pData->bN[band][n] = crmul(cpow(cmplx(0.0, 1.0), cmplx((double)n, 0.0)), 4.0*M_PI);
-							pData->bN[band][n] = ccmul(pData->bN[band][n],  crmul( crmul(cmplx(0.0f, 0.5), -1.0), (bessel_jl(n - 1, kr[band]) - bessel_jl(n + 1, kr[band]) - 1.0 / kr[band] * bessel_jl(n, kr[band])) ) );
-                        }
-                    }
+                    sphModalCoeffs(SH_ORDER, kr, HYBRID_BANDS, ARRAY_CONSTRUCTION_DIRECTIONAL, 0.0, (double_complex*)pData->bN);
                     break;
                     
                 case WEIGHT_RIGID:
+                    /* the sensors may lie above the baffle (r>=R), which may have a non-zero admittance, and so:
+                     * 1i^n * (jn(kr) - (jnprime(kR)+1i*admittance*jn(kR))/(hn2prime(kR)+1i*admittance*hn2(kR)) * hn2(kr)) */
+                    jn_kR = malloc(HYBRID_BANDS*(SH_ORDER+1)*sizeof(double));
+                    jnprime_kR = malloc(HYBRID_BANDS*(SH_ORDER+1)*sizeof(double));
+                    hn2_kR = malloc(HYBRID_BANDS*(SH_ORDER+1)*sizeof(double_complex));
+                    hn2prime_kR = malloc(HYBRID_BANDS*(SH_ORDER+1)*sizeof(double_complex));
+                    hn2_kr = malloc(HYBRID_BANDS*(SH_ORDER+1)*sizeof(double_complex));
+                    bessel_jn(SH_ORDER, kR, HYBRID_BANDS, &maxN, jn_kR, jnprime_kR);
+                    hankel_hn2(SH_ORDER, kR, HYBRID_BANDS, &maxN, hn2_kR, hn2prime_kR);
+                    hankel_hn2(SH_ORDER, kr, HYBRID_BANDS, &maxN, hn2_kr, NULL);
                     for(band=0; band<HYBRID_BANDS; band++){
                         for(n=0; n < SH_ORDER+1; n++){
-							sph2cyl_kR = MAX(sqrt(M_PI / (2.0*kR[band])), 2.23e-13);
-							jl2 = ccadd(cmplx((bessel_jl(n - 1, kR[band]) - bessel_jl(n + 1, kR[band])) / sph2cyl_kR, 0.0), crmul((ccsub(cmplx(0.0, 2.0*admittance), cmplx(1.0 / kR[band],0.0))), bessel_jl(n, kR[band]) / sph2cyl_kR) );
-							hl2 = ccdiv(ccsub(bessel_hl2(n - 1, kR[band]), bessel_hl2(n + 1, kR[band])), cmplx(sph2cyl_kR,0.0));
-							hl2 = ccadd( hl2, ccmul((ccsub(cmplx(0.0, 2.0*admittance), cmplx( 1.0 / kR[band],0.0))), ccdiv(bessel_hl2(n, kR[band]), cmplx(sph2cyl_kR, 0.0))) );
-
-							pData->bN[band][n] = crmul(cpow(cmplx(0.0, 1.0), cmplx((double)n, 0.0)), 4.0*M_PI);
-							pData->bN[band][n] = ccmul(pData->bN[band][n], (ccsub(cmplx(bessel_jl(n, kr[band]),0.0), ccmul(ccdiv(jl2, hl2), bessel_hl2(n, kr[band])))));
+                            i = band*(SH_ORDER+1)+n;
+                            if(kR[band] <= 1e-20)
+                                pData->bN[band][n] = cmplx(n==0 ? 4.0*M_PI : 0.0, 0.0);
+                            else{
+                                jl2 = cmplx(jnprime_kR[i], admittance*jn_kR[i]);
+                                hl2 = ccadd(hn2prime_kR[i], ccmul(cmplx(0.0, admittance), hn2_kR[i]));
+                                pData->bN[band][n] = crmul(cpow(cmplx(0.0, 1.0), cmplx((double)n, 0.0)), 4.0*M_PI);
+                                pData->bN[band][n] = ccmul(pData->bN[band][n], ccsub(cmplx(creal(hn2_kr[i]), 0.0), ccmul(ccdiv(jl2, hl2), hn2_kr[i]))); /* jn = real(hn2) */
+                            }
                         }
                     }
+                    free(jn_kR);
+                    free(jnprime_kR);
+                    free(hn2_kR);
+                    free(hn2prime_kR);
+                    free(hn2_kr);
                     break;
             }
             break;
@@ -382,33 +282,13 @@ void array2sh_initTFT
 {
     array2sh_data *pData = (array2sh_data*)(hA2sh);
     arrayPars* arraySpecs = (arrayPars*)(pData->arraySpecs);
-    int t, ch;
     
-    if (pData->hSTFT != NULL){
-        afSTFTfree(pData->hSTFT);
-        pData->hSTFT = NULL;
-        for (t = 0; t<TIME_SLOTS; t++) {
-            for (ch = 0; ch< arraySpecs->Q; ch++) {
-                free(pData->STFTInputFrameTF[t][ch].re);
-                free(pData->STFTInputFrameTF[t][ch].im);
-            }
-        }
-        free2d((void**)pData->STFTInputFrameTF, TIME_SLOTS);
-        free2d((void**)pData->tempHopFrameTD, arraySpecs->Q);
-    }
-    if (pData->hSTFT == NULL){
-        afSTFTinit(&(pData->hSTFT), HOP_SIZE, arraySpecs->newQ, NUM_SH_SIGNALS, 1, 1);
-        pData->STFTInputFrameTF = (complexVector**)malloc2d(TIME_SLOTS, arraySpecs->newQ, sizeof(complexVector));
-        for(t=0; t<TIME_SLOTS; t++) {
-            for(ch=0; ch< arraySpecs->newQ; ch++) {
-                pData->STFTInputFrameTF[t][ch].re = (float*)calloc(HYBRID_BANDS, sizeof(float));
-                pData->STFTInputFrameTF[t][ch].im = (float*)calloc(HYBRID_BANDS, sizeof(float));
-            } 
-        }
-        pData->tempHopFrameTD = (float**)malloc2d(arraySpecs->newQ, HOP_SIZE, sizeof(float));
-        arraySpecs->Q = arraySpecs->newQ;
-        pData->reinitSHTmatrixFLAG = 1; /* filters need to be updated too */
-    }
+    /* the afSTFT is allocated for the maximum number of sensors once, and the channel count is changed in-place */
+    if (pData->hSTFT == NULL)
+        afSTFTinit(&(pData->hSTFT), HOP_SIZE, MAX_NUM_SENSORS, NUM_SH_SIGNALS, 1, 1);
+    afSTFTchannelChange(pData->hSTFT, arraySpecs->newQ, NUM_SH_SIGNALS);
+    arraySpecs->Q = arraySpecs->newQ;
+    pData->reinitSHTmatrixFLAG = 1; /* filters need to be updated too */
 }
 
 void array2sh_calculate_sht_matrix
@@ -422,6 +302,7 @@ void array2sh_calculate_sht_matrix
     int n, nrhs, lda, ldb, info;
     int ipiv[NUM_SH_SIGNALS];
     float* steerTmp;
+    modalCoeffsKey key;
     float_complex diag_bN_inv_R[NUM_SH_SIGNALS][NUM_SH_SIGNALS];
     const float alpha = 1.0, beta = 0.0;
     const float_complex calpha = cmplxf(1.0f, 0.0f); const float_complex cbeta  = cmplxf(0.0f, 0.0f);
@@ -431,8 +312,12 @@ void array2sh_calculate_sht_matrix
     steerTmp = (float*)malloc(NUM_SH_SIGNALS*sizeof(float));
     arraySpecs->R = MAX(arraySpecs->R, arraySpecs->r);
 
-    /* calculate equalisation matrix */
-    array2sh_calculate_bN(hA2sh, pData->freqVector);
+    /* calculate equalisation matrix (the modal coefficients are only recomputed if their parameters have changed) */
+    array2sh_getModalCoeffsKey(hA2sh, SH_ORDER, 0, &key);
+    if(memcmp(&key, &(pData->bN_key), sizeof(modalCoeffsKey))!=0){
+        array2sh_calculate_bN(hA2sh, pData->freqVector);
+        pData->bN_key = key;
+    }
     array2sh_reg_inv_bN(hA2sh);
     array2sh_replicate_order(hA2sh);
     
@@ -460,11 +345,13 @@ void array2sh_calculate_sht_matrix
                (const double*)pData->Y, MAX_NUM_SENSORS, beta,
                (double*)pData->YYT, NUM_SH_SIGNALS);
     n = NUM_SH_SIGNALS; nrhs = MAX_NUM_SENSORS; lda = NUM_SH_SIGNALS; ldb = NUM_SH_SIGNALS;
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     dgesv_( (__CLPK_integer*)&n, (__CLPK_integer*)&nrhs, (__CLPK_doublereal*)pData->YYT, (__CLPK_integer*)&lda,
            (__CLPK_integer*)ipiv, (__CLPK_doublereal*)Y_col, (__CLPK_integer*)&ldb, (__CLPK_integer*)&info );
-#else
+#elif defined(SAF_USE_INTEL_MKL)
     dgesv_( &n, &nrhs, (double*)pData->YYT, &lda, ipiv, (double*)Y_col, &ldb, &info );
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_dgesv_work(LAPACK_COL_MAJOR, n, nrhs, (double*)pData->YYT, lda, ipiv, (double*)Y_col, ldb);
 #endif
     if( info > 0 ) {
         /* matrix pData->YYT is singular */
@@ -520,8 +407,8 @@ void array2sh_evaluateSHTfilters(void* hA2sh)
     arrayPars* arraySpecs = (arrayPars*)(pData->arraySpecs);
     int band, i, j, simOrder;
     double kr[HYBRID_BANDS-1];
-    float* Y_grid_real;
     float_complex* Y_grid, *H_array, *Wshort;
+    modalCoeffsKey key;
     
     assert(pData->W != NULL);
     
@@ -530,47 +417,51 @@ void array2sh_evaluateSHTfilters(void* hA2sh)
     simOrder = (int)(2.0f*M_PI*MAX_EVAL_FREQ_HZ*(arraySpecs->R)/pData->c)+1;
     for(i=0; i<HYBRID_BANDS-1; i++)
         kr[i] = 2.0*M_PI*(pData->freqVector[i+1/* ignore DC */])*(arraySpecs->R)/pData->c;
-    H_array = malloc((HYBRID_BANDS-1) * (arraySpecs->Q) * 812*sizeof(float_complex));
-    switch(arraySpecs->arrayType){
-        case ARRAY_SPHERICAL:
-            switch(arraySpecs->weightType){
-                default:
-                case WEIGHT_RIGID:
-                    simulateSphArray(simOrder, kr, HYBRID_BANDS-1, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, (float*)__geosphere_ico_9_0_dirs_deg, 812, ARRAY_CONSTRUCTION_RIGID, 0.0, H_array);
-                    break;
-                case WEIGHT_OPEN_OMNI:
-                    simulateSphArray(simOrder, kr, HYBRID_BANDS-1, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, (float*)__geosphere_ico_9_0_dirs_deg, 812, ARRAY_CONSTRUCTION_OPEN, 0.0, H_array);
-                    break;
-                case WEIGHT_OPEN_DIPOLE:
-                    simulateSphArray(simOrder, kr, HYBRID_BANDS-1, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, (float*)__geosphere_ico_9_0_dirs_deg, 812, ARRAY_CONSTRUCTION_DIRECTIONAL, 1.0, H_array);
-                    break;
-                case WEIGHT_OPEN_CARD:
-                    simulateSphArray(simOrder, kr, HYBRID_BANDS-1, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, (float*)__geosphere_ico_9_0_dirs_deg, 812, ARRAY_CONSTRUCTION_DIRECTIONAL, 0.5, H_array);
-                    break;
-            }
-            break;
+    /* the simulation is reused if only the encoding filters have changed (e.g. the regularisation). It is carried out on
+     * the calling thread only, as this may be the audio thread */
+    array2sh_getModalCoeffsKey(hA2sh, simOrder, 1, &key);
+    if(pData->H_array==NULL || memcmp(&key, &(pData->H_array_key), sizeof(modalCoeffsKey))!=0){
+        pData->H_array = realloc(pData->H_array, (HYBRID_BANDS-1) * (arraySpecs->Q) * 812*sizeof(float_complex));
+        pData->H_array_key = key;
+        switch(arraySpecs->arrayType){
+            case ARRAY_SPHERICAL:
+                switch(arraySpecs->weightType){
+                    default:
+                    case WEIGHT_RIGID:
+                        simulateSphArray(simOrder, kr, HYBRID_BANDS-1, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, (float*)__geosphere_ico_9_0_dirs_deg, 812, ARRAY_CONSTRUCTION_RIGID, 0.0, 1, pData->H_array);
+                        break;
+                    case WEIGHT_OPEN_OMNI:
+                        simulateSphArray(simOrder, kr, HYBRID_BANDS-1, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, (float*)__geosphere_ico_9_0_dirs_deg, 812, ARRAY_CONSTRUCTION_OPEN, 0.0, 1, pData->H_array);
+                        break;
+                    case WEIGHT_OPEN_DIPOLE:
+                        simulateSphArray(simOrder, kr, HYBRID_BANDS-1, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, (float*)__geosphere_ico_9_0_dirs_deg, 812, ARRAY_CONSTRUCTION_DIRECTIONAL, 1.0, 1, pData->H_array);
+                        break;
+                    case WEIGHT_OPEN_CARD:
+                        simulateSphArray(simOrder, kr, HYBRID_BANDS-1, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, (float*)__geosphere_ico_9_0_dirs_deg, 812, ARRAY_CONSTRUCTION_DIRECTIONAL, 0.5, 1, pData->H_array);
+                        break;
+                }
+                break;
             
-        case ARRAY_CYLINDRICAL:
-            switch(arraySpecs->weightType){
-                default:
-                case WEIGHT_RIGID:
-                    simulateCylArray(simOrder, kr, HYBRID_BANDS-1, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, (float*)__geosphere_ico_9_0_dirs_deg, 812, ARRAY_CONSTRUCTION_RIGID, H_array);
-                    break;
-                case WEIGHT_OPEN_DIPOLE:
-                case WEIGHT_OPEN_CARD:
-                case WEIGHT_OPEN_OMNI:
-                    simulateCylArray(simOrder, kr, HYBRID_BANDS-1, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, (float*)__geosphere_ico_9_0_dirs_deg, 812, ARRAY_CONSTRUCTION_OPEN, H_array);
-                    break;
-            }
-            break;
+            case ARRAY_CYLINDRICAL:
+                switch(arraySpecs->weightType){
+                    default:
+                    case WEIGHT_RIGID:
+                        simulateCylArray(simOrder, kr, HYBRID_BANDS-1, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, (float*)__geosphere_ico_9_0_dirs_deg, 812, ARRAY_CONSTRUCTION_RIGID, pData->H_array);
+                        break;
+                    case WEIGHT_OPEN_DIPOLE:
+                    case WEIGHT_OPEN_CARD:
+                    case WEIGHT_OPEN_OMNI:
+                        simulateCylArray(simOrder, kr, HYBRID_BANDS-1, (float*)arraySpecs->sensorCoords_rad, arraySpecs->Q, (float*)__geosphere_ico_9_0_dirs_deg, 812, ARRAY_CONSTRUCTION_OPEN, pData->H_array);
+                        break;
+                }
+                break;
+        }
     }
+    H_array = pData->H_array;
     
     /* generate ideal (real) spherical harmonics to compare with */
-    Y_grid_real = NULL;
-    getRSH(SH_ORDER, (float*)__geosphere_ico_9_0_dirs_deg, 812, &Y_grid_real);
     Y_grid = malloc(NUM_SH_SIGNALS*812*sizeof(float_complex));
-    for(i=0; i<NUM_SH_SIGNALS*812; i++)
-        Y_grid[i] = cmplxf(Y_grid_real[i], 0.0f); /* "evaluateSHTfilters" function requires complex data type */
+    getRSH_batch(SH_ORDER, (float*)__geosphere_ico_9_0_dirs_deg, 812, 1.0f, 1, NULL, Y_grid); /* "evaluateSHTfilters" function requires complex data type; single-threaded, as this may run on the audio thread */
     
     /* compare the spherical harmonics obtained from encoding matrix 'W' with the ideal patterns */
     Wshort = malloc(HYBRID_BANDS*NUM_SH_SIGNALS*(arraySpecs->Q)*sizeof(float_complex));
@@ -580,9 +471,7 @@ void array2sh_evaluateSHTfilters(void* hA2sh)
                 Wshort[band*NUM_SH_SIGNALS*(arraySpecs->Q) + i*(arraySpecs->Q) + j] = pData->W[band+1/* skip DC */][i][j];
     evaluateSHTfilters(SH_ORDER, Wshort, arraySpecs->Q, HYBRID_BANDS-1, H_array, 812, Y_grid, pData->cSH, pData->lSH);
 
-    free(Y_grid_real);
     free(Y_grid);
-    free(H_array);
     free(Wshort);
 }
 
@@ -75,17 +75,27 @@ typedef struct _arrayPars {
     float sensorCoords_deg[MAX_NUM_SENSORS][2];
         
 }arrayPars;
+    
+/* everything that the modal coefficients and the simulated array responses depend on. The regularisation settings
+ * are deliberately not included, so that they may be changed without re-evaluating any special functions */
+typedef struct _modalCoeffsKey {
+    int order;
+    ARRAY_TYPES arrayType;
+    WEIGHT_TYPES weightType;
+    float r, R, admittance, c;
+    float freqVector[HYBRID_BANDS];
+    int Q;                                          /* 0 for the modal coefficients */
+    float sensorCoords_rad[MAX_NUM_SENSORS][2];     /* 0 for the modal coefficients */
+    
+}modalCoeffsKey;
 
 typedef struct _array2sh
 {
     /* audio buffers */
-    float inputFrameTD[MAX_NUM_SENSORS][FRAME_SIZE];
-    float SHframeTD[NUM_SH_SIGNALS][FRAME_SIZE];
+    float** inputFrameTD;         /* MAX_NUM_SENSORS x FRAME_SIZE */
+    float** SHframeTD;            /* NUM_SH_SIGNALS x FRAME_SIZE */
     float_complex inputframeTF[HYBRID_BANDS][MAX_NUM_SENSORS][TIME_SLOTS];
     float_complex SHframeTF[HYBRID_BANDS][NUM_SH_SIGNALS][TIME_SLOTS];
-    complexVector** STFTInputFrameTF;
-    complexVector** STFTOutputFrameTF;
-    float** tempHopFrameTD;
     
     /* intermediates */
     double_complex bN_modal[HYBRID_BANDS][SH_ORDER + 1];
@@ -97,6 +107,11 @@ typedef struct _array2sh
     float_complex Y_cmplx[NUM_SH_SIGNALS][MAX_NUM_SENSORS];
     float_complex W[HYBRID_BANDS][NUM_SH_SIGNALS][MAX_NUM_SENSORS];
     
+    /* cached modal coefficients and simulated array responses */
+    modalCoeffsKey bN_key;        /* parameters used to compute 'bN' */
+    modalCoeffsKey H_array_key;   /* parameters used to compute 'H_array' */
+    float_complex* H_array;       /* simulated array responses; FLAT: (HYBRID_BANDS-1) x Q x 812 */
+    
     /* for displaying the bNs */
     float** bN_modal_dB;
     float** bN_inv_dB;
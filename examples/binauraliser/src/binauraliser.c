@@ -40,16 +40,9 @@ void binauraliser_create
     
     /* time-frequency transform + buffers */
     pData->hSTFT = NULL;
-    pData->STFTInputFrameTF = NULL;
-    int t, ch;
-    pData->STFTOutputFrameTF = (complexVector**)malloc2d(TIME_SLOTS, NUM_EARS, sizeof(complexVector));
-    for(t=0; t<TIME_SLOTS; t++) {
-        for(ch=0; ch< NUM_EARS; ch++) {
-            pData->STFTOutputFrameTF[t][ch].re = (float*)calloc(HYBRID_BANDS, sizeof(float));
-            pData->STFTOutputFrameTF[t][ch].im = (float*)calloc(HYBRID_BANDS, sizeof(float));
-        }
-    }
-    pData->tempHopFrameTD = NULL;
+    int ch;
+    pData->inputFrameTD = (float**)malloc2d(MAX_NUM_INPUTS, FRAME_SIZE, sizeof(float));
+    pData->outframeTD = (float**)malloc2d(NUM_EARS, FRAME_SIZE, sizeof(float));
     /* hrir data */
     pData->useDefaultHRIRsFLAG=1;
     pData->hrirs = NULL;
@@ -57,8 +50,7 @@ void binauraliser_create
     pData->sofa_filepath = "/Users/mccorml1/Documents/SourceTree/AkisPlugins/database/AALTO/leo_aalto2016.sofa";
     //pData->sofa_filename = "/Users/mccorml1/Documents/SourceTree/AkisPlugins/database/CIPIC/subject_003.sofa";
     /* vbap */
-    pData->hrtf_vbap_gtableIdx = NULL;
-    pData->hrtf_vbap_gtableComp = NULL;
+    pData->hVbap = NULL;
     /* HRTF filterbank coefficients */
     pData->itds_s = NULL;
     pData->hrtf_fb = NULL;
@@ -81,34 +73,14 @@ void binauraliser_destroy
 )
 {
     binauraliser_data *pData = (binauraliser_data*)(*phBin);
-    int t, ch;
 
     if (pData != NULL) {
         if(pData->hSTFT !=NULL)
             afSTFTfree(pData->hSTFT);
-        for (t = 0; t<TIME_SLOTS; t++) {
-            if(pData->STFTInputFrameTF!=NULL){
-                for(ch=0; ch< pData->nSources; ch++) {
-                    free(pData->STFTInputFrameTF[t][ch].re);
-                    free(pData->STFTInputFrameTF[t][ch].im);
-                }
-            }
-            for (ch = 0; ch< NUM_EARS; ch++) {
-                free(pData->STFTOutputFrameTF[t][ch].re);
-                free(pData->STFTOutputFrameTF[t][ch].im);
-            }
-        }
-        if(pData->STFTInputFrameTF!=NULL)
-            free2d((void**)pData->STFTInputFrameTF, TIME_SLOTS);
-        if(pData->STFTOutputFrameTF!=NULL)
-            free2d((void**)pData->STFTOutputFrameTF, TIME_SLOTS);
-        if(pData->tempHopFrameTD!=NULL)
-            free2d((void**)pData->tempHopFrameTD, MAX(pData->nSources, NUM_EARS));
+        free2d((void**)pData->inputFrameTD, MAX_NUM_INPUTS);
+        free2d((void**)pData->outframeTD, NUM_EARS);
         
-        if(pData->hrtf_vbap_gtableComp!= NULL)
-            free(pData->hrtf_vbap_gtableComp);
-        if(pData->hrtf_vbap_gtableIdx!= NULL)
-            free(pData->hrtf_vbap_gtableIdx);
+        vbap_destroy(&(pData->hVbap));
         if(pData->hrtf_fb!= NULL)
             free(pData->hrtf_fb);
         if(pData->hrtf_fb_mag!= NULL)
@@ -156,7 +128,7 @@ void binauraliser_process
 )
 {
     binauraliser_data *pData = (binauraliser_data*)(hBin);
-    int t, sample, ch, ear, i, band, nSources; 
+    int t, ch, ear, i, band, nSources; 
     float src_dirs[MAX_NUM_INPUTS][2];
     
 #ifdef ENABLE_FADE_IN_OUT
@@ -195,16 +167,7 @@ void binauraliser_process
                     pData->inputFrameTD[ch][i] *= (float)i/(float)FRAME_SIZE;
 #endif
         /* Apply time-frequency transform (TFT) */
-        for ( t=0; t< TIME_SLOTS; t++) {
-            for( ch=0; ch < nSources; ch++)
-                for ( sample=0; sample < HOP_SIZE; sample++)
-                    pData->tempHopFrameTD[ch][sample] = pData->inputFrameTD[ch][sample + t*HOP_SIZE];
-            afSTFTforward(pData->hSTFT, (float**)pData->tempHopFrameTD, (complexVector*)pData->STFTInputFrameTF[t]);
-        }
-        for(band=0; band<HYBRID_BANDS; band++)
-            for( ch=0; ch < nSources; ch++)
-                for ( t=0; t<TIME_SLOTS; t++)
-                    pData->inputframeTF[band][ch][t] = cmplxf(pData->STFTInputFrameTF[t][ch].re[band], pData->STFTInputFrameTF[t][ch].im[band]);
+        afSTFTforward_frame(pData->hSTFT, pData->inputFrameTD, FRAME_SIZE, MAX_NUM_INPUTS, AFSTFT_BANDS_CH_TIME, (void*)pData->inputframeTF);
         /* Apply Binaural Rendering */
         memset(pData->outputframeTF, 0, HYBRID_BANDS*NUM_EARS*TIME_SLOTS * sizeof(float_complex));
         /* interpolate hrtfs and apply to each source */
@@ -224,23 +187,11 @@ void binauraliser_process
                 for (t = 0; t < TIME_SLOTS; t++)
                     pData->outputframeTF[band][ear][t] = crmulf(pData->outputframeTF[band][ear][t], 1.0f/sqrtf((float)nSources));
         /* inverse-TFT */
-        for (band = 0; band < HYBRID_BANDS; band++) {
-            for (ch = 0; ch < NUM_EARS; ch++) {
-                for (t = 0; t < TIME_SLOTS; t++) {
-                    pData->STFTOutputFrameTF[t][ch].re[band] = crealf(pData->outputframeTF[band][ch][t]);
-                    pData->STFTOutputFrameTF[t][ch].im[band] = cimagf(pData->outputframeTF[band][ch][t]);
-                }
-            }
-        }
-        for (t = 0; t < TIME_SLOTS; t++) {
-            afSTFTinverse(pData->hSTFT, pData->STFTOutputFrameTF[t], pData->tempHopFrameTD);
-            for (ch = 0; ch < MIN(NUM_EARS, nOutputs); ch++)
-                for (sample = 0; sample < HOP_SIZE; sample++)
-                    outputs[ch][sample + t* HOP_SIZE] = pData->tempHopFrameTD[ch][sample];
-            for (; ch < nOutputs; ch++)
-                for (sample = 0; sample < HOP_SIZE; sample++)
-                    outputs[ch][sample + t* HOP_SIZE] = 0.0f;
-        }
+        afSTFTinverse_frame(pData->hSTFT, (void*)pData->outputframeTF, NUM_EARS, AFSTFT_BANDS_CH_TIME, FRAME_SIZE, pData->outframeTD);
+        for (ch = 0; ch < MIN(NUM_EARS, nOutputs); ch++)
+            memcpy(outputs[ch], pData->outframeTD[ch], FRAME_SIZE * sizeof(float));
+        for (; ch < nOutputs; ch++)
+            memset(outputs[ch], 0, FRAME_SIZE * sizeof(float));
 #ifdef ENABLE_FADE_IN_OUT
         if(pData->reInitTFT || pData->reInitHRTFsAndGainTables)
             for(ch=0; ch < NUM_EARS;ch++)
@@ -48,26 +48,23 @@ void binauraliser_interpHRTFs
 {
     binauraliser_data *pData = (binauraliser_data*)(hBin);
     int i, band;
-    int aziIndex, elevIndex, N_azi, idx3d;
+    int idx3[3];
     float_complex ipd;
-    float aziRes, elevRes, weights[1][3], itds3[3],  itdInterp[1];
+    float gains_sum, weights[1][3], itds3[3],  itdInterp[1];
     float magnitudes3[HYBRID_BANDS][3][NUM_EARS], magInterp[HYBRID_BANDS][NUM_EARS];
      
-    /* find closest pre-computed VBAP direction */
-    aziRes = (float)pData->hrtf_vbapTableRes[0];
-    elevRes = (float)pData->hrtf_vbapTableRes[1];
-    N_azi = (int)(360.0f / aziRes + 0.5f) + 1;
-    aziIndex = (int)(matlab_fmodf(azimuth_deg + 180.0f, 360.0f) / aziRes + 0.5f);
-    elevIndex = (int)((elevation_deg + 90.0f) / elevRes + 0.5f);
-    idx3d = elevIndex * N_azi + aziIndex;
-    for (i = 0; i < 3; i++)
-        weights[0][i] = pData->hrtf_vbap_gtableComp[idx3d*3 + i];
+    /* find the VBAP gains for the exact direction, and amplitude normalise them */
+    vbap_query(pData->hVbap, azimuth_deg, elevation_deg, idx3, weights[0]);
+    gains_sum = weights[0][0] + weights[0][1] + weights[0][2];
+    if(gains_sum > 2.23e-13f)
+        for (i = 0; i < 3; i++)
+            weights[0][i] /= gains_sum;
     /* retrieve the 3 itds and hrtf magnitudes */
     for (i = 0; i < 3; i++) {
-        itds3[i] = pData->itds_s[pData->hrtf_vbap_gtableIdx[idx3d*3+i]];
+        itds3[i] = pData->itds_s[idx3[i]];
         for (band = 0; band < HYBRID_BANDS; band++) {
-            magnitudes3[band][i][0] = pData->hrtf_fb_mag[band*NUM_EARS*(pData->N_hrir_dirs) + 0*(pData->N_hrir_dirs) + pData->hrtf_vbap_gtableIdx[idx3d*3+i]];
-            magnitudes3[band][i][1] = pData->hrtf_fb_mag[band*NUM_EARS*(pData->N_hrir_dirs) + 1*(pData->N_hrir_dirs) + pData->hrtf_vbap_gtableIdx[idx3d*3+i]];
+            magnitudes3[band][i][0] = pData->hrtf_fb_mag[band*NUM_EARS*(pData->N_hrir_dirs) + 0*(pData->N_hrir_dirs) + idx3[i]];
+            magnitudes3[band][i][1] = pData->hrtf_fb_mag[band*NUM_EARS*(pData->N_hrir_dirs) + 1*(pData->N_hrir_dirs) + idx3[i]];
         }
     }
     /* interpolate hrtf magnitudes and itd */
@@ -93,7 +90,6 @@ void binauraliser_initHRTFsAndGainTables(void* const hBin)
 {
     binauraliser_data *pData = (binauraliser_data*)(hBin);
     int i, j, k;
-    float* hrtf_vbap_gtable;
     
     /* load sofa file or load default hrir data */
     if(!pData->useDefaultHRIRsFLAG){
@@ -135,27 +131,15 @@ void binauraliser_initHRTFsAndGainTables(void* const hBin)
         pData->itds_s = NULL;
     }
     hrirlib_estimateITDs(pData->hrirs, pData->N_hrir_dirs, pData->hrir_len, pData->hrir_fs, &(pData->itds_s));
-    /* generate VBAP gain table */
-    hrtf_vbap_gtable = NULL;
-    pData->hrtf_vbapTableRes[0] = 2;
-    pData->hrtf_vbapTableRes[1] = 5;
-    generateVBAPgainTable3D(pData->hrir_dirs_deg, pData->N_hrir_dirs, pData->hrtf_vbapTableRes[0], pData->hrtf_vbapTableRes[1], 1, 0,
-                            &hrtf_vbap_gtable, &(pData->N_hrtf_vbap_gtable), &(pData->nTriangles));
-    if(hrtf_vbap_gtable==NULL){
-        /* if generating vbap gain tabled failed, re-calculate with default HRIR set */
+    /* generate VBAP handle over the HRIR directions */
+    vbap_destroy(&(pData->hVbap));
+    vbap_create(&(pData->hVbap), pData->hrir_dirs_deg, pData->N_hrir_dirs, 1, 0, &(pData->nTriangles));
+    if(pData->hVbap==NULL){
+        /* if generating vbap handle failed, re-calculate with default HRIR set */
         pData->useDefaultHRIRsFLAG = 1;
         binauraliser_initHRTFsAndGainTables(hBin);
+        return;
     }
-    /* compress VBAP table */
-    if(pData->hrtf_vbap_gtableComp!= NULL){
-        free(pData->hrtf_vbap_gtableComp);
-        pData->hrtf_vbap_gtableComp = NULL;
-    }
-    if(pData->hrtf_vbap_gtableIdx!= NULL){
-        free(pData->hrtf_vbap_gtableIdx);
-        pData->hrtf_vbap_gtableIdx = NULL;
-    }
-    compressVBAPgainTable3D(hrtf_vbap_gtable, pData->N_hrtf_vbap_gtable, pData->N_hrir_dirs, &(pData->hrtf_vbap_gtableComp), &(pData->hrtf_vbap_gtableIdx));
     /* convert hrirs to filterbank coefficients */
     if(pData->hrtf_fb!= NULL){
         free(pData->hrtf_fb);
@@ -168,10 +152,6 @@ void binauraliser_initHRTFsAndGainTables(void* const hBin)
     pData->hrtf_fb_mag = malloc(HYBRID_BANDS*NUM_EARS* (pData->N_hrir_dirs)*sizeof(float));
     for(i=0; i<HYBRID_BANDS*NUM_EARS* (pData->N_hrir_dirs); i++)
         pData->hrtf_fb_mag[i] = cabsf(pData->hrtf_fb[i]);
-    
-    /* clean-up */
-    if(hrtf_vbap_gtable!=NULL)
-        free(hrtf_vbap_gtable);
 }
 
 void binauraliser_initTFT
@@ -180,32 +160,12 @@ void binauraliser_initTFT
 )
 {
     binauraliser_data *pData = (binauraliser_data*)(hBin);
-    int t, ch;
     
-    if (pData->hSTFT != NULL){
-        afSTFTfree(pData->hSTFT);
-        pData->hSTFT = NULL;
-        for (t = 0; t<TIME_SLOTS; t++) {
-            for (ch = 0; ch< pData->nSources; ch++) {
-                free(pData->STFTInputFrameTF[t][ch].re);
-                free(pData->STFTInputFrameTF[t][ch].im);
-            }
-        }
-        free2d((void**)pData->STFTInputFrameTF, TIME_SLOTS);
-        free2d((void**)pData->tempHopFrameTD, MAX(pData->nSources, NUM_EARS));
-    }
-    if (pData->hSTFT == NULL){
-        afSTFTinit(&(pData->hSTFT), HOP_SIZE, pData->new_nSources, NUM_EARS, 1, 1);
-        pData->STFTInputFrameTF = (complexVector**)malloc2d(TIME_SLOTS, pData->new_nSources, sizeof(complexVector));
-        for(t=0; t<TIME_SLOTS; t++) {
-            for(ch=0; ch< pData->new_nSources; ch++) {
-                pData->STFTInputFrameTF[t][ch].re = (float*)calloc(HYBRID_BANDS, sizeof(float));
-                pData->STFTInputFrameTF[t][ch].im = (float*)calloc(HYBRID_BANDS, sizeof(float));
-            }
-        }
-        pData->tempHopFrameTD = (float**)malloc2d( MAX(pData->new_nSources, NUM_EARS), HOP_SIZE, sizeof(float));
-        pData->nSources = pData->new_nSources;
-    }
+    /* the afSTFT is allocated for the maximum number of channels once, and the channel counts are changed in-place */
+    if (pData->hSTFT == NULL)
+        afSTFTinit(&(pData->hSTFT), HOP_SIZE, MAX_NUM_INPUTS, NUM_EARS, 1, 1);
+    afSTFTchannelChange(pData->hSTFT, pData->new_nSources, NUM_EARS);
+    pData->nSources = pData->new_nSources;
 }
 
 void binauraliser_loadPreset(PRESETS preset, float dirs_deg[MAX_NUM_INPUTS][2], int* newNCH, int* nDims)
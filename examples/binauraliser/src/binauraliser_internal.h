@@ -66,13 +66,10 @@ extern "C" {
 typedef struct _binauraliser
 {
     /* audio buffers */
-    float inputFrameTD[MAX_NUM_INPUTS][FRAME_SIZE];
-    float outframeTD[NUM_EARS][FRAME_SIZE];
+    float** inputFrameTD;         /* MAX_NUM_INPUTS x FRAME_SIZE */
+    float** outframeTD;           /* NUM_EARS x FRAME_SIZE */
     float_complex inputframeTF[HYBRID_BANDS][MAX_NUM_INPUTS][TIME_SLOTS];
     float_complex outputframeTF[HYBRID_BANDS][NUM_EARS][TIME_SLOTS];
-    complexVector** STFTInputFrameTF;
-    complexVector** STFTOutputFrameTF;
-    float** tempHopFrameTD;
     int fs;
     
     /* time-frequency transform */
@@ -87,11 +84,8 @@ typedef struct _binauraliser
     int hrir_len;
     int hrir_fs;
     
-    /* vbap gain table */
-    int hrtf_vbapTableRes[2];
-    int N_hrtf_vbap_gtable;
-    int* hrtf_vbap_gtableIdx; /* N_hrtf_vbap_gtable x 3 */
-    float* hrtf_vbap_gtableComp; /* N_hrtf_vbap_gtable x 3 */
+    /* vbap handle */
+    void* hVbap; /* VBAP over the HRIR directions, queried per source direction */
     
     /* hrir filterbank coefficients */
     int useDefaultHRIRsFLAG; 
@@ -130,7 +124,7 @@ void binauraliser_interpHRTFs(void* const hPan,                    /* pannerlib
                               float elevation_deg,                 /* source elevation in degrees */
                               float_complex h_intrp[HYBRID_BANDS][NUM_EARS]);
     
-/* Initialise the HRTFs: either loading the default set or loading from a SOFA file, Then generate a VBAP gain table. */
+/* Initialise the HRTFs: either loading the default set or loading from a SOFA file, Then generate a VBAP handle. */
 void binauraliser_initHRTFsAndGainTables(void* const hBin);        /* binauraliser handle */
     
 /* Initialise the filterbank used by binauraliser */
@@ -36,9 +36,8 @@ void mceq_create
     
     /* time-frequency transform + buffers */
     pData->hSTFT = NULL;
-    pData->STFTInputFrameTF = NULL;
-    pData->STFTOutputFrameTF = NULL;
-    pData->tempHopFrameTD = NULL;
+    pData->inputFrameTD = (float**)malloc2d(MAX_NUM_CHANNELS, FRAME_SIZE, sizeof(float));
+    pData->outframeTD = (float**)malloc2d(MAX_NUM_CHANNELS, FRAME_SIZE, sizeof(float));
     
     /* internal parameters */
     pData->reInitTFT = 1;
@@ -56,31 +55,12 @@ void mceq_destroy
 )
 {
     mceq_data *pData = (mceq_data*)(*phMEQ);
-	int t, ch;
 
 	if (pData != NULL) {
         if(pData->hSTFT !=NULL)
             afSTFTfree(pData->hSTFT);
-        for (t = 0; t<TIME_SLOTS; t++) {
-            if(pData->STFTInputFrameTF!=NULL){
-                for(ch=0; ch< pData->nChannels; ch++) {
-                    free(pData->STFTInputFrameTF[t][ch].re);
-                    free(pData->STFTInputFrameTF[t][ch].im);
-                }
-            }
-            if(pData->STFTOutputFrameTF!=NULL){
-                for (ch = 0; ch< pData->nChannels; ch++) {
-                    free(pData->STFTOutputFrameTF[t][ch].re);
-                    free(pData->STFTOutputFrameTF[t][ch].im);
-                }
-            }
-        }
-        if(pData->STFTInputFrameTF!=NULL)
-            free2d((void**)pData->STFTInputFrameTF, TIME_SLOTS);
-        if(pData->STFTOutputFrameTF!=NULL)
-            free2d((void**)pData->STFTOutputFrameTF, TIME_SLOTS);
-        if(pData->tempHopFrameTD!=NULL)
-            free2d((void**)pData->tempHopFrameTD, pData->nChannels);
+        free2d((void**)pData->inputFrameTD, MAX_NUM_CHANNELS);
+        free2d((void**)pData->outframeTD, MAX_NUM_CHANNELS);
      
         free(pData);
         pData = NULL;
@@ -121,7 +101,7 @@ void mceq_process
 )
 {
     mceq_data *pData = (mceq_data*)(hMEQ);
-    int t, sample, ch, i, band;
+    int t, ch, i, band;
     float mag, arg;
     
     /* tmp parameters */
@@ -141,16 +121,7 @@ void mceq_process
             memset(pData->inputFrameTD[i], 0, FRAME_SIZE * sizeof(float));
         
         /* Apply time-frequency transform (TFT) */
-        for ( t=0; t< TIME_SLOTS; t++) {
-            for( ch=0; ch < pData->nChannels; ch++)
-                for ( sample=0; sample < HOP_SIZE; sample++)
-                    pData->tempHopFrameTD[ch][sample] = pData->inputFrameTD[ch][sample + t*HOP_SIZE];
-            afSTFTforward(pData->hSTFT, (float**)pData->tempHopFrameTD, (complexVector*)pData->STFTInputFrameTF[t]);
-        }
-        for( ch=0; ch < pData->nChannels; ch++)
-            for ( t=0; t<TIME_SLOTS; t++)
-                for(band=0; band<NUM_BANDS; band++)
-                    pData->inputframeTF[ch][t][band] = cmplxf(pData->STFTInputFrameTF[t][ch].re[band], pData->STFTInputFrameTF[t][ch].im[band]);
+        afSTFTforward_frame(pData->hSTFT, pData->inputFrameTD, FRAME_SIZE, MAX_NUM_CHANNELS, AFSTFT_CH_TIME_BANDS, (void*)pData->inputframeTF);
    
         /* apply EQ */
         for( ch=0; ch < pData->nChannels; ch++){
@@ -164,23 +135,11 @@ void mceq_process
         }
         
         /* inverse-TFT */
-        for (ch = 0; ch < pData->nChannels; ch++) {
-            for (t = 0; t < TIME_SLOTS; t++) {
-                for (band = 0; band < NUM_BANDS; band++) {
-                    pData->STFTOutputFrameTF[t][ch].re[band] = crealf(pData->outputframeTF[ch][t][band]);
-                    pData->STFTOutputFrameTF[t][ch].im[band] = cimagf(pData->outputframeTF[ch][t][band]);
-                }
-            }
-        }
-        for (t = 0; t < TIME_SLOTS; t++) {
-            afSTFTinverse(pData->hSTFT, pData->STFTOutputFrameTF[t], pData->tempHopFrameTD);
-            for (ch = 0; ch < MIN(pData->nChannels, nOutputs); ch++)
-                for (sample = 0; sample < HOP_SIZE; sample++)
-                    outputs[ch][sample + t* HOP_SIZE] = pData->tempHopFrameTD[ch][sample];
-            for (; ch < nOutputs; ch++)
-                for (sample = 0; sample < HOP_SIZE; sample++)
-                    outputs[ch][sample + t* HOP_SIZE] = 0.0f;
-        }
+        afSTFTinverse_frame(pData->hSTFT, (void*)pData->outputframeTF, MAX_NUM_CHANNELS, AFSTFT_CH_TIME_BANDS, FRAME_SIZE, pData->outframeTD);
+        for (ch = 0; ch < MIN(pData->nChannels, nOutputs); ch++)
+            memcpy(outputs[ch], pData->outframeTD[ch], FRAME_SIZE * sizeof(float));
+        for (; ch < nOutputs; ch++)
+            memset(outputs[ch], 0, FRAME_SIZE * sizeof(float));
     }
     else{
         for (ch=0; ch < nOutputs; ch++)
@@ -31,38 +31,12 @@ void mceq_initTFT
 )
 {
     mceq_data *pData = (mceq_data*)(hMEQ);
-    int t, ch;
     
-    if (pData->hSTFT != NULL){
-        afSTFTfree(pData->hSTFT);
-        pData->hSTFT = NULL;
-        for (t = 0; t<TIME_SLOTS; t++) {
-            for (ch = 0; ch< pData->nChannels; ch++) {
-                free(pData->STFTInputFrameTF[t][ch].re);
-                free(pData->STFTInputFrameTF[t][ch].im);
-                free(pData->STFTOutputFrameTF[t][ch].re);
-                free(pData->STFTOutputFrameTF[t][ch].im);
-            }
-        }
-        free2d((void**)pData->STFTInputFrameTF, TIME_SLOTS);
-        free2d((void**)pData->STFTOutputFrameTF, TIME_SLOTS);
-        free2d((void**)pData->tempHopFrameTD, pData->nChannels);
-    }
-    if (pData->hSTFT == NULL){
-        afSTFTinit(&(pData->hSTFT), HOP_SIZE, pData->new_nChannels, pData->new_nChannels, 0, 0);
-        pData->STFTInputFrameTF = (complexVector**)malloc2d(TIME_SLOTS, pData->new_nChannels, sizeof(complexVector));
-        pData->STFTOutputFrameTF = (complexVector**)malloc2d(TIME_SLOTS, pData->new_nChannels, sizeof(complexVector));
-        for(t=0; t<TIME_SLOTS; t++) {
-            for(ch=0; ch< pData->new_nChannels; ch++) {
-                pData->STFTInputFrameTF[t][ch].re = (float*)calloc(NUM_BANDS, sizeof(float));
-                pData->STFTInputFrameTF[t][ch].im = (float*)calloc(NUM_BANDS, sizeof(float));
-                pData->STFTOutputFrameTF[t][ch].re = (float*)calloc(NUM_BANDS, sizeof(float));
-                pData->STFTOutputFrameTF[t][ch].im = (float*)calloc(NUM_BANDS, sizeof(float));
-            }
-        }
-        pData->tempHopFrameTD = (float**)malloc2d( pData->new_nChannels, HOP_SIZE, sizeof(float));
-        pData->nChannels = pData->new_nChannels;
-    }
+    /* the afSTFT is allocated for the maximum number of channels once, and the channel counts are changed in-place */
+    if (pData->hSTFT == NULL)
+        afSTFTinit(&(pData->hSTFT), HOP_SIZE, MAX_NUM_CHANNELS, MAX_NUM_CHANNELS, 0, 0);
+    afSTFTchannelChange(pData->hSTFT, pData->new_nChannels, pData->new_nChannels);
+    pData->nChannels = pData->new_nChannels;
 }
 
 
@@ -79,13 +79,10 @@ typedef struct _filter
 typedef struct _mceq
 {
     /* audio buffers */
-    float inputFrameTD[MAX_NUM_CHANNELS][FRAME_SIZE];
-    float outframeTD[MAX_NUM_CHANNELS][FRAME_SIZE];
+    float** inputFrameTD;         /* MAX_NUM_CHANNELS x FRAME_SIZE */
+    float** outframeTD;           /* MAX_NUM_CHANNELS x FRAME_SIZE */
     float_complex inputframeTF[MAX_NUM_CHANNELS][TIME_SLOTS][NUM_BANDS];
     float_complex outputframeTF[MAX_NUM_CHANNELS][TIME_SLOTS][NUM_BANDS];
-    complexVector** STFTInputFrameTF;
-    complexVector** STFTOutputFrameTF;
-    float** tempHopFrameTD;
     int fs;
     
     /* time-frequency transform */
@@ -45,13 +45,13 @@ void panner_create
     
     /* time-frequency transform + buffers */
     pData->hSTFT = NULL;
-    pData->STFTInputFrameTF = NULL;
-    pData->STFTOutputFrameTF = NULL;
-    pData->tempHopFrameTD = NULL;
+    pData->inputFrameTD = (float**)malloc2d(MAX_NUM_INPUTS, FRAME_SIZE, sizeof(float));
+    pData->outputFrameTD = (float**)malloc2d(MAX_NUM_OUTPUTS, FRAME_SIZE, sizeof(float));
     
     /* flags and gain table */
     pData->reInitGainTables = 1;
     pData->vbap_gtable = NULL;
+    pData->hVbap = NULL;
     pData->reInitTFT = 1;
     
     /* user parameters */
@@ -69,34 +69,16 @@ void panner_destroy
 )
 {
     panner_data *pData = (panner_data*)(*phPan);
-    int t, ch;
 
     if (pData != NULL) {
         if(pData->hSTFT !=NULL)
             afSTFTfree(pData->hSTFT);
-        for (t = 0; t<TIME_SLOTS; t++) {
-            if(pData->STFTInputFrameTF!=NULL){
-                for(ch=0; ch< pData->nSources; ch++) {
-                    free(pData->STFTInputFrameTF[t][ch].re);
-                    free(pData->STFTInputFrameTF[t][ch].im);
-                }
-            }
-            if(pData->STFTOutputFrameTF!=NULL){
-                for (ch = 0; ch< pData->new_nLoudpkrs; ch++) {
-                    free(pData->STFTOutputFrameTF[t][ch].re);
-                    free(pData->STFTOutputFrameTF[t][ch].im);
-                }
-            }
-        }
-        if(pData->STFTInputFrameTF!=NULL)
-            free2d((void**)pData->STFTInputFrameTF, TIME_SLOTS);
-        if(pData->STFTOutputFrameTF!=NULL)
-            free2d((void**)pData->STFTOutputFrameTF, TIME_SLOTS);
-        if(pData->tempHopFrameTD!=NULL)
-            free2d((void**)pData->tempHopFrameTD, MAX(pData->nSources, pData->new_nLoudpkrs));
+        free2d((void**)pData->inputFrameTD, MAX_NUM_INPUTS);
+        free2d((void**)pData->outputFrameTD, MAX_NUM_OUTPUTS);
     
         if(pData->vbap_gtable!= NULL)
             free(pData->vbap_gtable);
+        vbap_destroy(&(pData->hVbap));
          
         free(pData);
         pData = NULL;
@@ -136,9 +118,10 @@ void panner_process
 )
 {
     panner_data *pData = (panner_data*)(hPan);
-    int t, sample, ch, ls, i, band, nSources, nLoudspeakers, N_azi, aziIndex, elevIndex, idx3d, idx2D;
-    float aziRes, elevRes, pv_f, gains3D_sum_pvf, gains2D_sum_pvf;
-    float src_dirs[MAX_NUM_INPUTS][2], pValue[HYBRID_BANDS], gains3D[MAX_NUM_OUTPUTS], gains2D[MAX_NUM_OUTPUTS], gains_band[MAX_NUM_OUTPUTS];
+    int t, ch, ls, i, band, nSources, nLoudspeakers, idx2D;
+    int idx3D[3];
+    float aziRes, pv_f, gains3D_sum_pvf, gains2D_sum_pvf;
+    float src_dirs[MAX_NUM_INPUTS][2], pValue[HYBRID_BANDS], gainsTri[3], gains3D[MAX_NUM_OUTPUTS], gains2D[MAX_NUM_OUTPUTS], gains_band[MAX_NUM_OUTPUTS];
     
     /* reinitialise if needed */
     if(pData->reInitTFT){
@@ -156,7 +139,7 @@ void panner_process
         pData->reInitGainTables = 0;
     }
     /* apply panner */
-    if ((nSamples == FRAME_SIZE) && (isPlaying == 1) && (pData->vbap_gtable != NULL)) {
+    if ((nSamples == FRAME_SIZE) && (isPlaying == 1) && (pData->vbap_gtable != NULL || pData->hVbap != NULL)) {
         memcpy(src_dirs, pData->src_dirs_deg, MAX_NUM_INPUTS*2*sizeof(float));
         memcpy(pValue, pData->pValue, HYBRID_BANDS*sizeof(float));
         /* Load time-domain data */
@@ -165,28 +148,15 @@ void panner_process
         for(; i<MAX_NUM_INPUTS; i++)
             memset(pData->inputFrameTD[i], 0, FRAME_SIZE * sizeof(float)); 
         /* Apply time-frequency transform (TFT) */
-        for ( t=0; t< TIME_SLOTS; t++) {
-            for( ch=0; ch < nSources; ch++)
-                for ( sample=0; sample < HOP_SIZE; sample++)
-                    pData->tempHopFrameTD[ch][sample] = pData->inputFrameTD[ch][sample + t*HOP_SIZE];
-            afSTFTforward(pData->hSTFT, (float**)pData->tempHopFrameTD, (complexVector*)pData->STFTInputFrameTF[t]);
-        }
-        for(band=0; band<HYBRID_BANDS; band++)
-            for( ch=0; ch < nSources; ch++)
-                for ( t=0; t<TIME_SLOTS; t++)
-                    pData->inputframeTF[band][ch][t] = cmplxf(pData->STFTInputFrameTF[t][ch].re[band], pData->STFTInputFrameTF[t][ch].im[band]);
+        afSTFTforward_frame(pData->hSTFT, pData->inputFrameTD, FRAME_SIZE, MAX_NUM_INPUTS, AFSTFT_BANDS_CH_TIME, (void*)pData->inputframeTF);
         memset(pData->outputframeTF, 0, HYBRID_BANDS*MAX_NUM_OUTPUTS*TIME_SLOTS * sizeof(float_complex));
         /* Apply VBAP Panning */
         if(pData->output_nDims == 3){/* 3-D case */
-            aziRes = (float)pData->vbapTableRes[0];
-            elevRes = (float)pData->vbapTableRes[1];
-            N_azi = (int)(360.0f / aziRes + 0.5f) + 1;
             for (ch = 0; ch < nSources; ch++) {
-                aziIndex = (int)(matlab_fmodf(pData->src_dirs_deg[ch][0] + 180.0f, 360.0f) / aziRes + 0.5f);
-                elevIndex = (int)((pData->src_dirs_deg[ch][1] + 90.0f) / elevRes + 0.5f);
-                idx3d = elevIndex * N_azi + aziIndex;
-                for (ls = 0; ls < nLoudspeakers; ls++)
-                    gains3D[ls] =  pData->vbap_gtable[idx3d*nLoudspeakers+ls];
+                vbap_query(pData->hVbap, pData->src_dirs_deg[ch][0], pData->src_dirs_deg[ch][1], idx3D, gainsTri);
+                memset(gains3D, 0, nLoudspeakers*sizeof(float));
+                for (i = 0; i < 3; i++)
+                    gains3D[idx3D[i]] += gainsTri[i];
                 for (band = 0; band < HYBRID_BANDS; band++){
                     /* apply pValue per frequency */
                     pv_f = pData->pValue[band];
@@ -207,7 +177,7 @@ void panner_process
             }
         }
         else{/* 2-D case */
-            aziRes = (float)pData->vbapTableRes[0];
+            aziRes = (float)pData->vbapTableRes;
             for (ch = 0; ch < nSources; ch++) {
                 idx2D = (int)((matlab_fmodf(pData->src_dirs_deg[ch][0]+180.0f,360.0f)/aziRes)+0.5f);
                 for (ls = 0; ls < nLoudspeakers; ls++)
@@ -237,23 +207,11 @@ void panner_process
                 for (t = 0; t < TIME_SLOTS; t++)
                     pData->outputframeTF[band][ls][t] = crmulf(pData->outputframeTF[band][ls][t], 1.0f/sqrtf((float)nSources));
         /* inverse-TFT */
-        for (band = 0; band < HYBRID_BANDS; band++) {
-            for (ch = 0; ch < nLoudspeakers; ch++) {
-                for (t = 0; t < TIME_SLOTS; t++) {
-                    pData->STFTOutputFrameTF[t][ch].re[band] = crealf(pData->outputframeTF[band][ch][t]);
-                    pData->STFTOutputFrameTF[t][ch].im[band] = cimagf(pData->outputframeTF[band][ch][t]);
-                }
-            }
-        }
-        for (t = 0; t < TIME_SLOTS; t++) {
-            afSTFTinverse(pData->hSTFT, pData->STFTOutputFrameTF[t], pData->tempHopFrameTD);
-            for (ch = 0; ch < MIN(nLoudspeakers, nOutputs); ch++)
-                for (sample = 0; sample < HOP_SIZE; sample++)
-                    outputs[ch][sample + t* HOP_SIZE] = pData->tempHopFrameTD[ch][sample];
-            for (; ch < nOutputs; ch++)
-                for (sample = 0; sample < HOP_SIZE; sample++)
-                    outputs[ch][sample + t* HOP_SIZE] = 0.0f;
-        }
+        afSTFTinverse_frame(pData->hSTFT, (void*)pData->outputframeTF, MAX_NUM_OUTPUTS, AFSTFT_BANDS_CH_TIME, FRAME_SIZE, pData->outputFrameTD);
+        for (ch = 0; ch < MIN(nLoudspeakers, nOutputs); ch++)
+            memcpy(outputs[ch], pData->outputFrameTD[ch], FRAME_SIZE * sizeof(float));
+        for (; ch < nOutputs; ch++)
+            memset(outputs[ch], 0, FRAME_SIZE * sizeof(float));
     }
     else{
         for (ch=0; ch < nOutputs; ch++)
@@ -33,20 +33,19 @@ void panner_initGainTables(void* const hPan)
 {
     panner_data *pData = (panner_data*)(hPan);
     
-    /* generate VBAP gain table */
+    /* generate VBAP gain table (2-D), or VBAP handle (3-D) */
     if(pData->vbap_gtable!= NULL){
         free(pData->vbap_gtable);
         pData->vbap_gtable = NULL;
     } 
-    pData->vbapTableRes[0] = 2;
-    pData->vbapTableRes[1] = 5;
+    vbap_destroy(&(pData->hVbap));
+    pData->vbapTableRes = 2;
     if(pData->output_nDims==2)
-        generateVBAPgainTable2D((float*)pData->loudpkrs_dirs_deg, pData->nLoudpkrs, pData->vbapTableRes[0],
+        generateVBAPgainTable2D((float*)pData->loudpkrs_dirs_deg, pData->nLoudpkrs, pData->vbapTableRes,
                                 &(pData->vbap_gtable), &(pData->N_vbap_gtable), &(pData->nTriangles));
     else{
-        generateVBAPgainTable3D((float*)pData->loudpkrs_dirs_deg, pData->nLoudpkrs, pData->vbapTableRes[0], pData->vbapTableRes[1], 1, 1,
-                                &(pData->vbap_gtable), &(pData->N_vbap_gtable), &(pData->nTriangles));
-        if(pData->vbap_gtable==NULL){
+        vbap_create(&(pData->hVbap), (float*)pData->loudpkrs_dirs_deg, pData->nLoudpkrs, 1, 1, &(pData->nTriangles));
+        if(pData->hVbap==NULL){
             /* if generating vbap gain tabled failed, re-calculate with 2D VBAP */
             pData->output_nDims = 2;
             panner_initGainTables(hPan);
@@ -60,43 +59,13 @@ void panner_initTFT
 )
 {
     panner_data *pData = (panner_data*)(hPan);
-    int t, ch;
     
-    if (pData->hSTFT != NULL){
-        afSTFTfree(pData->hSTFT);
-        pData->hSTFT = NULL;
-        for (t = 0; t<TIME_SLOTS; t++) {
-            for (ch = 0; ch< pData->nSources; ch++) {
-                free(pData->STFTInputFrameTF[t][ch].re);
-                free(pData->STFTInputFrameTF[t][ch].im);
-            }
-            for (ch = 0; ch< pData->nLoudpkrs; ch++) {
-                free(pData->STFTOutputFrameTF[t][ch].re);
-                free(pData->STFTOutputFrameTF[t][ch].im);
-            }
-        }
-        free2d((void**)pData->STFTInputFrameTF, TIME_SLOTS);
-        free2d((void**)pData->STFTOutputFrameTF, TIME_SLOTS);
-        free2d((void**)pData->tempHopFrameTD, MAX(pData->nSources, pData->nLoudpkrs));
-    }
-    if (pData->hSTFT == NULL){
-        afSTFTinit(&(pData->hSTFT), HOP_SIZE, pData->new_nSources, pData->new_nLoudpkrs, 1, 1);
-        pData->STFTInputFrameTF = (complexVector**)malloc2d(TIME_SLOTS, pData->new_nSources, sizeof(complexVector));
-        pData->STFTOutputFrameTF = (complexVector**)malloc2d(TIME_SLOTS, pData->new_nLoudpkrs, sizeof(complexVector));
-        for(t=0; t<TIME_SLOTS; t++) {
-            for(ch=0; ch< pData->new_nSources; ch++) {
-                pData->STFTInputFrameTF[t][ch].re = (float*)calloc(HYBRID_BANDS, sizeof(float));
-                pData->STFTInputFrameTF[t][ch].im = (float*)calloc(HYBRID_BANDS, sizeof(float));
-            }
-            for(ch=0; ch< pData->new_nLoudpkrs; ch++) {
-                pData->STFTOutputFrameTF[t][ch].re = (float*)calloc(HYBRID_BANDS, sizeof(float));
-                pData->STFTOutputFrameTF[t][ch].im = (float*)calloc(HYBRID_BANDS, sizeof(float));
-            }
-        }
-        pData->tempHopFrameTD = (float**)malloc2d( MAX(pData->new_nSources, pData->new_nLoudpkrs), HOP_SIZE, sizeof(float));
-        pData->nSources = pData->new_nSources;
-        pData->nLoudpkrs = pData->new_nLoudpkrs;
-    }
+    /* the afSTFT is allocated for the maximum number of channels once, and the channel counts are changed in-place */
+    if (pData->hSTFT == NULL)
+        afSTFTinit(&(pData->hSTFT), HOP_SIZE, MAX_NUM_INPUTS, MAX_NUM_OUTPUTS, 1, 1);
+    afSTFTchannelChange(pData->hSTFT, pData->new_nSources, pData->new_nLoudpkrs);
+    pData->nSources = pData->new_nSources;
+    pData->nLoudpkrs = pData->new_nLoudpkrs;
 }
 
 void panner_loadPreset(PRESETS preset, float dirs_deg[MAX_NUM_INPUTS][2], int* newNCH, int* nDims)
@@ -65,13 +65,10 @@ extern "C" {
 typedef struct _panner
 {
     /* audio buffers */
-    float inputFrameTD[MAX_NUM_INPUTS][FRAME_SIZE];
-    float outframeTD[NUM_EARS][FRAME_SIZE];
+    float** inputFrameTD;         /* MAX_NUM_INPUTS x FRAME_SIZE */
+    float** outputFrameTD;        /* MAX_NUM_OUTPUTS x FRAME_SIZE */
     float_complex inputframeTF[HYBRID_BANDS][MAX_NUM_INPUTS][TIME_SLOTS];
     float_complex outputframeTF[HYBRID_BANDS][MAX_NUM_OUTPUTS][TIME_SLOTS];
-    complexVector** STFTInputFrameTF;
-    complexVector** STFTOutputFrameTF;
-    float** tempHopFrameTD;
     int fs;
     
     /* time-frequency transform */
@@ -79,8 +76,9 @@ typedef struct _panner
     void* hSTFT;
     
     /* Loudspeaker version */
-    int vbapTableRes[2];
-    float* vbap_gtable; /* N_hrtf_vbap_gtable x nLoudpkrs */
+    int vbapTableRes;   /* azimuthal resolution of the 2-D gain table */
+    float* vbap_gtable; /* 2-D only; N_hrtf_vbap_gtable x nLoudpkrs */
+    void* hVbap;        /* 3-D only; VBAP handle, queried per source direction */
     int N_vbap_gtable;
     int reInitGainTables;
     int reInitTFT;
@@ -36,17 +36,10 @@ void powermap_create
     powermap_data* pData = (powermap_data*)malloc(sizeof(powermap_data));
     if (pData == NULL) { return;/*error*/ }
     *phPm = (void*)pData;
-    int n, i, t, ch, band;
+    int n, i, band;
     
-    afSTFTinit(&(pData->hSTFT), HOP_SIZE, MAX_NUM_SH_SIGNALS, 0, 0, 1);
-    pData->STFTInputFrameTF = (complexVector**)malloc2d(TIME_SLOTS, MAX_NUM_SH_SIGNALS, sizeof(complexVector));
-    for(t=0; t<TIME_SLOTS; t++) {
-        for(ch=0; ch< MAX_NUM_SH_SIGNALS; ch++) {
-            pData->STFTInputFrameTF[t][ch].re = (float*)calloc(HYBRID_BANDS, sizeof(float));
-            pData->STFTInputFrameTF[t][ch].im = (float*)calloc(HYBRID_BANDS, sizeof(float));
-        }
-    }
-    pData->tempHopFrameTD = (float**)malloc2d(MAX_NUM_SH_SIGNALS, HOP_SIZE, sizeof(float));
+    afSTFTinit_analysis(&(pData->hSTFT), HOP_SIZE, MAX_NUM_SH_SIGNALS, 0, 1);
+    pData->SHframeTD = (float**)malloc2d(MAX_NUM_SH_SIGNALS, FRAME_SIZE, sizeof(float));
     
     /* codec data */
     pData->pars = (codecPars*)malloc(sizeof(codecPars));
@@ -60,6 +53,7 @@ void powermap_create
     
     /* internal */
     pData->reInitAna = 1;
+    pData->Ws_order = -1;
     pData->dispWidth = 140;
 
     /* display */
@@ -92,18 +86,11 @@ void powermap_destroy
 {
     powermap_data *pData = (powermap_data*)(*phPm);
     codecPars* pars = pData->pars;
-    int i, t, ch;
+    int i;
     
     if (pData != NULL) {
         afSTFTfree(pData->hSTFT);
-        for (t = 0; t<TIME_SLOTS; t++) {
-            for (ch = 0; ch< MAX_NUM_SH_SIGNALS; ch++) {
-                free(pData->STFTInputFrameTF[t][ch].re);
-                free(pData->STFTInputFrameTF[t][ch].im);
-            }
-        }
-        free2d((void**)pData->STFTInputFrameTF, TIME_SLOTS);
-        free2d((void**)pData->tempHopFrameTD, MAX_NUM_SH_SIGNALS);
+        free2d((void**)pData->SHframeTD, MAX_NUM_SH_SIGNALS);
         
         if(pData->pmap!=NULL)
             free(pData->pmap);
@@ -155,6 +142,7 @@ void powermap_init
     
     /* intialise parameters */
     memset(pData->Cx, 0 , MAX_NUM_SH_SIGNALS*MAX_NUM_SH_SIGNALS*HYBRID_BANDS*sizeof(float_complex));
+    pData->Ws_order = -1;
     if(pData->prev_pmap!=NULL)
         memset(pData->prev_pmap, 0, pars->grid_nDirs*sizeof(float));
     pData->recalcPmap = 1;
@@ -174,11 +162,13 @@ void powermap_analysis
 {
     powermap_data *pData = (powermap_data*)(hPm);
     codecPars* pars = pData->pars;
-    int i, j, t, n, ch, sample, band, nSH_order, order_band, nSH_maxOrder, maxOrder;
-    float C_grp_trace, covScale, pmapEQ_band;
+    int i, j, n, ch, band, nSH_order, order_band, nSH_maxOrder, maxOrder, Ws_nSources;
+    float C_grp_trace, covScale, pmapEQ_band, Ws_beta;
     int o[SH_ORDER+2];
     const float_complex calpha = cmplxf(1.0f, 0.0f), cbeta = cmplxf(0.0f, 0.0f);
     float_complex new_Cx[MAX_NUM_SH_SIGNALS][MAX_NUM_SH_SIGNALS];
+    float_complex snapshots[MAX_NUM_SH_SIGNALS][TIME_SLOTS];
+    float_complex Ws_work[MAX_NUM_SH_SIGNALS];
     float_complex* C_grp;
     
     /* local parameters */
@@ -229,16 +219,7 @@ void powermap_analysis
         }
         
         /* apply the time-frequency transform */
-        for (t = 0; t < TIME_SLOTS; t++) {
-            for (ch = 0; ch < MAX_NUM_SH_SIGNALS; ch++)
-                for (sample = 0; sample < HOP_SIZE; sample++)
-                    pData->tempHopFrameTD[ch][sample] = pData->SHframeTD[ch][sample + t*HOP_SIZE];
-            afSTFTforward(pData->hSTFT, (float**)pData->tempHopFrameTD, (complexVector*)pData->STFTInputFrameTF[t]);
-        }
-        for (band = 0; band < HYBRID_BANDS; band++)
-            for (ch = 0; ch < MAX_NUM_SH_SIGNALS; ch++)
-                for (t = 0; t < TIME_SLOTS; t++)
-                    pData->SHframeTF[band][ch][t] = cmplxf(pData->STFTInputFrameTF[t][ch].re[band], pData->STFTInputFrameTF[t][ch].im[band]);
+        afSTFTforward_frame(pData->hSTFT, pData->SHframeTD, FRAME_SIZE, MAX_NUM_SH_SIGNALS, AFSTFT_BANDS_CH_TIME, (void*)pData->SHframeTF);
 
         /* Update covarience matrix per band */
         covScale = 1.0f/(float)(MAX_NUM_SH_SIGNALS);
@@ -259,17 +240,50 @@ void powermap_analysis
                     pData->Cx[band][i][j] = ccaddf( crmulf(new_Cx[i][j], 1.0f-covAvgCoeff), crmulf(pData->Cx[band][i][j], covAvgCoeff));
         }
         
+        /* determine maximum analysis order */
+        maxOrder = 1;
+        for(i=0; i<HYBRID_BANDS; i++)
+            maxOrder = MAX(maxOrder, MIN(analysisOrderPerBand[i], SH_ORDER));
+        nSH_maxOrder = (maxOrder+1)*(maxOrder+1);
+        
+        /* track the signal sub-space of the grouped covarience matrix, using the snapshots of all bands (weighted in
+         * the same way as when grouping the covarience matrices). Therefore, the MUSIC and MinNorm maps do not require
+         * an eigenvalue decomposition, and their cost per frame is bounded */
+        if(pmap_mode==PM_MODE_MUSIC || pmap_mode==PM_MODE_MINNORM){
+            Ws_nSources = MIN(nSources, nSH_maxOrder/2);
+            if(pData->Ws_order!=maxOrder || pData->Ws_nSources!=Ws_nSources){
+                resetSubspacePASTd(nSH_maxOrder, Ws_nSources, pData->Ws, pData->Ws_d);
+                pData->Ws_order = maxOrder;
+                pData->Ws_nSources = Ws_nSources;
+            }
+            /* the forgetting is applied once per frame, as for the covarience matrices, and the snapshots of all bands
+             * are then accumulated without any further forgetting. Note that the tracker requires some memory, even if
+             * the covarience matrices are not averaged over time */
+            Ws_beta = MAX(covAvgCoeff, MIN_SUBSPACE_AVG_COEFF);
+            for(i=0; i<Ws_nSources; i++)
+                pData->Ws_d[i] *= Ws_beta;
+            for(band=0; band<HYBRID_BANDS; band++){
+                order_band = MAX(MIN(analysisOrderPerBand[band], SH_ORDER),1);
+                nSH_order = (order_band+1)*(order_band+1);
+                pmapEQ_band = MIN(MAX(pmapEQ[band], 0.0f), 2.0f);
+                if(pmapEQ_band<=0.0f)
+                    continue;
+                for(i=0; i<nSH_order; i++)
+                    memcpy(snapshots[i], pData->SHframeTF[band][i], TIME_SLOTS*sizeof(float_complex));
+                for(; i<nSH_maxOrder; i++)
+                    memset(snapshots[i], 0, TIME_SLOTS*sizeof(float_complex));
+                updateSubspacePASTd((float_complex*)snapshots, TIME_SLOTS, nSH_maxOrder, TIME_SLOTS, sqrtf(1e4f*pmapEQ_band*covScale),
+                                    1.0f, Ws_nSources, pData->Ws, pData->Ws_d, Ws_work);
+            }
+        }
+        else
+            pData->Ws_order = -1; /* the tracker is not updated in the other modes, so reset it upon switching back */
+        
         /* update the powermap */
         if(pData->recalcPmap==1){
             pData->recalcPmap = 0;
             pData->pmapReady = 0;
 
-            /* determine maximum analysis order */
-            maxOrder = 1;
-            for(i=0; i<HYBRID_BANDS; i++)
-                maxOrder = MAX(maxOrder, MIN(analysisOrderPerBand[i], SH_ORDER));
-            nSH_maxOrder = (maxOrder+1)*(maxOrder+1);
-
             /* group covarience matrices */
             C_grp = calloc(MAX_NUM_SH_SIGNALS*MAX_NUM_SH_SIGNALS, sizeof(float_complex));
             for (band=0; band<HYBRID_BANDS; band++){
@@ -288,12 +302,12 @@ void powermap_analysis
             switch(pmap_mode){
                 default:
                 case PM_MODE_PWD:
-                    generatePWDmap(maxOrder, C_grp, pars->Y_grid_cmplx[maxOrder-1], pars->grid_nDirs, pData->pmap);
+                    generatePWDmapReal(maxOrder, C_grp, pars->Y_grid[maxOrder-1], pars->grid_nDirs, pData->pmap);
                     break;
 
                 case PM_MODE_MVDR:
                     if(C_grp_trace>1e-8f)
-                        generateMVDRmap(maxOrder, C_grp, pars->Y_grid_cmplx[maxOrder-1], pars->grid_nDirs, 8.0f, pData->pmap, NULL);
+                        generateMVDRmapReal(maxOrder, C_grp, pars->Y_grid[maxOrder-1], pars->grid_nDirs, 8.0f, pData->pmap, NULL);
                     else
                         memset(pData->pmap, 0, pars->grid_nDirs*sizeof(float));
                     break;
@@ -307,14 +321,14 @@ void powermap_analysis
 
                 case PM_MODE_MUSIC:
                     if(C_grp_trace>1e-8f)
-                        generateMUSICmap(maxOrder, C_grp, pars->Y_grid_cmplx[maxOrder-1], nSources, pars->grid_nDirs, 1, pData->pmap);
+                        generateMUSICmapFromSubspace(maxOrder, pData->Ws, pars->Y_grid_cmplx[maxOrder-1], pData->Ws_nSources, pars->grid_nDirs, 1, pData->pmap);
                     else
                         memset(pData->pmap, 0, pars->grid_nDirs*sizeof(float));
                     break;
 
                 case PM_MODE_MINNORM:
                     if(C_grp_trace>1e-8f)
-                        generateMinNormMap(maxOrder, C_grp, pars->Y_grid_cmplx[maxOrder-1], nSources, pars->grid_nDirs, 1, pData->pmap);
+                        generateMinNormMapFromSubspace(maxOrder, pData->Ws, pars->Y_grid_cmplx[maxOrder-1], pData->Ws_nSources, pars->grid_nDirs, 1, pData->pmap);
                     else
                         memset(pData->pmap, 0, pars->grid_nDirs*sizeof(float));
                     break;
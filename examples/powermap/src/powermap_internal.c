@@ -34,14 +34,12 @@ void powermap_initAna(void* const hPm)
     codecPars* pars = pData->pars;
     int i, j, n, N_azi, N_ele, nSH_order;
     float scaleY, hfov, vfov, fi, aspectRatio;
-    float* Y_grid_N, *grid_x_axis, *grid_y_axis;
+    float *grid_x_axis, *grid_y_axis;
     
     /* Store Y_grid per order */
-	Y_grid_N = NULL;
     int geosphere_ico_freq = 9;
     pars->grid_dirs_deg = (float*)__HANDLES_geosphere_ico_dirs_deg[geosphere_ico_freq];
     pars->grid_nDirs = __geosphere_ico_nPoints[geosphere_ico_freq];
-    getRSH(SH_ORDER, pars->grid_dirs_deg, pars->grid_nDirs, &Y_grid_N);
     for(n=1; n<=SH_ORDER; n++){
         nSH_order = (n+1)*(n+1);
         scaleY = 1.0f/(float)nSH_order;
@@ -49,11 +47,7 @@ void powermap_initAna(void* const hPm)
         free(pars->Y_grid_cmplx[n-1]);
         pars->Y_grid[n-1] = malloc(nSH_order * (pars->grid_nDirs)*sizeof(float));
         pars->Y_grid_cmplx[n-1] = malloc(nSH_order * (pars->grid_nDirs)*sizeof(float_complex));
-        memcpy(pars->Y_grid[n-1], Y_grid_N, nSH_order * (pars->grid_nDirs)*sizeof(float));
-        utility_svsmul(pars->Y_grid[n-1], &scaleY, nSH_order * (pars->grid_nDirs), NULL);
-        for(i=0; i<nSH_order; i++)
-            for(j=0; j<pars->grid_nDirs; j++)
-                pars->Y_grid_cmplx[n-1][i*(pars->grid_nDirs)+j] = cmplxf(pars->Y_grid[n-1][i*(pars->grid_nDirs)+j], 0.0f);
+        getRSH_batch(n, pars->grid_dirs_deg, pars->grid_nDirs, scaleY, 1, pars->Y_grid[n-1], pars->Y_grid_cmplx[n-1]); /* called from the process callback, so no worker threads are spawned */
     }
 
     /* generate interpolation table for current display settings */
@@ -96,7 +90,6 @@ void powermap_initAna(void* const hPm)
         pData->pmap_grid[i] = calloc(pars->interp_nDirs,sizeof(float));
     }
     
-    free(Y_grid_N);
     free(grid_x_axis);
     free(grid_y_axis);
 }
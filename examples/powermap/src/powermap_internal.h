@@ -52,6 +52,7 @@ extern "C" {
 #define MAX_NUM_SH_SIGNALS ( (SH_ORDER+1)*(SH_ORDER+1) )
 #define NUM_DISP_SLOTS ( 2 )
 #define MAX_COV_AVG_COEFF ( 0.45f )                         /*  */
+#define MIN_SUBSPACE_AVG_COEFF ( 0.5f )                     /* minimum averaging (per frame) for the sub-space tracker */
     
     
 /***********/
@@ -75,16 +76,18 @@ typedef struct _codecPars
 typedef struct _powermap
 {
     /* TFT */
-    float SHframeTD[MAX_NUM_SH_SIGNALS][FRAME_SIZE];
+    float** SHframeTD;            /* MAX_NUM_SH_SIGNALS x FRAME_SIZE */
     float_complex SHframeTF[HYBRID_BANDS][MAX_NUM_SH_SIGNALS][TIME_SLOTS];        
     void* hSTFT;
-    complexVector** STFTInputFrameTF;
-    float** tempHopFrameTD;
     float freqVector[HYBRID_BANDS];
     float fs;
     
     /* internal */
     float_complex Cx[HYBRID_BANDS][MAX_NUM_SH_SIGNALS][MAX_NUM_SH_SIGNALS];     /* cov matrices */ 
+    float_complex Ws[(MAX_NUM_SH_SIGNALS/2)*MAX_NUM_SH_SIGNALS]; /* tracked signal sub-space of the grouped cov matrix (for MUSIC/MinNorm); FLAT: Ws_nSources x nSH */
+    float Ws_d[MAX_NUM_SH_SIGNALS/2];                        /* tracked eigenvalues; Ws_nSources x 1 */
+    int Ws_order;                                            /* analysis order the tracker was reset for, -1: reset required */
+    int Ws_nSources;                                         /* sub-space dimension the tracker was reset for */
     int reInitAna; /* 0: no init required, 1: init required, 2: init in progress */
     int dispWidth;
     
@@ -48,6 +48,21 @@ void rotator_process(void* const hRot,                  /* rotator handle */
                      int nOutputs,                      /* number of channels in 'outputs' matrix */
                      int nSamples,                      /* number of samples in 'inputs' matrix */
 	                 int isPlaying);                    /* set to 1 if there is audio in the buffers */
+    
+/* rotates the same SH signals towards several listener orientations at once (e.g. for a number of head-tracked
+ * listeners). The yaw, pitch and roll of each listener are given in degrees, and the flip options apply to them too. A
+ * listener keeps its rotation matrix between calls, and it is only recomputed (and faded to over the frame) once its
+ * orientation changes. The orientation set in the rotator_setYaw/Pitch/Roll functions is not used.
+ * At most 16 listeners (see rotator_getMaxNumListeners()) are rotated; the outputs of any further listeners are zeroed */
+void rotator_processMulti(void* const hRot,             /* rotator handle */
+                          float** const inputs,         /* input channels, [nInputs][nSampes] */
+                          float*** const outputs,       /* output channels, [nListeners][nOutputs][nSampes] */
+                          float* ypr,                   /* yaw-pitch-roll of each listener in degrees; FLAT: nListeners x 3 */
+                          int nListeners,               /* number of listeners; only the first 16 are rotated */
+                          int nInputs,                  /* number of channels in 'inputs' matrix */
+                          int nOutputs,                 /* number of channels in each listener's 'outputs' matrix */
+                          int nSamples,                 /* number of samples in 'inputs' matrix */
+                          int isPlaying);               /* set to 1 if there is audio in the buffers */
 
 /* SETS */
 
@@ -85,6 +100,9 @@ int rotator_getFlipRoll(void* const hRot);
 int rotator_getChOrder(void* const hRot);
 
 int rotator_getNormType(void* const hRot);
+    
+/* returns the maximum number of listeners rotated by rotator_processMulti (16) */
+int rotator_getMaxNumListeners(void);
 
     
 #ifdef __cplusplus
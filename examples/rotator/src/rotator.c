@@ -33,6 +33,8 @@ void rotator_create
 )
 {
     rotator_data* pData = (rotator_data*)malloc(sizeof(rotator_data));
+    int i;
+    float Rxyz[3][3];
     if (pData == NULL) { return;/*error*/ }
     *phRot = (void*)pData;
   
@@ -45,6 +47,19 @@ void rotator_create
     pData->bFlipRoll = 0;
     pData->chOrdering = CH_ACN;
     pData->norm = NORM_N3D;
+    
+    /* rotation matrix of the default orientation */
+    yawPitchRoll2Rzyx (pData->yaw, pData->pitch, pData->roll, Rxyz);
+    getSHrotMtxReal_blocks(Rxyz, pData->M_rot_blocks, SH_ORDER);
+    pData->recalc_M_rotFLAG = 0;
+    
+    /* all listeners also start at the default orientation */
+    for(i=0; i<MAX_NUM_LISTENERS; i++){
+        memcpy(pData->M_rot_blocks_ls[i], pData->M_rot_blocks, SH_ROT_BLOCKS_LENGTH(SH_ORDER)*sizeof(float));
+        memset(pData->ypr_ls[i], 0, 3*sizeof(float));
+        pData->pBlocks_ls[i] = pData->M_rot_blocks_ls[i];
+        pData->ppOutputs_ls[i] = pData->pOutputs_ls[i];
+    }
 }
 
 
@@ -85,55 +100,32 @@ void rotator_process
 )
 {
     rotator_data *pData = (rotator_data*)(hRot);
-    int i, n, ch;
-    int o[SH_ORDER+2];
-    float Rxyz[3][3], M_rot[NUM_SH_SIGNALS][NUM_SH_SIGNALS];
+    int i;
+    float Rxyz[3][3];
     CH_ORDER chOrdering;
-    NORM_TYPES norm;
  
     if (nSamples == FRAME_SIZE && isPlaying) {
         /* prep */
-        for(n=0; n<SH_ORDER+2; n++){  o[n] = n*n;  }
         chOrdering = pData->chOrdering;
-        norm = pData->norm;
 		for (i = 0; i < MIN(NUM_SH_SIGNALS, nInputs); i++)
 			memcpy(pData->inputFrameTD[i], inputs[i], FRAME_SIZE * sizeof(float));
 		for (; i < NUM_SH_SIGNALS; i++)
 			memset(pData->inputFrameTD[i], 0, FRAME_SIZE * sizeof(float));
         
-        /* account for norm scheme */
-        switch(norm){
-            case NORM_N3D: /* already N3D */
-                break;
-            case NORM_SN3D: /* convert to N3D before rotation */
-                for (n = 0; n<SH_ORDER+1; n++)
-                    for (ch = o[n]; ch<o[n+1]; ch++)
-                        for(i = 0; i<FRAME_SIZE; i++)
-                            pData->outputFrameTD[ch][i] *= sqrtf(2.0f*(float)n+1.0f);
-                break;
-        }
-        
-        /* calculate rotation matrix */
-        yawPitchRoll2Rzyx (pData->yaw, pData->pitch, pData->roll, Rxyz);
-        getSHrotMtxReal(Rxyz, (float*)M_rot, SH_ORDER);
-        
-        /* apply rotation (assumes ACN/N3D) */
-        cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, NUM_SH_SIGNALS, FRAME_SIZE, NUM_SH_SIGNALS, 1.0f,
-                    (float*)M_rot, NUM_SH_SIGNALS,
-                    (float*)pData->inputFrameTD, FRAME_SIZE, 0.0f,
-                    (float*)pData->outputFrameTD, FRAME_SIZE);
-        
-        /* account for norm scheme */
-        switch(norm){
-            case NORM_N3D: /* already N3D */
-                break;
-            case NORM_SN3D: /* convert back to SN3D after rotation */
-                for (n = 0; n<SH_ORDER+1; n++)
-                    for (ch = o[n]; ch<o[n+1]; ch++)
-                        for(i = 0; i<FRAME_SIZE; i++)
-                            pData->outputFrameTD[ch][i] /= sqrtf(2.0f*(float)n+1.0f);
-                break;
+        /* apply rotation (assumes ACN), order by order. The norm scheme needs no conversion, since the N3D/SN3D
+         * scaling is the same for all channels of an order, and the rotation does not mix channels of different orders */
+        if(pData->recalc_M_rotFLAG){
+            /* recalculate rotation matrix (only its non-zero per-order blocks) only if the orientation has changed,
+             * and fade from the previous matrix to the new one over this frame */
+            pData->recalc_M_rotFLAG = 0;
+            memcpy(pData->M_rot_blocks_prev, pData->M_rot_blocks, SH_ROT_BLOCKS_LENGTH(SH_ORDER)*sizeof(float));
+            yawPitchRoll2Rzyx (pData->yaw, pData->pitch, pData->roll, Rxyz);
+            getSHrotMtxReal_blocks(Rxyz, pData->M_rot_blocks, SH_ORDER);
+            applySHrotMtxReal_blocks_xfade(pData->M_rot_blocks_prev, pData->M_rot_blocks, SH_ORDER,
+                                           (float*)pData->inputFrameTD, FRAME_SIZE, (float*)pData->outputFrameTD);
         }
+        else
+            applySHrotMtxReal_blocks(pData->M_rot_blocks, SH_ORDER, (float*)pData->inputFrameTD, FRAME_SIZE, (float*)pData->outputFrameTD);
         for (i=0; i < MIN(NUM_SH_SIGNALS, nOutputs); i++)
             memcpy(outputs[i], pData->outputFrameTD[i], FRAME_SIZE*sizeof(float));
         for (; i < nOutputs; i++)
@@ -142,6 +134,71 @@ void rotator_process
     else{
         for (i=0; i < nOutputs; i++)
             memset(outputs[i], 0, FRAME_SIZE*sizeof(float));
+    }
+}
+
+void rotator_processMulti
+(
+    void   *  const hRot,
+    float  ** const inputs,
+    float *** const outputs,
+    float   *       ypr,
+    int             nListeners,
+    int             nInputs,
+    int             nOutputs,
+    int             nSamples,
+    int             isPlaying
+)
+{
+    rotator_data *pData = (rotator_data*)(hRot);
+    int i, k, nRotated;
+    float yaw, pitch, roll;
+    float Rxyz[3][3];
+    
+    /* only the first MAX_NUM_LISTENERS listeners are rotated, the outputs of any others are zeroed */
+    nRotated = MIN(nListeners, MAX_NUM_LISTENERS);
+    if (nSamples == FRAME_SIZE && isPlaying) {
+        /* prep */
+        for (i = 0; i < MIN(NUM_SH_SIGNALS, nInputs); i++)
+            memcpy(pData->inputFrameTD[i], inputs[i], FRAME_SIZE * sizeof(float));
+        for (; i < NUM_SH_SIGNALS; i++)
+            memset(pData->inputFrameTD[i], 0, FRAME_SIZE * sizeof(float));
+        
+        for(k=0; k<nRotated; k++){
+            /* recalculate the rotation matrix of a listener only if its orientation has changed */
+            yaw = pData->bFlipYaw == 1 ? -DEG2RAD(ypr[k*3]) : DEG2RAD(ypr[k*3]);
+            pitch = pData->bFlipPitch == 1 ? -DEG2RAD(ypr[k*3+1]) : DEG2RAD(ypr[k*3+1]);
+            roll = pData->bFlipRoll == 1 ? -DEG2RAD(ypr[k*3+2]) : DEG2RAD(ypr[k*3+2]);
+            if(yaw != pData->ypr_ls[k][0] || pitch != pData->ypr_ls[k][1] || roll != pData->ypr_ls[k][2]){
+                pData->ypr_ls[k][0] = yaw;
+                pData->ypr_ls[k][1] = pitch;
+                pData->ypr_ls[k][2] = roll;
+                memcpy(pData->M_rot_blocks_ls_prev[k], pData->M_rot_blocks_ls[k], SH_ROT_BLOCKS_LENGTH(SH_ORDER)*sizeof(float));
+                yawPitchRoll2Rzyx (yaw, pitch, roll, Rxyz);
+                getSHrotMtxReal_blocks(Rxyz, pData->M_rot_blocks_ls[k], SH_ORDER);
+                pData->pBlocks_ls_prev[k] = pData->M_rot_blocks_ls_prev[k];
+            }
+            else
+                pData->pBlocks_ls_prev[k] = NULL;
+            
+            /* rotate straight into the host buffers; surplus SH channels are not computed */
+            for (i=0; i < NUM_SH_SIGNALS; i++)
+                pData->pOutputs_ls[k][i] = i < nOutputs ? outputs[k][i] : NULL;
+            for (i=NUM_SH_SIGNALS; i < nOutputs; i++)
+                memset(outputs[k][i], 0, FRAME_SIZE*sizeof(float));
+        }
+        
+        /* apply rotations (assumes ACN), for all listeners in a single pass over the input */
+        applySHrotMtxReal_blocks_multi(pData->pBlocks_ls, pData->pBlocks_ls_prev, nRotated, SH_ORDER,
+                                       (float*)pData->inputFrameTD, FRAME_SIZE, pData->ppOutputs_ls);
+        for(k=nRotated; k<nListeners; k++)
+            for (i=0; i < nOutputs; i++)
+                memset(outputs[k][i], 0, FRAME_SIZE*sizeof(float));
+    }
+    else{
+        for(k=0; k<nListeners; k++)
+            for (i=0; i < nOutputs; i++)
+                memset(outputs[k][i], 0, FRAME_SIZE*sizeof(float));
     }
 }
 
@@ -149,18 +206,21 @@ void rotator_setYaw(void  * const hRot, float newYaw)
 {
     rotator_data *pData = (rotator_data*)(hRot);
     pData->yaw = pData->bFlipYaw == 1 ? -DEG2RAD(newYaw) : DEG2RAD(newYaw);
+    pData->recalc_M_rotFLAG = 1;
 }
 
 void rotator_setPitch(void* const hRot, float newPitch)
 {
     rotator_data *pData = (rotator_data*)(hRot);
     pData->pitch = pData->bFlipPitch == 1 ? -DEG2RAD(newPitch) : DEG2RAD(newPitch);
+    pData->recalc_M_rotFLAG = 1;
 }
 
 void rotator_setRoll(void* const hRot, float newRoll)
 {
     rotator_data *pData = (rotator_data*)(hRot);
     pData->roll = pData->bFlipRoll == 1 ? -DEG2RAD(newRoll) : DEG2RAD(newRoll);
+    pData->recalc_M_rotFLAG = 1;
 }
 
 void rotator_setFlipYaw(void* const hRot, int newState)
@@ -252,6 +312,11 @@ int rotator_getNormType(void* const hRot)
     return (int)pData->norm;
 }
 
+int rotator_getMaxNumListeners(void)
+{
+    return MAX_NUM_LISTENERS;
+}
+
 
 
 
@@ -38,6 +38,7 @@ extern "C" {
 #endif
 
 #define NUM_SH_SIGNALS ( (SH_ORDER + 1)*(SH_ORDER + 1)  )    /* (L+1)^2 */
+#define MAX_NUM_LISTENERS ( 16 )                             /* maximum number of orientations for rotator_processMulti */
     
 #ifndef DEG2RAD
   #define DEG2RAD(x) (x * PI / 180.0f)
@@ -59,6 +60,18 @@ typedef struct _rotator
 {
     float inputFrameTD[NUM_SH_SIGNALS][FRAME_SIZE];
     float outputFrameTD[NUM_SH_SIGNALS][FRAME_SIZE];
+    float M_rot_blocks[SH_ROT_BLOCKS_LENGTH(SH_ORDER)]; /* non-zero per-order blocks of the rotation matrix */
+    float M_rot_blocks_prev[SH_ROT_BLOCKS_LENGTH(SH_ORDER)]; /* the blocks of the previous orientation, to fade from */
+    int recalc_M_rotFLAG;                               /* 1: the orientation has changed since the last frame */
+    
+    /* multi-listener rotation */
+    float M_rot_blocks_ls[MAX_NUM_LISTENERS][SH_ROT_BLOCKS_LENGTH(SH_ORDER)];      /* per-order blocks, per listener */
+    float M_rot_blocks_ls_prev[MAX_NUM_LISTENERS][SH_ROT_BLOCKS_LENGTH(SH_ORDER)]; /* previous blocks, per listener */
+    float ypr_ls[MAX_NUM_LISTENERS][3];                 /* current orientation of each listener, radians */
+    float* pBlocks_ls[MAX_NUM_LISTENERS];               /* pointers passed to applySHrotMtxReal_blocks_multi */
+    float* pBlocks_ls_prev[MAX_NUM_LISTENERS];          /* NULL for the listeners whose orientation has not changed */
+    float* pOutputs_ls[MAX_NUM_LISTENERS][NUM_SH_SIGNALS]; /* output channels of each listener */
+    float** ppOutputs_ls[MAX_NUM_LISTENERS];
 
     /* user parameters */
     float yaw, roll, pitch;
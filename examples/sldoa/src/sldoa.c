@@ -45,17 +45,10 @@ void sldoa_create
     sldoa_data* pData = (sldoa_data*)malloc(sizeof(sldoa_data));
     if (pData == NULL) { return;/*error*/ }
     *phSld = (void*)pData;
-    int i, j, t, ch, band;
+    int i, j, band;
     
-    afSTFTinit(&(pData->hSTFT), HOP_SIZE, NUM_SH_SIGNALS, 0, 0, 1);
-    pData->STFTInputFrameTF = (complexVector**)malloc2d(TIME_SLOTS, NUM_SH_SIGNALS, sizeof(complexVector));
-    for(t=0; t<TIME_SLOTS; t++) {
-        for(ch=0; ch< NUM_SH_SIGNALS; ch++) {
-            pData->STFTInputFrameTF[t][ch].re = (float*)calloc(HYBRID_BANDS, sizeof(float));
-            pData->STFTInputFrameTF[t][ch].im = (float*)calloc(HYBRID_BANDS, sizeof(float));
-        }
-    }
-    pData->tempHopFrameTD = (float**)malloc2d(NUM_SH_SIGNALS, HOP_SIZE, sizeof(float));
+    afSTFTinit_analysis(&(pData->hSTFT), HOP_SIZE, NUM_SH_SIGNALS, 0, 1);
+    pData->SHframeTD = (float**)malloc2d(NUM_SH_SIGNALS, FRAME_SIZE, sizeof(float));
     
     /* internal */
     pData->reInitAna = 1;
@@ -96,18 +89,11 @@ void sldoa_destroy
 )
 {
     sldoa_data *pData = (sldoa_data*)(*phSld);
-    int i, t, ch;
+    int i;
 
     if (pData != NULL) {
         afSTFTfree(pData->hSTFT);
-        for (t = 0; t<TIME_SLOTS; t++) {
-            for (ch = 0; ch< NUM_SH_SIGNALS; ch++) {
-                free(pData->STFTInputFrameTF[t][ch].re);
-                free(pData->STFTInputFrameTF[t][ch].im);
-            }
-        }
-        free2d((void**)pData->STFTInputFrameTF, TIME_SLOTS);
-        free2d((void**)pData->tempHopFrameTD, NUM_SH_SIGNALS);
+        free2d((void**)pData->SHframeTD, NUM_SH_SIGNALS);
         for(i=0; i<NUM_DISP_SLOTS; i++){
             free(pData->azi_deg[i]);
             free(pData->elev_deg[i]);
@@ -166,7 +152,7 @@ void sldoa_analysis
 )
 {
 	sldoa_data *pData = (sldoa_data*)(hSld);
-    int i, j, t, n, ch, sample, band, nSectors, min_band, numAnalysisBands, current_disp_idx;
+    int i, j, t, n, ch, band, nSectors, min_band, numAnalysisBands, current_disp_idx;
     float avgCoeff, max_en[HYBRID_BANDS], min_en[HYBRID_BANDS];
     float new_doa[MAX_NUM_SECTORS][TIME_SLOTS][2], new_doa_xyz[3], doa_xyz[3], avg_xyz[3];
     float new_energy[MAX_NUM_SECTORS][TIME_SLOTS];
@@ -216,16 +202,7 @@ void sldoa_analysis
         }
         
         /* apply the time-frequency transform */
-        for (t = 0; t < TIME_SLOTS; t++) {
-            for (ch = 0; ch < NUM_SH_SIGNALS; ch++)
-                for (sample = 0; sample < HOP_SIZE; sample++)
-                    pData->tempHopFrameTD[ch][sample] = pData->SHframeTD[ch][sample + t*HOP_SIZE];
-            afSTFTforward(pData->hSTFT, (float**)pData->tempHopFrameTD, (complexVector*)pData->STFTInputFrameTF[t]);
-        }
-        for (band = 0; band < HYBRID_BANDS; band++)
-            for (ch = 0; ch < NUM_SH_SIGNALS; ch++)
-                for (t = 0; t < TIME_SLOTS; t++)
-                    pData->SHframeTF[band][ch][t] = cmplxf(pData->STFTInputFrameTF[t][ch].re[band], pData->STFTInputFrameTF[t][ch].im[band]);
+        afSTFTforward_frame(pData->hSTFT, pData->SHframeTD, FRAME_SIZE, NUM_SH_SIGNALS, AFSTFT_BANDS_CH_TIME, (void*)pData->SHframeTF);
         
         /* apply sector-based, frequency-dependent DOA analysis */
         numAnalysisBands = 0;
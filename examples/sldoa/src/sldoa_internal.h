@@ -73,11 +73,9 @@ extern "C" {
 typedef struct _sldoa
 {
     /* TFT */
-    float SHframeTD[NUM_SH_SIGNALS][FRAME_SIZE]; 
+    float** SHframeTD;            /* NUM_SH_SIGNALS x FRAME_SIZE */
     float_complex SHframeTF[HYBRID_BANDS][NUM_SH_SIGNALS][TIME_SLOTS];
     void* hSTFT;
-    complexVector** STFTInputFrameTF;
-    float** tempHopFrameTD;
     float freqVector[HYBRID_BANDS];
     float fs;
       
@@ -41,23 +41,11 @@ void upmix_create
     upmix_data* pData = (upmix_data*)malloc(sizeof(upmix_data));
     if (pData == NULL) { return;/*error*/ }
     *phUpmx = (void*)pData;
-    int t, ch;
     
     /* time-frequency transform + buffers */
     afSTFTinit(&(pData->hSTFT), HOP_SIZE, MAX_NUM_INPUT_CHANNELS, MAX_NUM_OUTPUT_CHANNELS, 0, 1);
-    pData->STFTInputFrameTF = (complexVector**)malloc2d(TIME_SLOTS, MAX_NUM_INPUT_CHANNELS, sizeof(complexVector));
-    pData->STFTOutputFrameTF = (complexVector**)malloc2d(TIME_SLOTS, MAX_NUM_OUTPUT_CHANNELS, sizeof(complexVector));
-    for(t=0; t<TIME_SLOTS; t++) {
-        for(ch=0; ch< MAX_NUM_INPUT_CHANNELS; ch++) {
-            pData->STFTInputFrameTF[t][ch].re = (float*)calloc(HYBRID_BANDS, sizeof(float));
-            pData->STFTInputFrameTF[t][ch].im = (float*)calloc(HYBRID_BANDS, sizeof(float));
-        }
-        for(ch=0; ch< MAX_NUM_OUTPUT_CHANNELS; ch++) {
-            pData->STFTOutputFrameTF[t][ch].re = (float*)calloc(HYBRID_BANDS, sizeof(float));
-            pData->STFTOutputFrameTF[t][ch].im = (float*)calloc(HYBRID_BANDS, sizeof(float));
-        }
-    }
-    pData->tempHopFrameTD = (float**)malloc2d( MAX(MAX_NUM_OUTPUT_CHANNELS, MAX_NUM_INPUT_CHANNELS), HOP_SIZE, sizeof(float));
+    pData->inputFrameTD = (float**)malloc2d(MAX_NUM_INPUT_CHANNELS, FRAME_SIZE, sizeof(float));
+    pData->outframeTD = (float**)malloc2d(MAX_NUM_OUTPUT_CHANNELS, FRAME_SIZE, sizeof(float));
     
     /* internal parameters */
     pData->reInitCodec = 1;
@@ -82,23 +70,12 @@ void upmix_destroy
 )
 {
     upmix_data *pData = (upmix_data*)(*phUpmx);
-    int t, ch;
 
     if (pData != NULL) {
         afSTFTfree(pData->hSTFT);
-        for (t = 0; t<TIME_SLOTS; t++) {
-            for(ch=0; ch< MAX_NUM_INPUT_CHANNELS; ch++) {
-                free(pData->STFTInputFrameTF[t][ch].re);
-                free(pData->STFTInputFrameTF[t][ch].im);
-            }
-            for (ch = 0; ch<MAX_NUM_OUTPUT_CHANNELS; ch++) {
-                free(pData->STFTOutputFrameTF[t][ch].re);
-                free(pData->STFTOutputFrameTF[t][ch].im);
-            }
-        }
-        free2d((void**)pData->STFTInputFrameTF, TIME_SLOTS);
-        free2d((void**)pData->STFTOutputFrameTF, TIME_SLOTS);
-        free2d((void**)pData->tempHopFrameTD, MAX(MAX_NUM_INPUT_CHANNELS, MAX_NUM_OUTPUT_CHANNELS));
+        free2d((void**)pData->inputFrameTD, MAX_NUM_INPUT_CHANNELS);
+        free2d((void**)pData->outframeTD, MAX_NUM_OUTPUT_CHANNELS);
+        destroyVBAPsparseTable(&(pData->pars->grid_vbap_gtable));
  
         free(pData);
         pData = NULL;
@@ -146,7 +123,7 @@ void upmix_process
 {
     upmix_data *pData = (upmix_data*)(hUpmx);
     codecPars* pars = pData->pars;
-    int t, sample, ch, i, j, k, band, grpband, num_grpBands, idx2D, ls;
+    int t, ch, i, j, k, band, grpband, num_grpBands, idx2D, ls;
     int* grp_bands;
     float est_dir, dummy;
     double Cx_grp00, Cx_grp11, ICC_01, A1, A2, B, C, src_en, diff_en, src_diff_en, w_denom;
@@ -186,16 +163,7 @@ void upmix_process
             memset(pData->inputFrameTD[i], 0, FRAME_SIZE * sizeof(float));
         
         /* Apply time-frequency transform (TFT) */
-        for ( t=0; t< TIME_SLOTS; t++) {
-            for( ch=0; ch < MAX_NUM_INPUT_CHANNELS; ch++)
-                for ( sample=0; sample < HOP_SIZE; sample++)
-                    pData->tempHopFrameTD[ch][sample] = pData->inputFrameTD[ch][sample + t*HOP_SIZE];
-            afSTFTforward(pData->hSTFT, (float**)pData->tempHopFrameTD, (complexVector*)pData->STFTInputFrameTF[t]);
-        }
-        for(band=0; band<HYBRID_BANDS; band++)
-            for( ch=0; ch < MAX_NUM_INPUT_CHANNELS; ch++)
-                for ( t=0; t<TIME_SLOTS; t++)
-                    pData->inputframeTF[band][ch][t] = cmplxf(pData->STFTInputFrameTF[t][ch].re[band], pData->STFTInputFrameTF[t][ch].im[band]);
+        afSTFTforward_frame(pData->hSTFT, pData->inputFrameTD, FRAME_SIZE, MAX_NUM_INPUT_CHANNELS, AFSTFT_BANDS_CH_TIME, (void*)pData->inputframeTF);
    
         /* update covarience matrix per band */
         for(band=0; band<HYBRID_BANDS; band++){
@@ -266,10 +234,11 @@ void upmix_process
             w_diff[1][1] = (src_diff_en + diff_en*diff_en)/w_denom;
             
             for(band=0; band<num_grpBands; band++){
-                /* Pull loudspeaker gains from vbap table */
+                /* Pull loudspeaker gains from the sparse vbap table */
                 idx2D = (int)((matlab_fmodf(est_dir+180.0f,360.0f)/pars->vbap_azi_res)+0.5f);
-                for (ls = 0; ls < nLoudspeakers; ls++)
-                    gains2D[ls] = (double)pars->grid_vbap_gtable[idx2D*nLoudspeakers+ls];
+                memset(gains2D, 0, nLoudspeakers*sizeof(double));
+                for (i = pars->grid_vbap_gtable->rowPtr[idx2D]; i < pars->grid_vbap_gtable->rowPtr[idx2D+1]; i++)
+                    gains2D[pars->grid_vbap_gtable->colIdx[i]] = (double)pars->grid_vbap_gtable->gains[i];
                  
                 /* apply pValue normalisation (i.e. amplitude normalises the VBAP gains for low frequencies depending on room) */
                 pv_f = pData->pValues[grp_bands[band]];
@@ -341,23 +310,11 @@ void upmix_process
         }
         
         /* inverse-TFT */
-        for (band = 0; band < HYBRID_BANDS; band++) {
-            for (ch = 0; ch < MAX_NUM_OUTPUT_CHANNELS; ch++) {
-                for (t = 0; t < TIME_SLOTS; t++) {
-                    pData->STFTOutputFrameTF[t][ch].re[band] = crealf(pData->outputframeTF[band][ch][t]);
-                    pData->STFTOutputFrameTF[t][ch].im[band] = cimagf(pData->outputframeTF[band][ch][t]);
-                }
-            }
-        }
-        for (t = 0; t < TIME_SLOTS; t++) {
-            afSTFTinverse(pData->hSTFT, pData->STFTOutputFrameTF[t], pData->tempHopFrameTD);
-            for (ch = 0; ch < MIN(MAX_NUM_OUTPUT_CHANNELS, nOutputs); ch++)
-                for (sample = 0; sample < HOP_SIZE; sample++)
-                    outputs[ch][sample + t* HOP_SIZE] = pData->tempHopFrameTD[ch][sample];
-            for (; ch < nOutputs; ch++)
-                for (sample = 0; sample < HOP_SIZE; sample++)
-                    outputs[ch][sample + t* HOP_SIZE] = 0.0f;
-        }
+        afSTFTinverse_frame(pData->hSTFT, (void*)pData->outputframeTF, MAX_NUM_OUTPUT_CHANNELS, AFSTFT_BANDS_CH_TIME, FRAME_SIZE, pData->outframeTD);
+        for (ch = 0; ch < MIN(MAX_NUM_OUTPUT_CHANNELS, nOutputs); ch++)
+            memcpy(outputs[ch], pData->outframeTD[ch], FRAME_SIZE * sizeof(float));
+        for (; ch < nOutputs; ch++)
+            memset(outputs[ch], 0, FRAME_SIZE * sizeof(float));
     }
     else{
         for (ch=0; ch < nOutputs; ch++)
@@ -115,8 +115,8 @@ void upmix_initCodec
     for(i=0; i<pData->nLoudspeakers; i++)
         for(j=0; j<2; j++)
             pData->loudpkrs_dirs_deg[i][j] = __5pX_dirs_deg[i][j]; /* only stereo to 5.x is currently supported */
-    free(pars->grid_vbap_gtable);
-    generateVBAPgainTable2D((float*)pData->loudpkrs_dirs_deg, pData->nLoudspeakers, pars->vbap_azi_res , &(pars->grid_vbap_gtable), &(pars->grid_N_vbap_gtable), &(pars->grid_nPairs));
+    destroyVBAPsparseTable(&(pars->grid_vbap_gtable));
+    generateVBAPgainTable2D_sparse((float*)pData->loudpkrs_dirs_deg, pData->nLoudspeakers, pars->vbap_azi_res, &(pars->grid_vbap_gtable), &(pars->grid_nPairs));
     
     /* define band grouping */
     pars->maxGrpFreq = MAX_GROUP_FREQ;
@@ -33,6 +33,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <float.h>
 #include "upmix.h"
 #include "upmix_database.h"
 #define SAF_ENABLE_VBAP     /* for VBAP gains */
@@ -64,9 +65,8 @@ extern "C" {
 typedef struct _codecPars
 {
     /* 2D VBAP gain table */
-    float* grid_vbap_gtable;                           /* 2D gain table to pan the source signal to estimated azimuth */
+    vbapSparseTable* grid_vbap_gtable;                 /* sparse 2D gain table to pan the source signal to estimated azimuth */
     int grid_nPairs;                                   /* number of loudspeaker pairs in vbap gain table */
-    int grid_N_vbap_gtable;                            /* number of grid directions in vbap gain table */
     int vbap_azi_res;                                  /* azimuth step size in degrees; (min: 1) */
     
     /* band grouping */
@@ -86,13 +86,10 @@ typedef struct _codecPars
 typedef struct _upmix
 {
     /* temporary audio buffers */
-    float inputFrameTD[MAX_NUM_INPUT_CHANNELS][FRAME_SIZE];
-    float outframeTD[MAX_NUM_OUTPUT_CHANNELS][FRAME_SIZE];
+    float** inputFrameTD;         /* MAX_NUM_INPUT_CHANNELS x FRAME_SIZE */
+    float** outframeTD;           /* MAX_NUM_OUTPUT_CHANNELS x FRAME_SIZE */
     float_complex inputframeTF[HYBRID_BANDS][MAX_NUM_INPUT_CHANNELS][TIME_SLOTS];
     float_complex outputframeTF[HYBRID_BANDS][MAX_NUM_OUTPUT_CHANNELS][TIME_SLOTS];
-    complexVector** STFTInputFrameTF;
-    complexVector** STFTOutputFrameTF;
-    float** tempHopFrameTD;
     int fs;
     
     /* circular buffer for delaying input signal */
@@ -36,12 +36,25 @@ typedef struct
     
 } complexVector;
 
+/* Layouts of the frequency-domain data taken/returned by afSTFTforward_frame() and afSTFTinverse_frame(). Note that
+ * "nChannels" is the channel dimension of the caller's array, which may be larger than the number of channels of the
+ * afSTFT handle; any additional channels are left untouched. "nHops" is framesize/hopSize, and "nBands" is
+ * hopSize+5 with the hybrid mode enabled, and hopSize+1 otherwise. */
+typedef enum _AFSTFT_FDDATA_FORMAT{
+    AFSTFT_BANDS_CH_TIME,        /* float_complex, band-major:       [nBands][nChannels][nHops] */
+    AFSTFT_CH_TIME_BANDS,        /* float_complex, channel-major:    [nChannels][nHops][nBands] */
+    AFSTFT_CH_TIME_BANDS_SPLIT   /* complexVector[nChannels], where the .re and .im vectors are: [nHops][nBands] */
+    
+}AFSTFT_FDDATA_FORMAT;
+
 
 typedef struct
 {
     int inChannels;
     int outChannels;
     int maxChannels;
+    int maxInChannels;           /* the channel counts passed to afSTFTinit(), which the memory is allocated for */
+    int maxOutChannels;
     int hopSize;
     int hLen;
     int pr;
@@ -49,16 +62,19 @@ typedef struct
     int hopIndexIn;
     int hopIndexOut;
     int totalHops;
-    float *protoFilter;
-    float *protoFilterI;
-    float **inBuffer;
+    float *protoFilter;          /* shared between instances (read-only) */
+    float *protoFilterI;         /* shared between instances (read-only) */
+    void *protoTables;
+    float *inBuffer;
     float *fftProcessFrameTD;
     float *fftProcessFrameFD;
-    float **outBuffer;
-    int log2n;
+    float *outBuffer;
     void *vtFFT;
     void *h_afHybrid;
     int hybridMode;
+    complexVector *hopFDsplit;   /* per channel pointers to the bands of one hop of the caller's frame (in any format) */
+    int *activeBandStart;        /* per synthesis channel range of active bands: [activeBandStart, activeBandEnd) */
+    int *activeBandEnd;
     
 } afSTFT;
 
@@ -67,26 +83,73 @@ typedef struct
 {
     int inChannels;
     int outChannels;
+    int maxInChannels;
     int hopSize;
     float hybridCoeffs[3];
-    complexVector **analysisBuffer;
+    /* The 5 lowest bands of the last 7 hops, channel-interleaved: [7][5][maxInChannels], for filtering all channels at once */
+    float *lowBufferRe, *lowBufferIm;
+    /* The remaining bands of the last 4 hops, for delaying them by the group delay of the half-band filters: [4][maxInChannels][hopSize-4] */
+    float *delayBufferRe, *delayBufferIm;
+    /* The half-band filter outputs of bands 1..4: [4][maxInChannels] */
+    float *filtRe, *filtIm;
     int loopPointer;
+    int delayPointer;
 
 } afHybrid;
 
 
 /* Call these */
 
+/* Any hop size within the range below is supported; hop sizes that are not a power of two use resampled prototype
+ * filters and a mixed-radix FFT, so that the filterbank may line up with the host block size. "handle" is set to NULL
+ * if the hop size is out of range */
+#define AFSTFT_MIN_HOP_SIZE 16
+#define AFSTFT_MAX_HOP_SIZE 1024
+
 void afSTFTinit(void** handle, int hopSize, int inChannels, int outChannels, int LDmode, int hybridMode);
 
+/* Analysis-only and synthesis-only alternatives to afSTFTinit(), for which only the memory of the afSTFTforward() or
+ * afSTFTinverse() direction is allocated, respectively (the same applies to afSTFTinit() when either "inChannels" or
+ * "outChannels" is 0). The handles are freed with afSTFTfree() */
+void afSTFTinit_analysis(void** handle, int hopSize, int inChannels, int LDmode, int hybridMode);
+
+void afSTFTinit_synthesis(void** handle, int hopSize, int outChannels, int LDmode, int hybridMode);
+
+/* Declares that only bands [bandStart, bandEnd) of synthesis channel "ch" (or of all channels, if "ch" is -1) are
+ * non-zero. The remaining bands are then neither read nor required to be cleared by the caller, and the inverse
+ * hybrid filtering is skipped if the first 9 bands are inactive. If bandStart>=bandEnd, the channel is inactive, and
+ * its inverse FFT and overlap-add are skipped altogether (the tail of the previous output is still rendered). Band
+ * indices are those of the hybrid bands if the hybrid mode is enabled. By default, all bands are active.
+ * Note that afSTFTinverse() clears the inactive bands of its input data in-place. */
+void afSTFTsetActiveBands(void* handle, int ch, int bandStart, int bandEnd);
+
+/* Changes the number of active input/output channels, up to the channel counts that were passed to afSTFTinit()
+ * (larger values are clamped). No memory is (re)allocated, and so it may be called from within the process callback;
+ * channels that become active again start from silence. The active band ranges (see above) are kept for all channels */
+void afSTFTchannelChange(void* handle, int new_inChannels, int new_outChannels);
+
 void afSTFTforward(void* handle, float** inTD, complexVector* outFD);
 
 void afSTFTinverse(void* handle, complexVector* inFD, float** outTD);
 
+/* Frame-based alternatives to the above, which process "framesize" samples (an integer multiple of hopSize) per call,
+ * reading the input from/writing the output to the caller's buffers in the chosen "format" (see AFSTFT_FDDATA_FORMAT
+ * above) directly, i.e. without intermediate copies. "nChannelsFD" is the channel dimension of "dataFD". As with
+ * afSTFTinverse(), the input data of afSTFTinverse_frame() is overwritten when using the hybrid mode or inactive
+ * bands. */
+void afSTFTforward_frame(void* handle, float** dataTD, int framesize, int nChannelsFD, AFSTFT_FDDATA_FORMAT format, void* dataFD);
+
+void afSTFTinverse_frame(void* handle, void* dataFD, int nChannelsFD, AFSTFT_FDDATA_FORMAT format, int framesize, float** dataTD);
+
 void afSTFTfree(void* handle);
 
+/* Initialises a power-of-two FFT of length 2^log2n */
 void vtInitFFT(void** planPr, float* timeData, float* frequencyData, int log2n);
 
+/* As vtInitFFT(), but taking the FFT length "N", which must be even. Power-of-two lengths use the selected FFT backend,
+ * whereas other lengths use FFTW (if enabled), or otherwise the built-in mixed-radix FFT */
+void vtInitFFT_length(void** planPr, float* timeData, float* frequencyData, int N);
+
 void vtFreeFFT(void* planPr);
 
 void vtRunFFT(void* planPr, int positiveForForwardTransform);
@@ -100,6 +163,8 @@ void afHybridForward(void* handle, complexVector* FD);
 
 void afHybridInverse(void* handle, complexVector* FD);
 
+void afHybridChannelChange(void* handle, int new_inChannels, int new_outChannels);
+
 void afHybridFree(void* handle);
 
 #endif /* defined(__afSTFTlib_tester__afSTFTlib__) */
@@ -89,7 +89,22 @@ void getRSH(/* Input arguments */
             /* Output arguments */
             float** Y);                           /* & the SH weights: FLAT: (N+1)^2 x nDirs */
     
+/* returns real spherical harmonics for multiple directions on the sphere, scaled by "scale" (1.0f gives the same
+ * weights as getRSH, i.e. WITHOUT the 1/sqrt(4*pi) scaling), into caller-allocated real and/or complex (with zero
+ * imaginary parts) matrices; either may be NULL. Intended for large grids: the directions are evaluated in blocks,
+ * vectorised over directions, and split over "nThreads" threads (0: one per processor, 1: the calling thread only) */
+void getRSH_batch(/* Input arguments */
+                  int N,                          /* order of spherical harmonic expansion */
+                  float* dirs_deg,                /* directions on the sphere [azi, elev] convention; FLAT: nDirs x 2 */
+                  int nDirs,                      /* number of directions */
+                  float scale,                    /* scaling applied to all of the SH weights */
+                  int nThreads,                   /* number of threads to use (0: one per processor) */
+                  /* Output arguments */
+                  float* Y,                       /* the real SH weights, or NULL; FLAT: (N+1)^2 x nDirs */
+                  float_complex* Y_cmplx);        /* the SH weights as complex numbers, or NULL; FLAT: (N+1)^2 x nDirs */
+    
 /* returns real spherical harmonics for a direction on the sphere. WITH the 1/sqrt(4*pi) scaling
+ * (computed recursively, in double precision, and without allocating any memory)
  * For more information, the reader is  directed to:
  * Rafaely, B. (2015). Fundamentals of spherical array processing (Vol. 8). Berlin: Springer. */
 void getSHreal(/* Input arguments */
@@ -99,6 +114,15 @@ void getSHreal(/* Input arguments */
                /* Output arguments */
                float* Y);                         /* the SH weights: (L+1)^2 x 1 */
 
+/* returns real spherical harmonics for multiple directions on the sphere. WITH the 1/sqrt(4*pi) scaling
+ * (batched alternative to getSHreal, which evaluates the recursions for many directions at a time) */
+void getSHreal_recur(/* Input arguments */
+                     int N,                       /* order of spherical harmonic expansion */
+                     float* dirs_rad,             /* directions on the sphere [azi, inclination] convention; FLAT: nDirs x 2 */
+                     int nDirs,                   /* number of directions */
+                     /* Output arguments */
+                     float* Y);                   /* the SH weights: FLAT: (N+1)^2 x nDirs */
+
 /* Contructs a 3x3 rotation matrix from the Euler angles, using the yaw-pitch-roll (zyx) convention */
 void yawPitchRoll2Rzyx (/* Input arguments */
                         float yaw,                /* yaw angle in radians */
@@ -115,6 +139,44 @@ void getSHrotMtxReal (float R[3][3],              /* zyx rotation matrix */
                       float* RotMtx,              /* the rotation matrix; FLAT: (L+1)^2 x (L+1)^2 */
                       int L);                     /* order */
     
+/* number of elements of the block-diagonal SH rotation matrix of order L: sum_{l=0}^{L} (2l+1)^2 */
+#define SH_ROT_BLOCKS_LENGTH(L) ( ((L)+1)*(2*(L)+1)*(2*(L)+3)/3 )
+    
+/* same as getSHrotMtxReal, but only the non-zero (2l+1) x (2l+1) blocks of each order l are computed, and stored one
+ * after the other. No memory is allocated */
+void getSHrotMtxReal_blocks (float R[3][3],       /* zyx rotation matrix */
+                             float* RotBlocks,    /* the per-order rotation blocks; SH_ROT_BLOCKS_LENGTH(L) x 1 */
+                             int L);              /* order */
+    
+/* rotates spherical harmonic signals with the block-diagonal rotation matrix from getSHrotMtxReal_blocks, applying
+ * each per-order block to the signals of that order only */
+void applySHrotMtxReal_blocks (float* RotBlocks,  /* the per-order rotation blocks; SH_ROT_BLOCKS_LENGTH(L) x 1 */
+                               int L,             /* order */
+                               float* inSig,      /* input signals; FLAT: (L+1)^2 x nSamples */
+                               int nSamples,      /* number of samples */
+                               float* outSig);    /* rotated signals; FLAT: (L+1)^2 x nSamples */
+    
+/* same as applySHrotMtxReal_blocks, except that the rotation blocks are linearly interpolated, per sample, from
+ * "RotBlocks_prev" to "RotBlocks" over the nSamples (in a single pass over the signals) */
+void applySHrotMtxReal_blocks_xfade (float* RotBlocks_prev, /* the previous per-order rotation blocks */
+                                     float* RotBlocks,      /* the new per-order rotation blocks */
+                                     int L,                 /* order */
+                                     float* inSig,          /* input signals; FLAT: (L+1)^2 x nSamples */
+                                     int nSamples,          /* number of samples */
+                                     float* outSig);        /* rotated signals; FLAT: (L+1)^2 x nSamples */
+    
+/* rotates one set of spherical harmonic signals to "nListeners" different orientations in a single pass. The per-order
+ * blocks of all listeners are applied order by order, so that the input signals of each order are reused from cache
+ * for every listener. If "RotBlocks_prev" (or one of its entries) is not NULL, then the blocks of that listener are
+ * crossfaded as in applySHrotMtxReal_blocks_xfade. Output channels given as NULL are not computed */
+void applySHrotMtxReal_blocks_multi (float** RotBlocks,      /* per-order rotation blocks; nListeners x SH_ROT_BLOCKS_LENGTH(L) */
+                                     float** RotBlocks_prev, /* previous blocks to fade from, or NULL; nListeners x SH_ROT_BLOCKS_LENGTH(L) */
+                                     int nListeners,         /* number of listeners/orientations */
+                                     int L,                  /* order */
+                                     float* inSig,           /* input signals; FLAT: (L+1)^2 x nSamples */
+                                     int nSamples,           /* number of samples */
+                                     float*** outSig);       /* rotated signals; nListeners x (L+1)^2 x nSamples */
+    
 /* generates beamforming weights for a direction on the sphere */
 void calcBFweights(/* Input arguments */
                    BEAMFORMING_WEIGHT_TYPES BFW_type, /* see BEAMFORMING_WEIGHT_TYPES enum */
@@ -153,6 +215,15 @@ void generatePWDmap(/* Input arguments */
                     /* Output arguments */
                     float* pmap);                 /* resulting PWD powermap; nGrid_dirs x 1 */
 
+/* same as generatePWDmap, but for real-valued steering vectors (e.g. real SHs), which requires less computations */
+void generatePWDmapReal(/* Input arguments */
+                        int order,                /* analysis order */
+                        float_complex* Cx,        /* covarience matrix; FLAT: (order+1)^2 x (order+1)^2 */
+                        float* Y_grid,            /* real steering vectors for grid direcionts; FLAT: (order+1)^2 x nGrid_dirs  */
+                        int nGrid_dirs,           /* number of grid directions */
+                        /* Output arguments */
+                        float* pmap);             /* resulting PWD powermap; nGrid_dirs x 1 */
+
 /* generates a powermap utilising the MVDR method*/
 void generateMVDRmap(/* Input arguments */
                      int order,                   /* analysis order */
@@ -164,6 +235,17 @@ void generateMVDRmap(/* Input arguments */
                      float* pmap,                 /* resulting MVDR powermap; nGrid_dirs x 1 */
                      float_complex* w_MVDR);      /* optional. weights will be copied to this, unless it's NULL; FLAT: nSH x nGrid_dirs || NULL */
 
+/* same as generateMVDRmap, but for real-valued steering vectors (e.g. real SHs), which requires less computations */
+void generateMVDRmapReal(/* Input arguments */
+                         int order,               /* analysis order */
+                         float_complex* Cx,       /* covarience matrix; FLAT: (order+1)^2 x (order+1)^2 */
+                         float* Y_grid,           /* real steering vectors for grid direcionts; FLAT: (order+1)^2 x nGrid_dirs  */
+                         int nGrid_dirs,          /* number of grid directions */
+                         float regPar,            /* regularisation parameter, for diagonal loading of Cx */
+                         /* Output arguments */
+                         float* pmap,             /* resulting MVDR powermap; nGrid_dirs x 1 */
+                         float_complex* w_MVDR);  /* optional. weights will be copied to this, unless it's NULL; FLAT: nSH x nGrid_dirs || NULL */
+
 /* EXPERIMENTAL! Generates a powermap utilising the CroPaC LCMV post-filter described in:
  * Delikaris-Manias, S., Vilkamo, J., & Pulkki, V. (2016). Signal-dependent spatial filtering based on
  * weighted-orthogonal beamformers in the spherical harmonic domain. IEEE/ACM Transactions on Audio,
@@ -205,6 +287,57 @@ void generateMinNormMap(/* Input arguments */
                         int logScaleFlag,         /* 1: log(pmap), 0: pmap. */
                         /* Output arguments */
                         float* pmap);             /* resulting MinNorm pseudo-spectrum; nGrid_dirs x 1 */
+    
+/* resets a PASTd subspace tracker (see updateSubspacePASTd) */
+void resetSubspacePASTd(/* Input arguments */
+                        int nSH,                  /* length of the snapshots */
+                        int nSources,             /* dimension of the signal sub-space to track */
+                        /* Output arguments */
+                        float_complex* W,         /* tracked signal sub-space, as rows; FLAT: nSources x nSH */
+                        float* d);                /* tracked eigenvalues; nSources x 1 */
+    
+/* updates the signal sub-space estimate "W" (i.e. the eigenvectors of the nSources largest eigenvalues of the
+ * covariance matrix of the snapshots) with new snapshots, using the projection approximation subspace tracking with
+ * deflation (PASTd) algorithm. This costs O(nSH*nSources) per snapshot, and no eigenvalue decomposition is required:
+ * Yang, B. (1995). Projection approximation subspace tracking. IEEE Transactions on Signal Processing, 43(1), 95-107.
+ * The rows of W become approximately orthonormal eigenvectors, in (roughly) decending order of eigenvalues "d" */
+void updateSubspacePASTd(/* Input arguments */
+                         float_complex* X,        /* snapshots, as columns; FLAT: nSH x ldX */
+                         int ldX,                 /* leading dimension of X */
+                         int nSH,                 /* length of the snapshots */
+                         int nSnapshots,          /* number of snapshots (columns) in X to use */
+                         float scale,             /* scaling applied to the snapshots */
+                         float beta,              /* forgetting factor per snapshot, 0..1 */
+                         int nSources,            /* dimension of the signal sub-space */
+                         /* Input/Output arguments */
+                         float_complex* W,        /* tracked signal sub-space, as rows; FLAT: nSources x nSH */
+                         float* d,                /* tracked eigenvalues; nSources x 1 */
+                         /* Workspace */
+                         float_complex* work);    /* caller-supplied, so that no memory is allocated; nSH x 1 */
+    
+/* same as generateMUSICmap, except the pseudo-spectrum is computed from a basis of the signal sub-space (e.g. from
+ * updateSubspacePASTd), rather than from the eigenvalue decomposition of a covariance matrix */
+void generateMUSICmapFromSubspace(/* Input arguments */
+                                  int order,             /* analysis order */
+                                  float_complex* Vs,     /* signal sub-space basis, as rows; FLAT: nSources x (order+1)^2 */
+                                  float_complex* Y_grid, /* steering vectors for grid direcionts; FLAT: (order+1)^2 x nGrid_dirs  */
+                                  int nSources,          /* number of sources present in sound scene */
+                                  int nGrid_dirs,        /* number of grid directions */
+                                  int logScaleFlag,      /* 1: log(pmap), 0: pmap. */
+                                  /* Output arguments */
+                                  float* pmap);          /* resulting MUSIC pseudo-spectrum; nGrid_dirs x 1 */
+    
+/* same as generateMinNormMap, except the pseudo-spectrum is computed from a basis of the signal sub-space (e.g. from
+ * updateSubspacePASTd), rather than from the eigenvalue decomposition of a covariance matrix */
+void generateMinNormMapFromSubspace(/* Input arguments */
+                                    int order,             /* analysis order */
+                                    float_complex* Vs,     /* signal sub-space basis, as rows; FLAT: nSources x (order+1)^2 */
+                                    float_complex* Y_grid, /* steering vectors for grid direcionts; FLAT: (order+1)^2 x nGrid_dirs  */
+                                    int nSources,          /* number of sources present in sound scene */
+                                    int nGrid_dirs,        /* number of grid directions */
+                                    int logScaleFlag,      /* 1: log(pmap), 0: pmap. */
+                                    /* Output arguments */
+                                    float* pmap);          /* resulting MinNorm pseudo-spectrum; nGrid_dirs x 1 */
 
 /* (cylindrical) Bessel function of the first kind: Jn
  * returns the Bessel values and their derivatives up to order N for all values in vector z  */
@@ -346,7 +479,8 @@ void simulateCylArray(/* Input arguments */
                       float_complex* H_array);    /* simulated array response for each plane wave; FLAT: nBands x N_sensors x N_srcs */
 
 /* simulates a spherical microphone array, returning the transfer functions for each (plane wave) source direction
- * on the surface of the sphere. */
+ * on the surface of the sphere. The source directions are simulated in blocks, split over "nThreads" threads (0: one per
+ * processor, 1: the calling thread only) */
 void simulateSphArray(/* Input arguments */
                       int order,                  /* max order (highest is ~30 given numerical error) */
                       double* kr,                 /* wavenumber*radius; nBands x 1 */
@@ -357,6 +491,7 @@ void simulateSphArray(/* Input arguments */
                       int N_srcs,                 /* number sources (DoAs of plane waves) */
                       ARRAY_CONSTRUCTION_TYPES arrayType, /* see 'ARRAY_CONSTRUCTION_TYPES' enum */
                       double dirCoeff,            /* only for directional (open) arrays, 0: omni, 0.5: card, 1:dipole */
+                      int nThreads,               /* number of threads to use (0: one per processor) */
                       /* Output arguments */
                       float_complex* H_array);    /* simulated array response for each plane wave; FLAT: nBands x N_sensors x N_srcs */
 
@@ -20,9 +20,9 @@
  *     complex number wrappers. Optimised linear algebra routines utilising BLAS and LAPACK
  *     are also included.
  * Dependencies:
- *     Windows users only: Intel's MKL must be installed, which can be freely aquired via:
- *     https://software.intel.com/en-us/articles/free-ipsxe-tools-and-libraries
- *     Mac users only: saf_utilities will utilise Apple's Accelerate library.
+ *     A performance library comprising CBLAS and LAPACK routines is required. One may
+ *     select Intel's MKL (SAF_USE_INTEL_MKL), OpenBLAS/LAPACKE (SAF_USE_OPEN_BLAS_AND_LAPACKE)
+ *     or Apple's Accelerate (SAF_USE_APPLE_ACCELERATE); refer to saf_veclib.h for details.
  * Author, date created:
  *     Leo McCormack, 11.07.2016
  */
@@ -31,6 +31,22 @@
 extern "C" {
 #endif
     
+/* Sparse VBAP gain table, stored in the compressed sparse row (CSR) format. The non-zero gains for the nt'th point in the
+ * table are:
+ *      for (i = gtable->rowPtr[nt]; i < gtable->rowPtr[nt+1]; i++){
+ *          gains[i] = gtable->gains[i];
+ *          idx[i] = gtable->colIdx[i];
+ *      } */
+typedef struct _vbapSparseTable {
+    int nRows;                                              /* number of points in the gain table */
+    int nCols;                                              /* number of loudspeakers */
+    int nnz;                                                /* number of non-zero gains */
+    int* rowPtr;                                            /* offset of the first gain of each point; (nRows+1) x 1 */
+    int* colIdx;                                            /* loudspeaker index of each gain; nnz x 1 */
+    float* gains;                                           /* the non-zero gains; nnz x 1 */
+    
+}vbapSparseTable;
+    
 /* Generates a 3-D VBAP gain table based on specified source and loudspeaker directions; Note: gtable is returned as NULL if the triangulation failed
  * The VBAP gains are energy normalised; i.e. sum(gains^2) = 1 */
 void generateVBAPgainTable3D_srcs(/* Input arguments */
@@ -69,6 +85,36 @@ void generateVBAPgainTable3D(/* Input arguments */
                              int* N_gtable,                 /* & number of points in the gain table */
                              int* nTriangles);              /* & number of loudspeaker triangles */
     
+/* Creates a persistent 3-D VBAP handle for the specified loudspeaker directions, which holds the loudspeaker triangulation,
+ * the inverted loudspeaker matrices and the triangle adjacency. This may then be used with vbap_query() to obtain the VBAP
+ * gains for arbitrary source directions, rather than the nearest grid point of a pre-computed gain table.
+ * Note: the handle is returned as NULL if the triangulation failed */
+void vbap_create(/* Input arguments */
+                 void** const phVbap,                       /* & address of the VBAP handle */
+                 float* ls_dirs_deg,                        /* Loudspeaker directions; FLAT: L x 2 */
+                 int L,                                     /* number of loudspeakers */
+                 int omitLargeTriangles,                    /* 0: normal triangulation, 1: remove large triangles */
+                 int enableDummies,                         /* 0: disabled, 1: enabled. Dummies are placed at +/-90 elevation if required */
+                 /* Output arguments */
+                 int* nTriangles);                          /* & number of loudspeaker triangles */
+    
+/* Destroys a VBAP handle created by vbap_create() */
+void vbap_destroy(void** const phVbap);                     /* & address of the VBAP handle */
+    
+/* Returns the 3 loudspeaker indices and their VBAP gains to pan a source to [AZIMUTH ELEVATION]. No memory is allocated,
+ * and the search starts from the triangle found by the previous query; so it typically only takes a few 3x3 products.
+ * Gains for any dummy loudspeakers are discarded (idx=0, gain=0) and the remaining gains are then energy normalised; i.e.
+ * sum(gains^2) = 1. If no triangle encloses the direction (e.g. if large triangles were omitted), or the direction
+ * coincides with a dummy loudspeaker, all 3 gains are zero.
+ * Note: since the handle remembers the previous triangle, it should not be queried from more than one thread at a time */
+void vbap_query(/* Input arguments */
+                void* const hVbap,                          /* VBAP handle */
+                float azi_deg,                              /* source azimuth in degrees */
+                float elev_deg,                             /* source elevation in degrees */
+                /* Output arguments */
+                int idx[3],                                 /* loudspeaker indices; 3 x 1 */
+                float gains[3]);                            /* VBAP gains ENERGY NORMALISED; 3 x 1 */
+    
 /* Compresses a VBAP gain table to use less memory and CPU (essentially removes the elements that are zero). Handy
  * for large grid sizes for interpolation purposes. Therefore, the gains are also re-normalised to have the amplitude-preserving
  * property.
@@ -92,6 +138,41 @@ void compressVBAPgainTable3D(/* Input arguments */
                              float** vbap_gtableComp,       /* & The compressed 3D VBAP gain table AMPLITUDE NORMALISED; FLAT: nTable x 3  */
                              int** vbap_gtableIdx);         /* & The indices for the compressed 3D VBAP gain table; FLAT: nTable x 3  */
     
+/* Generates the compressed 3-D VBAP gain table directly (i.e. the same output as generateVBAPgainTable3D() followed by
+ * compressVBAPgainTable3D(), but without allocating the intermediate N_gtable x L dense table). The grid and the access
+ * pattern are as described for compressVBAPgainTable3D(). Note: both tables are returned as NULL if the triangulation
+ * failed. The VBAP gains are amplitude normalised; i.e. sum(gains) = 1 */
+void generateVBAPgainTable3D_compressed(/* Input arguments */
+                                        float* ls_dirs_deg,      /* Loudspeaker directions; FLAT: L x 2 */
+                                        int L,                   /* number of loudspeakers */
+                                        int az_res_deg,          /* azimuthal resolution in degrees */
+                                        int el_res_deg,          /* elevation resolution in degrees */
+                                        int omitLargeTriangles,  /* 0: normal triangulation, 1: remove large triangles */
+                                        int enableDummies,       /* 0: disabled, 1: enabled. Dummies are placed at +/-90 elevation if required */
+                                        /* Output arguments */
+                                        float** vbap_gtableComp, /* & The compressed 3D VBAP gain table AMPLITUDE NORMALISED; FLAT: N_gtable x 3 */
+                                        int** vbap_gtableIdx,    /* & The indices for the compressed 3D VBAP gain table; FLAT: N_gtable x 3 */
+                                        int* N_gtable,           /* & number of points in the gain table */
+                                        int* nTriangles);        /* & number of loudspeaker triangles */
+    
+/* Generates a sparse 3-D VBAP gain table based on specified source and loudspeaker directions; i.e. the same gains as
+ * generateVBAPgainTable3D_srcs() (optionally followed by VBAPgainTable2InterpTable()), but only the (at most 3) non-zero
+ * gains per source direction are stored. Note: gtable is returned as NULL if the triangulation failed */
+void generateVBAPgainTable3D_srcs_sparse(/* Input arguments */
+                                         float* src_dirs_deg,      /* Source directions; FLAT: S x 2 */
+                                         int S,                    /* number of Sources */
+                                         float* ls_dirs_deg,       /* Loudspeaker directions FLAT: L x 2 */
+                                         int L,                    /* number of loudspeakers */
+                                         int omitLargeTriangles,   /* 0: normal triangultion, 1: remove large triangles too */
+                                         int enableDummies,        /* 0: disabled, 1: enabled. Dummies are placed at +/-90 elevation if required */
+                                         int interpTable,          /* 0: ENERGY NORMALISED gains, 1: AMPLITUDE NORMALISED gains, for interpolation */
+                                         /* Output arguments */
+                                         vbapSparseTable** gtable, /* & The sparse 3D VBAP gain table; S x L */
+                                         int* nTriangles);         /* & number of loudspeaker triangles */
+    
+/* Destroys a sparse VBAP gain table */
+void destroyVBAPsparseTable(vbapSparseTable** const gtable);  /* & address of the sparse VBAP gain table */
+    
 /* Renormalises a vbap gain table in place, so it may be utilised for interpolation of data (e.g. powermaps or HRTFs).
  * The VBAP gains are amplitude normalised; i.e. sum(gains) = 1 */
 void VBAPgainTable2InterpTable(float* vbap_gtable,          /* vbap gain table; nTable x nDirs */
@@ -129,6 +210,17 @@ void generateVBAPgainTable2D(/* Input arguments */
                              int* N_gtable,                 /* & number of points in the gain table */
                              int* nPairs);                  /* & number of loudspeaker pairs */
     
+/* Generates a sparse 2-D VBAP gain table based on specified loudspeaker directions; i.e. the same gains and grid as
+ * generateVBAPgainTable2D(), but only the non-zero gains are stored.
+ * The VBAP gains are energy normalised; i.e. sum(gains^2) = 1 */
+void generateVBAPgainTable2D_sparse(/* Input arguments */
+                                    float* ls_dirs_deg,       /* Loudspeaker directions FLAT: L x 2 (elev assumed to be 0 for all) */
+                                    int L,                    /* number of loudspeakers */
+                                    int az_res_deg,           /* azimuthal resolution in degrees */
+                                    /* Output arguments */
+                                    vbapSparseTable** gtable, /* & the sparse 2D VBAP gain table ENERGY NORMALISED; N_gtable x L */
+                                    int* nPairs);             /* & number of loudspeaker pairs */
+    
 /* Calculates the frequency dependent pValues, which can be applied to energy normalised VBAP gains
  * This is performed as:
  * if(pValues[band] != 2.0f){
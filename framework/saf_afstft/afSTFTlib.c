@@ -28,157 +28,327 @@
 #define COEFF1 0.031273141818515176604f
 #define COEFF2 0.28127313041521179171f
 #define COEFF3 0.5f
+#define HYBRID_SUBBANDS_END 9 /* the hybrid filtering only concerns the lowest 9 bands (0..8) */
 
-void afSTFTinit(void** handle, int hopSize, int inChannels, int outChannels, int LDmode, int hybridMode)
+static void afSTFTforward_hop(afSTFT* h, float** inTD, int offset, complexVector* outFD, int stride);
+static void afSTFTinverse_hop(afSTFT* h, complexVector* inFD, int stride, float** outTD, int offset);
+static void afHybridForwardStrided(afHybrid* h, complexVector* FD, int bandStride);
+static void afHybridInverseChannel(int hopSize, complexVector* FD, int stride);
+
+/* Returns sample "k" of a prototype filter of length 10*hopSize, taken from the 10240 tap prototype filter "protoFilter1024" */
+static float afSTFTresampleProtoFilter(const float* protoFilter1024_ptr, int k, int hopSize)
+{
+    int pos, idx, rem;
+    
+    /* since hopSize<=1024, idx+1 never exceeds the filter length whenever rem>0 */
+    pos = k*1024;
+    idx = pos/hopSize;
+    rem = pos%hopSize;
+    if (rem==0)
+        return protoFilter1024_ptr[idx];
+    return protoFilter1024_ptr[idx] + (protoFilter1024_ptr[idx+1]-protoFilter1024_ptr[idx])*(float)rem/(float)hopSize;
+}
+
+/* The scaled prototype filters are shared read-only by all afSTFT instances with the same hopSize and LDmode, and are
+ * reference counted */
+typedef struct _afSTFTprotoTables {
+    int hopSize;
+    int LDmode;
+    int refCount;
+    float *protoFilter;
+    float *protoFilterI;  /* points to protoFilter, unless LDmode==1 */
+    struct _afSTFTprotoTables *next;
+} afSTFTprotoTables;
+
+static afSTFTprotoTables* afSTFTprotoTableCache = NULL;
+
+static afSTFTprotoTables* afSTFTacquireProtoTables(int hopSize, int LDmode)
 {
-    int k,ch,log2n, dsFactor;
+    int k, hLen;
     float eq;
+    const float *protoFilter1024_ptr;
+    afSTFTprotoTables *t;
     
-    *handle = malloc(sizeof(afSTFT));
-    switch (hopSize) {
-        case 32:
-            log2n=6;
-            break;
-        case 64:
-            log2n=7;
-            break;
-        case 128:
-            log2n=8;
-            break;
-        case 256:
-            log2n=9;
-            break;
-        case 512:
-            log2n=10;
-            break;
-        case 1024:
-            log2n=11;
-            break;
-        default:
-            // No other modes defined
-            return;
-            break;
+    vtCacheLock();
+    for (t=afSTFTprotoTableCache; t!=NULL; t=t->next)
+    {
+        if (t->hopSize == hopSize && t->LDmode == LDmode)
+        {
+            t->refCount++;
+            vtCacheUnlock();
+            return t;
+        }
+    }
+    t = (afSTFTprotoTables*)malloc(sizeof(afSTFTprotoTables));
+    t->hopSize = hopSize;
+    t->LDmode = LDmode;
+    t->refCount = 1;
+    hLen = 10*hopSize;
+    t->protoFilter = (float*)malloc(sizeof(float)*hLen);
+    t->protoFilterI = LDmode==0 && VT_INVERSE_SPLIT_SCALE==1.0f ? t->protoFilter : (float*)malloc(sizeof(float)*hLen);
+    
+    /* The prototype filters are resampled from those designed for the hop size of 1024 (exactly decimated for
+     * power-of-two hop sizes, linearly interpolated otherwise), with normalization to ensure 0dB gain. The synthesis
+     * filter also carries the scaling of the inverse FFT that is not applied by vtRunFFTinverse_split() */
+    protoFilter1024_ptr = LDmode==0 ? protoFilter1024 : protoFilter1024LD;
+    eq = 1.0f/sqrtf((float)hopSize*(LDmode==0 ? 5.487604141f : 4.544559956f));
+    for (k=0; k<hLen; k++)
+    {
+        t->protoFilter[hLen-k-1] = afSTFTresampleProtoFilter(protoFilter1024_ptr, k, hopSize)*eq;
+    }
+    if (t->protoFilterI != t->protoFilter)
+    {
+        for (k=0; k<hLen; k++)
+            t->protoFilterI[k] = VT_INVERSE_SPLIT_SCALE*(LDmode==0 ? t->protoFilter[k] : t->protoFilter[hLen-k-1]);
+    }
+    t->next = afSTFTprotoTableCache;
+    afSTFTprotoTableCache = t;
+    vtCacheUnlock();
+    return t;
+}
+
+static void afSTFTreleaseProtoTables(afSTFTprotoTables* t)
+{
+    afSTFTprotoTables **pp;
+    
+    vtCacheLock();
+    if (--(t->refCount) > 0)
+    {
+        vtCacheUnlock();
+        return;
+    }
+    for (pp=&afSTFTprotoTableCache; *pp!=t; pp=&((*pp)->next));
+    *pp = t->next;
+    vtCacheUnlock();
+    if (t->protoFilterI != t->protoFilter)
+        free(t->protoFilterI);
+    free(t->protoFilter);
+    free(t);
+}
+
+void afSTFTinit(void** handle, int hopSize, int inChannels, int outChannels, int LDmode, int hybridMode)
+{
+    int ch;
+    
+    if (hopSize < AFSTFT_MIN_HOP_SIZE || hopSize > AFSTFT_MAX_HOP_SIZE)
+    {
+        *handle = NULL;
+        return;
     }
+    *handle = malloc(sizeof(afSTFT));
     
     /* Basic initializations */
     afSTFT *h = (afSTFT*)(*handle);
-    h->log2n=log2n;
     h->inChannels = inChannels;
     h->outChannels = outChannels;
     h->hopSize = hopSize;
-    dsFactor=1024/hopSize;
-    h->hLen = 10240/dsFactor;
+    h->hLen = 10*hopSize;
     h->totalHops=10;
     h->hopIndexIn=0;
     h->hopIndexOut=0;
     h->LDmode = LDmode;
-    h->protoFilter = (float*)malloc(sizeof(float)*h->hLen);
-    h->protoFilterI = (float*)malloc(sizeof(float)*h->hLen);
-    h->inBuffer = (float**)malloc(sizeof(float*)*h->inChannels);
-    h->outBuffer = (float**)malloc(sizeof(float*)*h->outChannels);
-    h->fftProcessFrameTD = (float*)calloc(sizeof(float),h->hopSize*2);
+    h->maxInChannels = inChannels;
+    h->maxOutChannels = outChannels;
+    h->maxChannels = MAX(h->inChannels, h->outChannels);
+    /* The memory buffers are arranged as [totalHops][maxChannels][hopSize], and the FFT frames as [channels][2*hopSize],
+     * so that each prototype filter segment may be applied to all channels at once. The analysis/synthesis memory
+     * buffer is only allocated (and the prototype filter only referenced) if the respective direction has any channels */
+    h->protoTables = (void*)afSTFTacquireProtoTables(h->hopSize, h->LDmode);
+    h->protoFilter = h->inChannels > 0 ? ((afSTFTprotoTables*)h->protoTables)->protoFilter : NULL;
+    h->protoFilterI = h->outChannels > 0 ? ((afSTFTprotoTables*)h->protoTables)->protoFilterI : NULL;
+    h->inBuffer = h->inChannels > 0 ? (float*)calloc(h->hLen*h->inChannels,sizeof(float)) : NULL;
+    h->outBuffer = h->outChannels > 0 ? (float*)calloc(h->hLen*h->outChannels,sizeof(float)) : NULL;
+    h->fftProcessFrameTD = (float*)calloc(sizeof(float),h->maxChannels*h->hopSize*2);
     h->fftProcessFrameFD  = (float*)calloc(sizeof(float),(h->hopSize+1)*2);
-    vtInitFFT(&(h->vtFFT),h->fftProcessFrameTD, h->fftProcessFrameFD, h->log2n);
-    
-    /* Normalization to ensure 0dB gain */
-    if (h->LDmode==0)
-    {
-        eq = 1.0f/sqrtf((float)h->hopSize*5.487604141f);
-        for (k=0; k<h->hLen; k++)
-        {
-            h->protoFilter[h->hLen-k-1] = protoFilter1024[k*dsFactor]*eq;
-            h->protoFilterI[h->hLen-k-1] = protoFilter1024[k*dsFactor]*eq;
-        }
-    }
-    else
+    h->hopFDsplit = (complexVector*)malloc(sizeof(complexVector)*h->maxChannels);
+    h->activeBandStart = (int*)malloc(sizeof(int)*h->maxOutChannels);
+    h->activeBandEnd = (int*)malloc(sizeof(int)*h->maxOutChannels);
+    for (ch=0;ch<h->outChannels;ch++)
     {
-        eq = 1.0f/sqrtf((float)h->hopSize*4.544559956f);
-        for (k=0; k<h->hLen; k++)
-        {
-            h->protoFilter[h->hLen-k-1] = protoFilter1024LD[k*dsFactor]*eq;
-            h->protoFilterI[k]=protoFilter1024LD[k*dsFactor]*eq;
-            
-        }
+        h->activeBandStart[ch] = 0;
+        h->activeBandEnd[ch] = hybridMode ? h->hopSize+5 : h->hopSize+1;
     }
-    for(ch=0;ch<h->inChannels;ch++)
+    vtInitFFT_length(&(h->vtFFT),h->fftProcessFrameTD, h->fftProcessFrameFD, 2*h->hopSize);
+    
+    /* Initialize the hybrid filter memory etc. */
+    h->hybridMode=hybridMode;
+    if (h->hybridMode)
     {
-        h->inBuffer[ch] = (float*)calloc(h->hLen,sizeof(float));
+        afHybridInit(&(h->h_afHybrid), h->hopSize, h->inChannels,h->outChannels);
     }
+}
+
+void afSTFTinit_analysis(void** handle, int hopSize, int inChannels, int LDmode, int hybridMode)
+{
+    afSTFTinit(handle, hopSize, inChannels, 0, LDmode, hybridMode);
+}
+
+void afSTFTinit_synthesis(void** handle, int hopSize, int outChannels, int LDmode, int hybridMode)
+{
+    afSTFTinit(handle, hopSize, 0, outChannels, LDmode, hybridMode);
+}
+
+void afSTFTsetActiveBands(void* handle, int ch, int bandStart, int bandEnd)
+{
+    afSTFT *h = (afSTFT*)(handle);
+    int nBands, ch0, ch1;
     
-    for(ch=0;ch<h->outChannels;ch++)
+    nBands = h->hybridMode ? h->hopSize+5 : h->hopSize+1;
+    bandStart = MAX(bandStart, 0);
+    bandEnd = MIN(bandEnd, nBands);
+    ch0 = ch < 0 ? 0 : ch;
+    ch1 = ch < 0 ? h->maxOutChannels : MIN(ch+1, h->maxOutChannels);
+    for (ch=ch0;ch<ch1;ch++)
     {
-        h->outBuffer[ch] = (float*)calloc(h->hLen,sizeof(float));
+        h->activeBandStart[ch] = bandStart;
+        h->activeBandEnd[ch] = MAX(bandEnd, bandStart);
     }
+}
+
+void afSTFTchannelChange(void* handle, int new_inChannels, int new_outChannels)
+{
+    afSTFT *h = (afSTFT*)(handle);
+    int ch,k;
     
+    new_inChannels = MIN(MAX(new_inChannels, 0), h->maxInChannels);
+    new_outChannels = MIN(MAX(new_outChannels, 0), h->maxOutChannels);
     
-    /* Initialize the hybrid filter memory etc. */
-    h->hybridMode=hybridMode;
+    /* Clear the memory of the channels that become active, as it may still hold data from when they were last active */
+    for (k=0;k<h->totalHops;k++)
+    {
+        for (ch=h->inChannels;ch<new_inChannels;ch++)
+            vtClr(&(h->inBuffer[(k*h->maxInChannels+ch)*h->hopSize]), h->hopSize);
+        for (ch=h->outChannels;ch<new_outChannels;ch++)
+            vtClr(&(h->outBuffer[(k*h->maxOutChannels+ch)*h->hopSize]), h->hopSize);
+    }
     if (h->hybridMode)
     {
-        afHybridInit(&(h->h_afHybrid), h->hopSize, h->inChannels,h->outChannels);
+        afHybridChannelChange(h->h_afHybrid, new_inChannels, new_outChannels);
     }
+    h->inChannels = new_inChannels;
+    h->outChannels = new_outChannels;
 }
 
 void afSTFTforward(void* handle, float** inTD, complexVector* outFD)
 {
-    afSTFT *h = (afSTFT*)(handle);
-    int ch,k,hopIndex_this,hopIndex_this2;
-    float *p1,*p2,*p3,*p4;
-    int lr;
+    afSTFTforward_hop((afSTFT*)(handle), inTD, 0, outFD, 1);
+}
+
+void afSTFTinverse(void* handle, complexVector* inFD, float** outTD)
+{
+    afSTFTinverse_hop((afSTFT*)(handle), inFD, 1, outTD, 0);
+}
+
+/* Points the per channel hop vectors at hop "t" of the caller's frame, and returns the stride between its bands */
+static int afSTFTpointToHop(afSTFT* h, void* dataFD, int nChannels, int nChannelsFD, AFSTFT_FDDATA_FORMAT format, int t, int nHops, int nBands)
+{
+    int ch;
+    float *pFD;
+    complexVector *pSplit;
     
-    for (ch=0;ch<h->inChannels;ch++)
+    switch (format)
     {
-        /* Copy the input frame into the memory buffer */
-        hopIndex_this2 = h->hopIndexIn;
-        p1=&(h->inBuffer[ch][hopIndex_this2*h->hopSize]);
-        p2=inTD[ch];
-        memcpy((void*)p1,(void*)p2,sizeof(float)*(h->hopSize));
-        
-        hopIndex_this2++;
-        if (hopIndex_this2 >= h->totalHops)
-        {
-            hopIndex_this2 = 0;
-        }
-        
-        /* Apply prototype filter to the collected data in the memory buffer, and fold the result (for the FFT operation). */
-        p1 = h->fftProcessFrameTD;
-        vtClr(p1, h->hopSize*2);
-        lr=0; /* Left or right part of the frame */
-        hopIndex_this = hopIndex_this2;
-        for (k=0;k<h->totalHops;k++)
-        {
-            p1=&(h->inBuffer[ch][h->hopSize*hopIndex_this]);
-            p2=&(h->protoFilter[k*h->hopSize]);
-            if (lr==1)
+        case AFSTFT_BANDS_CH_TIME:
+            pFD = (float*)dataFD;
+            for (ch=0;ch<nChannels;ch++)
             {
-                p3=&(h->fftProcessFrameTD[h->hopSize]);
-                lr=0;
+                h->hopFDsplit[ch].re = &(pFD[2*(ch*nHops+t)]);
+                h->hopFDsplit[ch].im = &(pFD[2*(ch*nHops+t)+1]);
             }
-            else
+            return 2*nChannelsFD*nHops;
+        case AFSTFT_CH_TIME_BANDS:
+            pFD = (float*)dataFD;
+            for (ch=0;ch<nChannels;ch++)
             {
-                p3=&(h->fftProcessFrameTD[0]);
-                lr=1;
+                h->hopFDsplit[ch].re = &(pFD[2*(ch*nHops+t)*nBands]);
+                h->hopFDsplit[ch].im = &(pFD[2*(ch*nHops+t)*nBands+1]);
             }
-            vtVma(p1, p2, p3, h->hopSize);  /* Vector multiply-add */
-            hopIndex_this++;
-            if (hopIndex_this >= h->totalHops)
+            return 2;
+        default: /* AFSTFT_CH_TIME_BANDS_SPLIT */
+            pSplit = (complexVector*)dataFD;
+            for (ch=0;ch<nChannels;ch++)
             {
-                hopIndex_this = 0;
+                h->hopFDsplit[ch].re = &(pSplit[ch].re[t*nBands]);
+                h->hopFDsplit[ch].im = &(pSplit[ch].im[t*nBands]);
             }
+            return 1;
+    }
+}
+
+void afSTFTforward_frame(void* handle, float** dataTD, int framesize, int nChannelsFD, AFSTFT_FDDATA_FORMAT format, void* dataFD)
+{
+    afSTFT *h = (afSTFT*)(handle);
+    int t,nHops,nBands,stride;
+    
+    /* The FFT (and hybrid filtering) output of each hop is written directly to the caller's data, in any format */
+    nHops = framesize/h->hopSize;
+    nBands = h->hybridMode ? h->hopSize+5 : h->hopSize+1;
+    for (t=0;t<nHops;t++)
+    {
+        stride = afSTFTpointToHop(h, dataFD, h->inChannels, nChannelsFD, format, t, nHops, nBands);
+        afSTFTforward_hop(h, dataTD, t*h->hopSize, h->hopFDsplit, stride);
+    }
+}
+
+void afSTFTinverse_frame(void* handle, void* dataFD, int nChannelsFD, AFSTFT_FDDATA_FORMAT format, int framesize, float** dataTD)
+{
+    afSTFT *h = (afSTFT*)(handle);
+    int t,nHops,nBands,stride;
+    
+    /* The IFFT input of each hop is taken directly from the caller's data, in any format */
+    nHops = framesize/h->hopSize;
+    nBands = h->hybridMode ? h->hopSize+5 : h->hopSize+1;
+    for (t=0;t<nHops;t++)
+    {
+        stride = afSTFTpointToHop(h, dataFD, h->outChannels, nChannelsFD, format, t, nHops, nBands);
+        afSTFTinverse_hop(h, h->hopFDsplit, stride, dataTD, t*h->hopSize);
+    }
+}
+
+/* "stride" is the distance between the bands of the output vectors */
+static void afSTFTforward_hop(afSTFT* h, float** inTD, int offset, complexVector* outFD, int stride)
+{
+    int ch,k,hopIndex_this;
+    float *p1,*p2,*p3;
+    
+    /* Copy the input frames (starting from sample "offset") into the memory buffer */
+    p1 = &(h->inBuffer[h->hopIndexIn*h->maxInChannels*h->hopSize]);
+    for (ch=0;ch<h->inChannels;ch++)
+    {
+        memcpy((void*)&(p1[ch*h->hopSize]),(void*)&(inTD[ch][offset]),sizeof(float)*(h->hopSize));
+    }
+    hopIndex_this = h->hopIndexIn+1;
+    if (hopIndex_this >= h->totalHops)
+    {
+        hopIndex_this = 0;
+    }
+    
+    /* Apply prototype filter to the collected data in the memory buffer, and fold the result (for the FFT operation).
+     * Each filter segment is applied to all channels, before moving on to the next segment. The first two segments
+     * initialise the left and right parts of the frames, so they need not be cleared beforehand. */
+    for (k=0;k<h->totalHops;k++)
+    {
+        p1=&(h->inBuffer[h->hopSize*h->maxInChannels*hopIndex_this]);
+        p2=&(h->protoFilter[k*h->hopSize]);
+        p3=&(h->fftProcessFrameTD[(k%2)*h->hopSize]); /* Left or right part of the frame */
+        for (ch=0;ch<h->inChannels;ch++)
+        {
+            if (k<2)
+                vtVmul(&(p1[ch*h->hopSize]), p2, &(p3[ch*2*h->hopSize]), h->hopSize); /* Vector multiply */
+            else
+                vtVma(&(p1[ch*h->hopSize]), p2, &(p3[ch*2*h->hopSize]), h->hopSize); /* Vector multiply-add */
+        }
+        hopIndex_this++;
+        if (hopIndex_this >= h->totalHops)
+        {
+            hopIndex_this = 0;
         }
-        
-        /* Apply FFT and copy the data to the output vector */
-        vtRunFFT(h->vtFFT,1);
-        outFD[ch].re[0]=h->fftProcessFrameFD[0];
-        outFD[ch].im[0]=0.0f; /* DC im = 0 */
-        outFD[ch].re[h->hopSize]=h->fftProcessFrameFD[h->hopSize];
-        outFD[ch].im[h->hopSize]=0.0f; /* Nyquist im = 0 */
-        p1 = outFD[ch].re + 1;
-        p2 = outFD[ch].im + 1;
-        p3 = h->fftProcessFrameFD + 1;
-        p4 = h->fftProcessFrameFD + 1 + h->hopSize;
-        memcpy((void*)p1,(void*)p3,sizeof(float)*(h->hopSize - 1));
-        memcpy((void*)p2,(void*)p4,sizeof(float)*(h->hopSize - 1));
+    }
+    
+    /* Apply FFT to the frames, with the output written directly to the output vectors */
+    for (ch=0;ch<h->inChannels;ch++)
+    {
+        vtRunFFTforward_split(h->vtFFT, &(h->fftProcessFrameTD[ch*2*h->hopSize]), outFD[ch].re, outFD[ch].im, stride);
     }
     h->hopIndexIn++;
     if (h->hopIndexIn >= h->totalHops)
@@ -189,93 +359,90 @@ void afSTFTforward(void* handle, float** inTD, complexVector* outFD)
     /* Subdivide lowest bands with half-band filters if hybrid mode is enabled */
     if (h->hybridMode)
     {
-        afHybridForward(h->h_afHybrid, outFD);
+        afHybridForwardStrided((afHybrid*)(h->h_afHybrid), outFD, stride);
     }
 }
 
-void afSTFTinverse(void* handle, complexVector* inFD, float** outTD)
+/* "stride" is the distance between the bands of the input vectors */
+static void afSTFTinverse_hop(afSTFT* h, complexVector* inFD, int stride, float** outTD, int offset)
 {
-    afSTFT *h = (afSTFT*)(handle);
-    int ch,k,hopIndex_this,hopIndex_this2;
-    float *p1,*p2,*p3,*p4;
-    int lr;
-    
-    /* Combine subdivided lowest bands if hybrid mode is enabled */
-    if (h->hybridMode)
-    {
-        afHybridInverse(h->h_afHybrid, inFD);
-    }
+    int ch,k,band,hopIndex_this,lr,nBands,bandStart,bandEnd,shift;
+    float *p1,*p2,*p3;
     
+    /* Clear the bands outside of the active range of each channel, and combine the subdivided lowest bands if hybrid
+     * mode is enabled. The hybrid stage is skipped if none of the subdivided bands are active, in which case the shift
+     * of the remaining bands to their original positions is instead obtained by offsetting the IFFT input by 4 bands */
+    nBands = h->hybridMode ? h->hopSize+5 : h->hopSize+1;
     for (ch=0;ch<h->outChannels;ch++)
     {
-        /* Copy data from input to internal memory */
-        hopIndex_this2 = h->hopIndexOut;
-        h->fftProcessFrameFD[0] = inFD[ch].re[0]; /* DC */
-        h->fftProcessFrameFD[h->hopSize] = inFD[ch].re[h->hopSize]; /* Nyquist */
-        p1 = inFD[ch].re + 1;
-        p2 = inFD[ch].im + 1;
-        p3 = h->fftProcessFrameFD + 1;
-        p4 = h->fftProcessFrameFD + 1 + h->hopSize;
-        memcpy((void*)p3,(void*)p1,sizeof(float)*(h->hopSize - 1));
-        memcpy((void*)p4,(void*)p2,sizeof(float)*(h->hopSize - 1));
-        
-        /* The low delay mode requires this procedure corresponding to the circular shift of the data in the time domain */
-        if (h->LDmode == 1)
+        bandStart = h->activeBandStart[ch];
+        bandEnd = h->activeBandEnd[ch];
+        if (bandStart >= bandEnd)
+            continue; /* inactive channel */
+        for (band=0;band<bandStart;band++)
         {
-            for (k=1;k<h->hopSize;k+=2)
-            {
-                *p3 = -*p3;
-                *p4 = -*p4;
-                p3+=2;
-                p4+=2;
-            }
+            inFD[ch].re[band*stride] = 0.0f;
+            inFD[ch].im[band*stride] = 0.0f;
         }
-        
-        /* Inverse FFT */
-        vtRunFFT(h->vtFFT, -1);
-        
-        /* Clear buffer at the pointer location and increment the pointer */
-        p1 = &(h->outBuffer[ch][hopIndex_this2*h->hopSize]);
-        vtClr(p1,h->hopSize);
-        hopIndex_this2++;
-        if (hopIndex_this2 >= h->totalHops)
+        for (band=bandEnd;band<nBands;band++)
         {
-            hopIndex_this2=0;
+            inFD[ch].re[band*stride] = 0.0f;
+            inFD[ch].im[band*stride] = 0.0f;
         }
-        hopIndex_this = hopIndex_this2;
-        
-        lr=0; /* Left or right part of the frame */
-        for (k=0;k<h->totalHops;k++)
+        if (h->hybridMode && bandStart < HYBRID_SUBBANDS_END)
+            afHybridInverseChannel(h->hopSize, &(inFD[ch]), stride);
+    }
+    
+    /* Inverse FFT, taking the input data directly. Inactive channels are skipped */
+    for (ch=0;ch<h->outChannels;ch++)
+    {
+        if (h->activeBandStart[ch] >= h->activeBandEnd[ch])
+            continue;
+        shift = h->hybridMode && h->activeBandStart[ch] >= HYBRID_SUBBANDS_END ? 4 : 0;
+        vtRunFFTinverse_split(h->vtFFT, &(inFD[ch].re[shift*stride]), &(inFD[ch].im[shift*stride]), stride, &(h->fftProcessFrameTD[ch*2*h->hopSize]));
+    }
+    hopIndex_this = h->hopIndexOut+1;
+    if (hopIndex_this >= h->totalHops)
+    {
+        hopIndex_this = 0;
+    }
+    
+    /* Left or right part of the frame. The low delay mode requires a circular shift of the IFFT'd data by
+     * half of its length, which is obtained by simply starting from the right part of the frame */
+    lr = h->LDmode == 1 ? 1 : 0;
+    for (k=0;k<h->totalHops;k++)
+    {
+        /* Apply the prototype filter to the repeated version of the IFFT'd data, and overlap-add to the existing data in
+         * the memory buffer (from previous frames), for all channels at once. The last segment lands on the buffer
+         * location that was output during the previous call, and therefore overwrites it rather than adding to it. */
+        p1=&(h->outBuffer[h->hopSize*h->maxOutChannels*hopIndex_this]);
+        p2=&(h->protoFilterI[k*h->hopSize]);
+        p3=&(h->fftProcessFrameTD[((k+lr)%2)*h->hopSize]);
+        for (ch=0;ch<h->outChannels;ch++)
         {
-            /* Apply the prototype filter to the repeated version of the IFFT'd data. */
-            p1=&(h->outBuffer[ch][h->hopSize*hopIndex_this]);
-            p2=&(h->protoFilterI[k*h->hopSize]);
-            if (lr==1)
+            if (h->activeBandStart[ch] >= h->activeBandEnd[ch])
             {
-                p3=&(h->fftProcessFrameTD[h->hopSize]);
-                lr=0;
+                /* Nothing to add for inactive channels, only the overwritten segment is cleared */
+                if (k==h->totalHops-1)
+                    vtClr(&(p1[ch*h->hopSize]), h->hopSize);
             }
+            else if (k==h->totalHops-1)
+                vtVmul(p2, &(p3[ch*2*h->hopSize]), &(p1[ch*h->hopSize]), h->hopSize); /* Vector multiply */
             else
-            {
-                p3=&(h->fftProcessFrameTD[0]);
-                lr=1;
-            }
-            
-            /* Overlap-add to the existing data in the memory buffer (from previous frames). */
-            vtVma(p2, p3, p1, h->hopSize); /* Vector multiply-add */
-            
-            hopIndex_this++;
-            if (hopIndex_this >= h->totalHops)
-            {
-                hopIndex_this = 0;
-            }
+                vtVma(p2, &(p3[ch*2*h->hopSize]), &(p1[ch*h->hopSize]), h->hopSize); /* Vector multiply-add */
         }
-        
-        /* Copy a frame from work memory to the output */
-        p1 = outTD[ch];
-        p2 = &(h->outBuffer[ch][h->hopSize*hopIndex_this]);
-        memcpy((void*)p1,(void*)p2,sizeof(float)*(h->hopSize));
-        
+        hopIndex_this++;
+        if (hopIndex_this >= h->totalHops)
+        {
+            hopIndex_this = 0;
+        }
+    }
+    
+    /* Copy a frame from work memory to the output (starting from sample "offset") */
+    p1 = &(h->outBuffer[h->hopSize*h->maxOutChannels*hopIndex_this]);
+    for (ch=0;ch<h->outChannels;ch++)
+    {
+        memcpy((void*)&(outTD[ch][offset]),(void*)&(p1[ch*h->hopSize]),sizeof(float)*(h->hopSize));
     }
     h->hopIndexOut++;
     if (h->hopIndexOut >= h->totalHops)
@@ -288,22 +455,14 @@ void afSTFTinverse(void* handle, complexVector* inFD, float** outTD)
 void afSTFTfree(void* handle)
 {
     afSTFT *h = (afSTFT*)(handle);
-    int ch;
     if (h->hybridMode)
     {
         afHybridFree(h->h_afHybrid);
     }
-    for(ch=0;ch<h->inChannels;ch++)
-    {
-        free(h->inBuffer[ch]);
-    }
-    
-    for(ch=0;ch<h->outChannels;ch++)
-    {
-        free(h->outBuffer[ch]);
-    }
-    free(h->protoFilter);
-    free(h->protoFilterI);
+    free(h->hopFDsplit);
+    free(h->activeBandStart);
+    free(h->activeBandEnd);
+    afSTFTreleaseProtoTables((afSTFTprotoTables*)h->protoTables);
     free(h->inBuffer);
     free(h->outBuffer);
     free(h->fftProcessFrameTD);
@@ -317,31 +476,34 @@ void afSTFTfree(void* handle)
 
 void afHybridInit(void** handle, int hopSize, int inChannels, int outChannels)
 {
-    /* Allocates 7 samples of memory for FIR filtering at lowest bands, and for delays at other bands. */
-    int ch,sample;
+    /* Allocates 7 samples of memory for FIR filtering at lowest bands, and 4 samples for delays at other bands. */
     *handle = malloc(sizeof(afHybrid));
     afHybrid *h = (afHybrid*)(*handle);
     h->inChannels = inChannels;
+    h->maxInChannels = inChannels;
     h->hopSize = hopSize;
     h->outChannels = outChannels;
-    h->analysisBuffer = (complexVector**)malloc(sizeof(complexVector*)*h->inChannels);
+    h->lowBufferRe = (float*)calloc(sizeof(float), 7*5*h->inChannels);
+    h->lowBufferIm = (float*)calloc(sizeof(float), 7*5*h->inChannels);
+    h->delayBufferRe = (float*)calloc(sizeof(float), 4*h->inChannels*(h->hopSize-4));
+    h->delayBufferIm = (float*)calloc(sizeof(float), 4*h->inChannels*(h->hopSize-4));
+    h->filtRe = (float*)malloc(sizeof(float)*4*h->inChannels);
+    h->filtIm = (float*)malloc(sizeof(float)*4*h->inChannels);
     h->loopPointer=0;
-    for (ch=0;ch<h->inChannels;ch++)
-    {
-        h->analysisBuffer[ch] = (complexVector*)malloc(sizeof(complexVector)*7);
-        for (sample=0;sample<7;sample++)
-        {
-            h->analysisBuffer[ch][sample].re=(float*)calloc(sizeof(float),h->hopSize+1);
-            h->analysisBuffer[ch][sample].im=(float*)calloc(sizeof(float),h->hopSize+1);
-        }
-    }
+    h->delayPointer=0;
 }
 
 void afHybridForward(void* handle, complexVector* FD)
 {
-    afHybrid *h = (afHybrid*)(handle);
-    int ch,band,sample,realImag;
-    float *pr1, *pr2, *pi1, *pi2;
+    afHybridForwardStrided((afHybrid*)(handle), FD, 1);
+}
+
+/* "bandStride" is the distance between the bands of the FD vectors (whereas "stride" is that of the channels in the
+ * channel-interleaved memory buffers) */
+static void afHybridForwardStrided(afHybrid* h, complexVector* FD, int bandStride)
+{
+    int ch,band,sample,nCh,stride,nUpper,delayPointerThis;
+    float *pr1, *pr2, *pi1, *pi2, *pre, *pim;
     float re,im;
     int sampleIndices[7];
     int loopPointerThis;
@@ -350,132 +512,181 @@ void afHybridForward(void* handle, complexVector* FD)
     {
         h->loopPointer = 0;
     }
-    for (ch=0;ch<h->inChannels;ch++)
+    h->delayPointer++;
+    if( h->delayPointer == 4)
     {
-        /* Copy data from input to the memory buffer */
-        pr1 = FD[ch].re;
-        pi1 = FD[ch].im;
-        pr2 = h->analysisBuffer[ch][h->loopPointer].re;
-        pi2 = h->analysisBuffer[ch][h->loopPointer].im;
-        memcpy((void*)pr2,(void*)pr1,sizeof(float)*(h->hopSize+1));
-        memcpy((void*)pi2,(void*)pi1,sizeof(float)*(h->hopSize+1));
-        
-        /* Get the pointer to a position corresponding to the group delay of the linear-phase half-band filter. */
-        loopPointerThis = h->loopPointer - 3;
-        if( loopPointerThis < 0)
+        h->delayPointer = 0;
+    }
+    nCh = h->inChannels;
+    stride = h->maxInChannels;
+    nUpper = h->hopSize-4;
+    
+    /* Get the pointers to positions corresponding to the group delay of the linear-phase half-band filter. */
+    loopPointerThis = h->loopPointer - 3;
+    if( loopPointerThis < 0)
+    {
+        loopPointerThis += 7;
+    }
+    delayPointerThis = h->delayPointer - 3;
+    if( delayPointerThis < 0)
+    {
+        delayPointerThis += 4;
+    }
+    for (sample=0;sample<7;sample++)
+    {
+        sampleIndices[sample]=h->loopPointer+1+sample;
+        if(sampleIndices[sample] > 6)
         {
-            loopPointerThis += 7;
+            sampleIndices[sample]-=7;
         }
-        pr1 = FD[ch].re;
-        pr2 = h->analysisBuffer[ch][loopPointerThis].re;
-        for (realImag=0;realImag<2;realImag++)
+    }
+    
+    /* Copy the lowest bands from input to the channel-interleaved memory buffer, and delay the rest of the bands */
+    pre = &(h->lowBufferRe[h->loopPointer*5*stride]);
+    pim = &(h->lowBufferIm[h->loopPointer*5*stride]);
+    for (ch=0;ch<nCh;ch++)
+    {
+        for (band=0;band<5;band++)
         {
-            /* The 0.5 multipliers are the center coefficients of the half-band FIR filters. Data is duplicated for the half-bands. */
-            *pr1 = *pr2;
-            *(pr1+1) = *(pr2+1)*0.5f;
-            *(pr1+2) = *(pr1+1);
-            *(pr1+3) = *(pr2+2)*0.5f;
-            *(pr1+4) = *(pr1+3);
-            *(pr1+5) = *(pr2+3)*0.5f;
-            *(pr1+6) = *(pr1+5);
-            *(pr1+7) = *(pr2+4)*0.5f;
-            *(pr1+8) = *(pr1+7);
-            
-            /* The rest of the bands are shifted upwards in the frequency indices, and delayed by the group delay of the half-band filters */
-            memcpy((void*)(pr1+9),(void*)(pr2+5),sizeof(float)*(h->hopSize-4));
-            
-            /* Repeat process for the imaginary part, at next iteration. */
-            pr1 = FD[ch].im;
-            pr2 = h->analysisBuffer[ch][loopPointerThis].im;
+            pre[band*stride+ch] = FD[ch].re[band*bandStride];
+            pim[band*stride+ch] = FD[ch].im[band*bandStride];
         }
-    
-        for (sample=0;sample<7;sample++)
+        
+        /* The rest of the bands are shifted upwards in the frequency indices, and delayed by the group delay of the half-band filters */
+        pr2 = &(h->delayBufferRe[(h->delayPointer*stride+ch)*nUpper]);
+        pi2 = &(h->delayBufferIm[(h->delayPointer*stride+ch)*nUpper]);
+        pr1 = &(FD[ch].re[5*bandStride]);
+        pi1 = &(FD[ch].im[5*bandStride]);
+        for (band=0;band<nUpper;band++)
         {
-            sampleIndices[sample]=h->loopPointer+1+sample;
-            if(sampleIndices[sample] > 6)
-            {
-                sampleIndices[sample]-=7;
-            }
-            
+            pr2[band] = pr1[band*bandStride];
+            pi2[band] = pi1[band*bandStride];
+        }
+        pr2 = &(h->delayBufferRe[(delayPointerThis*stride+ch)*nUpper]);
+        pi2 = &(h->delayBufferIm[(delayPointerThis*stride+ch)*nUpper]);
+        pr1 = &(FD[ch].re[9*bandStride]);
+        pi1 = &(FD[ch].im[9*bandStride]);
+        for (band=0;band<nUpper;band++)
+        {
+            pr1[band*bandStride] = pr2[band];
+            pi1[band*bandStride] = pi2[band];
         }
+    }
+    
+    /* The half-band FIR filtering of bands 1..4, applied to all channels at once. The real<->imaginary shifts are for
+     * shifting the half-band filter spectra. */
+    for (band=1; band<5; band++)
+    {
+        pr1 = &(h->filtRe[(band-1)*stride]);
+        pi1 = &(h->filtIm[(band-1)*stride]);
+        vtVsmul(&(h->lowBufferIm[(sampleIndices[6]*5+band)*stride]), -COEFF1, pr1, nCh);
+        vtVsmul(&(h->lowBufferRe[(sampleIndices[6]*5+band)*stride]),  COEFF1, pi1, nCh);
+        vtVsma (&(h->lowBufferIm[(sampleIndices[4]*5+band)*stride]), -COEFF2, pr1, nCh);
+        vtVsma (&(h->lowBufferRe[(sampleIndices[4]*5+band)*stride]),  COEFF2, pi1, nCh);
+        vtVsma (&(h->lowBufferIm[(sampleIndices[2]*5+band)*stride]),  COEFF2, pr1, nCh);
+        vtVsma (&(h->lowBufferRe[(sampleIndices[2]*5+band)*stride]), -COEFF2, pi1, nCh);
+        vtVsma (&(h->lowBufferIm[(sampleIndices[0]*5+band)*stride]),  COEFF1, pr1, nCh);
+        vtVsma (&(h->lowBufferRe[(sampleIndices[0]*5+band)*stride]), -COEFF1, pi1, nCh);
+    }
+    
+    /* Write the hybrid bands to the output */
+    pre = &(h->lowBufferRe[loopPointerThis*5*stride]);
+    pim = &(h->lowBufferIm[loopPointerThis*5*stride]);
+    for (ch=0;ch<nCh;ch++)
+    {
+        FD[ch].re[0] = pre[ch];
+        FD[ch].im[0] = pim[ch];
         for (band=1; band<5; band++)
         {
-            /* The rest of the half-band FIR filtering is implemented below. The real<->imaginary shifts are for shifting the half-band filter spectra. */
-            re = -COEFF1*h->analysisBuffer[ch][sampleIndices[6]].im[band];
-            im =  COEFF1*h->analysisBuffer[ch][sampleIndices[6]].re[band];
-            re -= COEFF2*h->analysisBuffer[ch][sampleIndices[4]].im[band];
-            im += COEFF2*h->analysisBuffer[ch][sampleIndices[4]].re[band];
-            re += COEFF2*h->analysisBuffer[ch][sampleIndices[2]].im[band];
-            im -= COEFF2*h->analysisBuffer[ch][sampleIndices[2]].re[band];
-            re += COEFF1*h->analysisBuffer[ch][sampleIndices[0]].im[band];
-            im -= COEFF1*h->analysisBuffer[ch][sampleIndices[0]].re[band];
-            
-            /* The addition or subtraction process below provides the upper and lower half-band spectra (the coefficient 0.5 had the same sign for both bands).
+            /* The 0.5 multipliers are the center coefficients of the half-band FIR filters. The addition or subtraction
+               process below provides the upper and lower half-band spectra (the coefficient 0.5 had the same sign for both bands).
                The half-band orders are switched for bands=1,3 with respect to band=2,4, because of the organization of the spectral data at the downsampled frequency band signals. As the result of the order switching, the bands are organized by the ascending spectral position. */
+            re = h->filtRe[(band-1)*stride+ch];
+            im = h->filtIm[(band-1)*stride+ch];
             if (band == 1 || band== 3)
             {
-                FD[ch].re[band*2-1] -= re;
-                FD[ch].im[band*2-1] -= im;
-                FD[ch].re[band*2] += re;
-                FD[ch].im[band*2] += im;
+                re = -re;
+                im = -im;
             }
-            else
-            {
-                FD[ch].re[band*2-1] += re;
-                FD[ch].im[band*2-1] += im;
-                FD[ch].re[band*2] -= re;
-                FD[ch].im[band*2] -= im;
-            }
-            
+            FD[ch].re[(band*2-1)*bandStride] = pre[band*stride+ch]*0.5f + re;
+            FD[ch].im[(band*2-1)*bandStride] = pim[band*stride+ch]*0.5f + im;
+            FD[ch].re[band*2*bandStride] = pre[band*stride+ch]*0.5f - re;
+            FD[ch].im[band*2*bandStride] = pim[band*stride+ch]*0.5f - im;
         }
-        
-        
     }
 }
 
 void afHybridInverse(void* handle, complexVector* FD)
 {
     afHybrid *h = (afHybrid*)(handle);
-    int ch,realImag;
-    float *pr;
+    int ch;
 
     for (ch=0;ch<h->outChannels;ch++)
     {
-        pr = FD[ch].re;
-        for (realImag=0;realImag<2;realImag++)
+        afHybridInverseChannel(h->hopSize, &(FD[ch]), 1);
+    }
+}
+
+/* "stride" is the distance between the bands of the FD vectors */
+static void afHybridInverseChannel(int hopSize, complexVector* FD, int stride)
+{
+    int realImag,band;
+    float *pr;
+    
+    pr = FD->re;
+    for (realImag=0;realImag<2;realImag++)
+    {
+        /* Since no downsampling was applied, the inverse hybrid filtering is just sum of the bands */
+        pr[1*stride] = pr[1*stride] + pr[2*stride];
+        pr[2*stride] = pr[3*stride] + pr[4*stride];
+        pr[3*stride] = pr[5*stride] + pr[6*stride];
+        pr[4*stride] = pr[7*stride] + pr[8*stride];
+        
+        /* The rest of the bands are shifted to their original positions (downwards, so ascending order is safe) */
+        if (stride == 1)
+            memmove((void*)(pr+5),(void*)(pr+9),sizeof(float)*(hopSize-4));
+        else
         {
-            /* Since no downsampling was applied, the inverse hybrid filtering is just sum of the bands */
-            *(pr+1) = *(pr+1) + *(pr+2);
-            *(pr+2) = *(pr+3) + *(pr+4);
-            *(pr+3) = *(pr+5) + *(pr+6);
-            *(pr+4) = *(pr+7) + *(pr+8);
-            
-            /* The rest of the bands are shifted to their original positions */
-            memmove((void*)(pr+5),(void*)(pr+9),sizeof(float)*(h->hopSize-4));
-            
-            /* Repeat process for the imaginary part, at next iteration. */
-            pr = FD[ch].im;
+            for (band=5;band<hopSize+1;band++)
+                pr[band*stride] = pr[(band+4)*stride];
         }
+        
+        /* Repeat process for the imaginary part, at next iteration. */
+        pr = FD->im;
     }
 }
 
-void afHybridFree(void* handle)
+void afHybridChannelChange(void* handle, int new_inChannels, int new_outChannels)
 {
-    int ch,sample;
     afHybrid *h = (afHybrid*)(handle);
-    for (ch=0;ch<h->inChannels;ch++)
+    int ch,sample;
+    
+    /* Clear the filter memory of the channels that become active */
+    for (ch=h->inChannels;ch<new_inChannels;ch++)
     {
-        
-        for (sample=0;sample<7;sample++)
+        for (sample=0;sample<7*5;sample++)
         {
-            free(h->analysisBuffer[ch][sample].re);
-            free(h->analysisBuffer[ch][sample].im);
+            h->lowBufferRe[sample*h->maxInChannels+ch] = 0.0f;
+            h->lowBufferIm[sample*h->maxInChannels+ch] = 0.0f;
+        }
+        for (sample=0;sample<4;sample++)
+        {
+            vtClr(&(h->delayBufferRe[(sample*h->maxInChannels+ch)*(h->hopSize-4)]), h->hopSize-4);
+            vtClr(&(h->delayBufferIm[(sample*h->maxInChannels+ch)*(h->hopSize-4)]), h->hopSize-4);
         }
-        free(h->analysisBuffer[ch]);
-        
-        
-        
-        
     }
-    free(h->analysisBuffer);
+    h->inChannels = new_inChannels;
+    h->outChannels = new_outChannels;
+}
+
+void afHybridFree(void* handle)
+{
+    afHybrid *h = (afHybrid*)(handle);
+    free(h->lowBufferRe);
+    free(h->lowBufferIm);
+    free(h->delayBufferRe);
+    free(h->delayBufferIm);
+    free(h->filtRe);
+    free(h->filtIm);
+    free(h);
 }
@@ -21,6 +21,37 @@
  */
 
 #include "vecTools.h"
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+
+/* CACHE LOCK */
+#if defined(_WIN32)
+static SRWLOCK vtCacheMutex = SRWLOCK_INIT;
+#else
+static pthread_mutex_t vtCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+void vtCacheLock(void)
+{
+#if defined(_WIN32)
+    AcquireSRWLockExclusive(&vtCacheMutex);
+#else
+    pthread_mutex_lock(&vtCacheMutex);
+#endif
+}
+
+void vtCacheUnlock(void)
+{
+#if defined(_WIN32)
+    ReleaseSRWLockExclusive(&vtCacheMutex);
+#else
+    pthread_mutex_unlock(&vtCacheMutex);
+#endif
+}
 
 
 /* VECTOR FLUSH */
@@ -29,8 +60,9 @@ void vtClr(float* vec, int N)
 #ifdef VDSP
     vDSP_vclr(vec,1, N);
 #else
+    int k;
     float *p1 = vec;
-    for (int k=0;k<N;k++)
+    for (k=0;k<N;k++)
     {
         *p1=0.0f;
         p1++;
@@ -38,53 +70,510 @@ void vtClr(float* vec, int N)
 #endif
 }
 
+/* VECTOR MUL */
+void vtVmul(float* vec1, float* vec2, float* vec3, int N)
+{
+#ifdef VDSP
+    vDSP_vmul(vec1,1, vec2,1, vec3,1,N);
+#else
+    int k;
+    for (k=0;k<N;k++)
+    {
+        vec3[k] = vec1[k]*vec2[k];
+    }
+#endif
+}
+
 /* VECTOR MUL ADD */
 void vtVma(float* vec1, float* vec2, float* vec3, int N)
 {
 #ifdef VDSP
     vDSP_vma(vec1,1, vec2,1, vec3,1, vec3,1,N);
 #else
-    for (int k=0;k<N;k++)
+    int k;
+    for (k=0;k<N;k++)
     {
         vec3[k] += vec1[k]*vec2[k];
     }
 #endif
 }
 
+/* VECTOR SCALAR MUL */
+void vtVsmul(float* vec1, float scalar, float* vec2, int N)
+{
+#ifdef VDSP
+    vDSP_vsmul(vec1,1, &scalar, vec2,1, N);
+#else
+    int k;
+    for (k=0;k<N;k++)
+    {
+        vec2[k] = scalar*vec1[k];
+    }
+#endif
+}
+
+/* VECTOR SCALAR MUL ADD */
+void vtVsma(float* vec1, float scalar, float* vec2, int N)
+{
+#ifdef VDSP
+    vDSP_vsma(vec1,1, &scalar, vec2,1, vec2,1, N);
+#else
+    int k;
+    for (k=0;k<N;k++)
+    {
+        vec2[k] += scalar*vec1[k];
+    }
+#endif
+}
+
+/* MIXED-RADIX FFT */
+#if !defined(FFTW)
+/* Scaling of the mixed-radix real FFT, which follows that of the backend it stands in for */
+#if defined(VDSP)
+  #define VT_MR_FORWARD_SCALE 2.0f
+  #define VT_MR_INVERSE_SCALE 1.0f
+#else
+  #define VT_MR_FORWARD_SCALE 1.0f
+  #define VT_MR_INVERSE_SCALE 2.0f
+#endif
+
+/* maximum number of factors of the mixed-radix FFT length */
+#define VT_MAX_FACTORS 32
+
+typedef struct {
+    float re, im;
+} vtCpx;
+
+static int vtIsPow2(int N)
+{
+    return N>0 && (N & (N-1))==0;
+}
+
+/* Factorises "n" into radices of 4, 2, 3, 5, 7, ..., stored as pairs of: {radix, remaining length} */
+static void vtMixedRadixFactorise(int n, int* factors)
+{
+    int p = 4;
+    while (n>1)
+    {
+        while (n%p)
+        {
+            switch (p) {
+                case 4: p = 2; break;
+                case 2: p = 3; break;
+                default: p += 2; break;
+            }
+            if (p*p>n)
+                p = n;
+        }
+        n /= p;
+        *factors++ = p;
+        *factors++ = n;
+    }
+}
+
+/* SHARED FFT TABLES */
+typedef struct _vtFFTtables {
+    int N;
+    int refCount;
+#if defined(VDSP)
+    FFTSetup FFT;
+#else
+    float *w;
+    int *ip;
+#endif
+    int factors[2*VT_MAX_FACTORS];
+    int maxRadix;
+    float *mrTwiddles;
+    float *mrPostTwiddles;
+    struct _vtFFTtables *next;
+} vtFFTtables;
+
+static vtFFTtables* vtFFTtableCache = NULL;
+
+/* Returns the tables for FFT length "N" from the cache, creating them if no other instance is using them */
+static vtFFTtables* vtAcquireFFTtables(int N)
+{
+    int k, M;
+#if defined(VDSP)
+    int log2n;
+#else
+    float *a;
+#endif
+    double phase;
+    vtFFTtables *t;
+    
+    vtCacheLock();
+    for (t=vtFFTtableCache; t!=NULL; t=t->next)
+    {
+        if (t->N == N)
+        {
+            t->refCount++;
+            vtCacheUnlock();
+            return t;
+        }
+    }
+    t = (vtFFTtables*)calloc(1, sizeof(vtFFTtables));
+    t->N = N;
+    t->refCount = 1;
+    if (vtIsPow2(N))
+    {
+#if defined(VDSP)
+        for (log2n=0; (1<<log2n)<N; log2n++);
+        t->FFT = vDSP_create_fftsetup(log2n, FFT_RADIX2);
+#else
+        /* Ooura's tables are computed during the first call. Thereafter "w" is read-only, whereas "ip" is also used as
+         * workspace for the bit reversal, and is therefore only copied to each instance */
+        t->w = (float*)malloc(sizeof(float)*N/2);
+        t->ip = (int*)malloc(sizeof(int)*(2+N));
+        a = (float*)calloc(N, sizeof(float));
+        t->ip[0]=0;
+        rdft(N,1,a, t->ip, t->w);
+        free(a);
+#endif
+    }
+    else
+    {
+        M = N/2;
+        vtMixedRadixFactorise(M, t->factors);
+        t->maxRadix = 1;
+        for (k=0; t->factors[2*k+1]>1; k++)
+            t->maxRadix = t->factors[2*k]>t->maxRadix ? t->factors[2*k] : t->maxRadix;
+        t->maxRadix = t->factors[2*k]>t->maxRadix ? t->factors[2*k] : t->maxRadix;
+        t->mrTwiddles = (float*)malloc(sizeof(float)*2*M);
+        t->mrPostTwiddles = (float*)malloc(sizeof(float)*2*M);
+        for (k=0;k<M;k++)
+        {
+            phase = -2.0*M_PI*(double)k/(double)M;
+            t->mrTwiddles[2*k] = (float)cos(phase);
+            t->mrTwiddles[2*k+1] = (float)sin(phase);
+            phase = -2.0*M_PI*(double)k/(double)N;
+            t->mrPostTwiddles[2*k] = (float)cos(phase);
+            t->mrPostTwiddles[2*k+1] = (float)sin(phase);
+        }
+    }
+    t->next = vtFFTtableCache;
+    vtFFTtableCache = t;
+    vtCacheUnlock();
+    return t;
+}
+
+/* Releases the tables, which are destroyed once no instance is using them */
+static void vtReleaseFFTtables(vtFFTtables* t)
+{
+    vtFFTtables **pp;
+    
+    vtCacheLock();
+    if (--(t->refCount) > 0)
+    {
+        vtCacheUnlock();
+        return;
+    }
+    for (pp=&vtFFTtableCache; *pp!=t; pp=&((*pp)->next));
+    *pp = t->next;
+    vtCacheUnlock();
+#if defined(VDSP)
+    if (t->FFT != NULL)
+        vDSP_destroy_fftsetup(t->FFT);
+#else
+    free(t->w);
+    free(t->ip);
+#endif
+    free(t->mrTwiddles);
+    free(t->mrPostTwiddles);
+    free(t);
+}
+
+static void vtMixedRadixInit(vtFFT* h)
+{
+    int M;
+    vtFFTtables *t = (vtFFTtables*)h->tables;
+    
+    M = (h->N)/2;
+    h->mixedRadix = 1;
+    h->factors = t->factors;
+    h->mrTwiddles = t->mrTwiddles;
+    h->mrPostTwiddles = t->mrPostTwiddles;
+    h->mrWork = (float*)malloc(sizeof(float)*2*M);
+    h->mrScratch = (float*)malloc(sizeof(float)*2*(t->maxRadix));
+    h->mrRe = (float*)malloc(sizeof(float)*(M+1));
+    h->mrIm = (float*)malloc(sizeof(float)*(M+1));
+}
+
+static void vtMixedRadixFree(vtFFT* h)
+{
+    free(h->mrWork);
+    free(h->mrScratch);
+    free(h->mrRe);
+    free(h->mrIm);
+}
+
+static void vtBfly2(vtCpx* F, const vtCpx* tw, int fstride, int m)
+{
+    int k;
+    vtCpx t;
+    for (k=0;k<m;k++)
+    {
+        t.re = F[m+k].re*tw[k*fstride].re - F[m+k].im*tw[k*fstride].im;
+        t.im = F[m+k].re*tw[k*fstride].im + F[m+k].im*tw[k*fstride].re;
+        F[m+k].re = F[k].re - t.re;
+        F[m+k].im = F[k].im - t.im;
+        F[k].re += t.re;
+        F[k].im += t.im;
+    }
+}
+
+static void vtBfly3(vtCpx* F, const vtCpx* tw, int fstride, int m)
+{
+    int k;
+    float epi3 = tw[fstride*m].im;
+    vtCpx s0, s1, s2, s3;
+    const vtCpx *tw1, *tw2;
+    for (k=0;k<m;k++)
+    {
+        tw1 = &(tw[k*fstride]);
+        tw2 = &(tw[2*k*fstride]);
+        s1.re = F[m+k].re*tw1->re - F[m+k].im*tw1->im;
+        s1.im = F[m+k].re*tw1->im + F[m+k].im*tw1->re;
+        s2.re = F[2*m+k].re*tw2->re - F[2*m+k].im*tw2->im;
+        s2.im = F[2*m+k].re*tw2->im + F[2*m+k].im*tw2->re;
+        s3.re = s1.re + s2.re;
+        s3.im = s1.im + s2.im;
+        s0.re = (s1.re - s2.re)*epi3;
+        s0.im = (s1.im - s2.im)*epi3;
+        F[m+k].re = F[k].re - 0.5f*s3.re;
+        F[m+k].im = F[k].im - 0.5f*s3.im;
+        F[k].re += s3.re;
+        F[k].im += s3.im;
+        F[2*m+k].re = F[m+k].re + s0.im;
+        F[2*m+k].im = F[m+k].im - s0.re;
+        F[m+k].re -= s0.im;
+        F[m+k].im += s0.re;
+    }
+}
+
+static void vtBfly4(vtCpx* F, const vtCpx* tw, int fstride, int m)
+{
+    int k;
+    vtCpx s0, s1, s2, s3, s4, s5;
+    const vtCpx *tw1, *tw2, *tw3;
+    for (k=0;k<m;k++)
+    {
+        tw1 = &(tw[k*fstride]);
+        tw2 = &(tw[2*k*fstride]);
+        tw3 = &(tw[3*k*fstride]);
+        s0.re = F[m+k].re*tw1->re - F[m+k].im*tw1->im;
+        s0.im = F[m+k].re*tw1->im + F[m+k].im*tw1->re;
+        s1.re = F[2*m+k].re*tw2->re - F[2*m+k].im*tw2->im;
+        s1.im = F[2*m+k].re*tw2->im + F[2*m+k].im*tw2->re;
+        s2.re = F[3*m+k].re*tw3->re - F[3*m+k].im*tw3->im;
+        s2.im = F[3*m+k].re*tw3->im + F[3*m+k].im*tw3->re;
+        s5.re = F[k].re - s1.re;
+        s5.im = F[k].im - s1.im;
+        F[k].re += s1.re;
+        F[k].im += s1.im;
+        s3.re = s0.re + s2.re;
+        s3.im = s0.im + s2.im;
+        s4.re = s0.re - s2.re;
+        s4.im = s0.im - s2.im;
+        F[2*m+k].re = F[k].re - s3.re;
+        F[2*m+k].im = F[k].im - s3.im;
+        F[k].re += s3.re;
+        F[k].im += s3.im;
+        F[m+k].re = s5.re + s4.im;
+        F[m+k].im = s5.im - s4.re;
+        F[3*m+k].re = s5.re - s4.im;
+        F[3*m+k].im = s5.im + s4.re;
+    }
+}
+
+/* Generic (O(p^2)) butterfly, for radices other than 2, 3 and 4 */
+static void vtBflyGeneric(vtCpx* F, const vtCpx* tw, vtCpx* scratch, int fstride, int m, int p, int M)
+{
+    int u, k, q, q1, twidx;
+    vtCpx t;
+    for (u=0;u<m;u++)
+    {
+        for (q1=0,k=u;q1<p;q1++,k+=m)
+            scratch[q1] = F[k];
+        for (q1=0,k=u;q1<p;q1++,k+=m)
+        {
+            twidx = 0;
+            F[k] = scratch[0];
+            for (q=1;q<p;q++)
+            {
+                twidx += fstride*k;
+                if (twidx>=M)
+                    twidx -= M;
+                t.re = scratch[q].re*tw[twidx].re - scratch[q].im*tw[twidx].im;
+                t.im = scratch[q].re*tw[twidx].im + scratch[q].im*tw[twidx].re;
+                F[k].re += t.re;
+                F[k].im += t.im;
+            }
+        }
+    }
+}
+
+/* Recursive decimation-in-time complex forward FFT of length N/2 (out-of-place) */
+static void vtMixedRadixWork(vtFFT* h, vtCpx* out, const vtCpx* in, int fstride, const int* factors)
+{
+    int j, p, m;
+    p = factors[0];
+    m = factors[1];
+    if (m==1)
+    {
+        for (j=0;j<p;j++)
+            out[j] = in[j*fstride];
+    }
+    else
+    {
+        for (j=0;j<p;j++)
+            vtMixedRadixWork(h, &(out[j*m]), &(in[j*fstride]), fstride*p, factors+2);
+    }
+    switch (p) {
+        case 2: vtBfly2(out, (const vtCpx*)h->mrTwiddles, fstride, m); break;
+        case 3: vtBfly3(out, (const vtCpx*)h->mrTwiddles, fstride, m); break;
+        case 4: vtBfly4(out, (const vtCpx*)h->mrTwiddles, fstride, m); break;
+        default: vtBflyGeneric(out, (const vtCpx*)h->mrTwiddles, (vtCpx*)h->mrScratch, fstride, m, p, (h->N)/2); break;
+    }
+}
+
+/* Real forward FFT: the even and odd time-domain samples are treated as the real and imaginary parts of a complex
+ * sequence of length N/2, the spectrum of which is then separated into that of the real sequence */
+static void vtMixedRadixForward(vtFFT* h, float* timeData, float* re, float* im, int stride)
+{
+    int k, M;
+    float dr, di, er, ei, fr, fi;
+    vtCpx *Z;
+    const vtCpx *W;
+    
+    M = (h->N)/2;
+    Z = (vtCpx*)h->mrWork;
+    W = (const vtCpx*)h->mrPostTwiddles;
+    vtMixedRadixWork(h, Z, (vtCpx*)timeData, 1, h->factors);
+    re[0] = VT_MR_FORWARD_SCALE*(Z[0].re + Z[0].im);
+    re[M*stride] = VT_MR_FORWARD_SCALE*(Z[0].re - Z[0].im);
+    for (k=1;k<M;k++)
+    {
+        er = 0.5f*(Z[k].re + Z[M-k].re);
+        ei = 0.5f*(Z[k].im - Z[M-k].im);
+        dr = 0.5f*(Z[k].re - Z[M-k].re);
+        di = 0.5f*(Z[k].im + Z[M-k].im);
+        /* odd part: -i*(dr + i*di) = di - i*dr */
+        fr = di*W[k].re + dr*W[k].im;
+        fi = di*W[k].im - dr*W[k].re;
+        re[k*stride] = VT_MR_FORWARD_SCALE*(er + fr);
+        im[k*stride] = VT_MR_FORWARD_SCALE*(ei + fi);
+    }
+}
+
+/* Real inverse FFT: the reverse of the above, where the complex inverse FFT is computed as conj(FFT(conj(.))) */
+static void vtMixedRadixInverse(vtFFT* h, float* re, float* im, int stride, float* timeData)
+{
+    int k, M;
+    float ar, ai, br, bi, dr, di, fr, fi;
+    vtCpx *Z, *z;
+    const vtCpx *W;
+    
+    M = (h->N)/2;
+    Z = (vtCpx*)h->mrWork;
+    W = (const vtCpx*)h->mrPostTwiddles;
+    z = (vtCpx*)timeData;
+    for (k=0;k<M;k++)
+    {
+        /* the imaginary parts of the DC and Nyquist bins are ignored */
+        ar = re[k*stride];
+        ai = k==0 ? 0.0f : im[k*stride];
+        br = re[(M-k)*stride];
+        bi = k==0 ? 0.0f : -im[(M-k)*stride];
+        dr = ar - br;
+        di = ai - bi;
+        fr = dr*W[k].re + di*W[k].im;
+        fi = di*W[k].re - dr*W[k].im;
+        Z[k].re = VT_MR_INVERSE_SCALE*(ar + br - fi);
+        Z[k].im = -VT_MR_INVERSE_SCALE*(ai + bi + fr);
+    }
+    vtMixedRadixWork(h, z, Z, 1, h->factors);
+    for (k=0;k<M;k++)
+        z[k].im = -z[k].im;
+}
+#endif
+
 
 /* FFT INITIALIZATION */
-void vtInitFFT(void** planPr, float* timeData, float* frequencyData, int log2n)
+void vtInitFFT_length(void** planPr, float* timeData, float* frequencyData, int N)
 {
     *planPr = (void*)malloc(sizeof(vtFFT));
     vtFFT *h = (vtFFT*)(*planPr);
     h->timeData = timeData;
     h->frequencyData = frequencyData;
-    h->N = (int)pow(2,log2n);
-    h->log2n = log2n;
-#ifdef VDSP
-    h->FFT = (void*)vDSP_create_fftsetup( h->log2n, FFT_RADIX2);
+    h->N = N;
+    for (h->log2n=0; (1<<h->log2n)<N; h->log2n++);
+#if !defined(FFTW)
+    h->tables = (void*)vtAcquireFFTtables(N);
+    h->mixedRadix = 0;
+    if (!vtIsPow2(N))
+    {
+        vtMixedRadixInit(h);
+        return;
+    }
+#endif
+#if defined(VDSP)
+    h->FFT = ((vtFFTtables*)h->tables)->FFT;
     h->VDSP_split.realp = frequencyData;
     h->VDSP_split.imagp = &(frequencyData[(h->N)/2]);
+#elif defined(FFTW)
+    /* FFTW writes straight into separate real and imaginary vectors with the "split" guru interface */
+    fftwf_iodim dim;
+    dim.n = h->N;
+    dim.is = 1;
+    dim.os = 1;
+    h->re = (float*)fftwf_malloc(sizeof(float)*((h->N)/2+1));
+    h->im = (float*)fftwf_malloc(sizeof(float)*((h->N)/2+1));
+    h->td = (float*)fftwf_malloc(sizeof(float)*(h->N));
+    /* The FFTW planner is not thread-safe. Note that FFTW already shares its twiddle tables between plans internally */
+    vtCacheLock();
+    h->forwardPlan = fftwf_plan_guru_split_dft_r2c(1, &dim, 0, NULL, h->td, h->re, h->im, FFTW_ESTIMATE);
+    h->inversePlan = fftwf_plan_guru_split_dft_c2r(1, &dim, 0, NULL, h->re, h->im, h->td, FFTW_ESTIMATE | FFTW_PRESERVE_INPUT);
+    vtCacheUnlock();
+    h->alignment = fftwf_alignment_of(h->re);
+    h->alignmentTD = fftwf_alignment_of(h->td);
 #else
     /* Ooura */
-    h->w = (float*)malloc(sizeof(float)*(h->N)/2);
+    h->w = ((vtFFTtables*)h->tables)->w;
     h->ip = (int*)malloc(sizeof(int)*(2+h->N));
+    memcpy(h->ip, ((vtFFTtables*)h->tables)->ip, sizeof(int)*(2+h->N));
     h->a = (float*)malloc(sizeof(float)*(h->N));
-    h->ip[0]=0;
-    rdft(h->N,1,h->a, h->ip, h->w);
 #endif
 }
 
+void vtInitFFT(void** planPr, float* timeData, float* frequencyData, int log2n)
+{
+    vtInitFFT_length(planPr, timeData, frequencyData, 1<<log2n);
+}
+
 /* FFT FREE */
 void vtFreeFFT(void* planPr)
 {
     vtFFT *h = (vtFFT*)(planPr);
-#ifdef VDSP
-    vDSP_destroy_fftsetup(h->FFT);
+#if !defined(FFTW)
+    if (h->mixedRadix)
+        vtMixedRadixFree(h);
+#if !defined(VDSP)
+    else
+    {
+        free(h->ip);
+        free(h->a);
+    }
+#endif
+    vtReleaseFFTtables((vtFFTtables*)h->tables);
 #else
-    free(h->w);
-    free(h->ip);
-    free(h->a);
+    vtCacheLock();
+    fftwf_destroy_plan(h->forwardPlan);
+    fftwf_destroy_plan(h->inversePlan);
+    vtCacheUnlock();
+    fftwf_free(h->re);
+    fftwf_free(h->im);
+    fftwf_free(h->td);
 #endif
     free(planPr);
 }
@@ -95,7 +584,28 @@ void vtFreeFFT(void* planPr)
 void vtRunFFT(void* planPr, int positiveForForwardTransform)
 {
     vtFFT *h = (vtFFT*)planPr;
-#ifdef VDSP
+#if !defined(FFTW)
+    /* The packed format is retained, i.e. the Nyquist is stored in place of the DC imaginary part */
+    if (h->mixedRadix)
+    {
+        if (positiveForForwardTransform > 0)
+        {
+            vtMixedRadixForward(h, h->timeData, h->mrRe, h->mrIm, 1);
+            memcpy(h->frequencyData, h->mrRe, sizeof(float)*(h->N)/2);
+            memcpy(h->frequencyData+(h->N)/2+1, h->mrIm+1, sizeof(float)*((h->N)/2-1));
+            h->frequencyData[(h->N)/2] = h->mrRe[(h->N)/2];
+        }
+        else
+        {
+            memcpy(h->mrRe, h->frequencyData, sizeof(float)*(h->N)/2);
+            memcpy(h->mrIm+1, h->frequencyData+(h->N)/2+1, sizeof(float)*((h->N)/2-1));
+            h->mrRe[(h->N)/2] = h->frequencyData[(h->N)/2];
+            vtMixedRadixInverse(h, h->mrRe, h->mrIm, 1, h->timeData);
+        }
+        return;
+    }
+#endif
+#if defined(VDSP)
     if (positiveForForwardTransform > 0) /* FORWARD FFT */
     {
         vDSP_ctoz((DSPComplex*)(h->timeData), 2, &(h->VDSP_split), 1, (h->N)/2);
@@ -106,6 +616,28 @@ void vtRunFFT(void* planPr, int positiveForForwardTransform)
         vDSP_fft_zrip(h->FFT,&(h->VDSP_split),1, h->log2n, FFT_INVERSE);
         vDSP_ztoc(&(h->VDSP_split),1, (DSPComplex*)h->timeData, 2, (h->N)/2);
     }
+#elif defined(FFTW)
+    /* The packed format of vDSP is retained, i.e. the Nyquist is stored in place of the DC imaginary part */
+    int k;
+    if (positiveForForwardTransform > 0)
+    {
+        vtRunFFTforward_split(planPr, h->timeData, h->re, h->im, 1);
+        memcpy(h->frequencyData, h->re, sizeof(float)*(h->N)/2);
+        memcpy(h->frequencyData+(h->N)/2, h->im, sizeof(float)*(h->N)/2);
+        h->frequencyData[(h->N)/2] = h->re[(h->N)/2];
+    }
+    else
+    {
+        /* same scaling as the Ooura implementation */
+        for (k=0;k<(h->N)/2;k++)
+        {
+            h->re[k] = VT_INVERSE_SPLIT_SCALE*h->frequencyData[k];
+            h->im[k] = VT_INVERSE_SPLIT_SCALE*h->frequencyData[k+(h->N)/2];
+        }
+        h->re[(h->N)/2] = VT_INVERSE_SPLIT_SCALE*h->frequencyData[(h->N)/2];
+        h->im[0] = h->im[(h->N)/2] = 0.0f;
+        vtRunFFTinverse_split(planPr, h->re, h->im, 1, h->timeData);
+    }
 #else
     /* Note (A): The phase is conjugated below for Ooura's FFT to produce the same output than that of the vDSP FFT. */
     int k;
@@ -133,3 +665,120 @@ void vtRunFFT(void* planPr, int positiveForForwardTransform)
     }
 #endif
 }
+
+/* FORWARD FFT RUN, WITH THE OUTPUT WRITTEN DIRECTLY TO SEPARATE REAL AND IMAGINARY VECTORS (N/2+1, STRIDED) */
+void vtRunFFTforward_split(void* planPr, float* timeData, float* re, float* im, int stride)
+{
+    vtFFT *h = (vtFFT*)planPr;
+    int halfN = (h->N)/2;
+#if !defined(FFTW)
+    if (h->mixedRadix)
+    {
+        vtMixedRadixForward(h, timeData, re, im, stride);
+        im[0] = 0.0f;
+        im[halfN*stride] = 0.0f;
+        return;
+    }
+#endif
+#if defined(VDSP)
+    /* vDSP only writes contiguous vectors, so strided output goes through the internal buffers */
+    int k;
+    DSPSplitComplex split;
+    split.realp = stride==1 ? re : h->VDSP_split.realp;
+    split.imagp = stride==1 ? im : h->VDSP_split.imagp;
+    vDSP_ctoz((DSPComplex*)timeData, 2, &split, 1, halfN);
+    vDSP_fft_zrip((FFTSetup)(h->FFT), &split, 1, h->log2n, FFT_FORWARD);
+    re[halfN*stride] = split.imagp[0]; /* unpack the Nyquist */
+    if (stride!=1)
+    {
+        for (k=0;k<halfN;k++)
+        {
+            re[k*stride] = split.realp[k];
+            im[k*stride] = split.imagp[k];
+        }
+    }
+#elif defined(FFTW)
+    /* new-array execution requires the same alignment (and stride) as the arrays used for planning */
+    int k;
+    if (stride == 1 && fftwf_alignment_of(re) == h->alignment && fftwf_alignment_of(im) == h->alignment &&
+        fftwf_alignment_of(timeData) == h->alignmentTD)
+        fftwf_execute_split_dft_r2c(h->forwardPlan, timeData, re, im);
+    else
+    {
+        memcpy(h->td, timeData, sizeof(float)*(h->N));
+        fftwf_execute(h->forwardPlan);
+        for (k=0;k<=halfN;k++)
+        {
+            re[k*stride] = h->re[k];
+            im[k*stride] = h->im[k];
+        }
+    }
+#else
+    /* Ooura's FFT is applied in-place on the time-domain data, which is then de-interleaved. Check note (A) above */
+    int k;
+    float* a = timeData;
+    rdft(h->N, 1, a, h->ip, h->w);
+    re[0] = a[0];
+    re[halfN*stride] = a[1];
+    for (k=1;k<halfN;k++)
+    {
+        re[k*stride] = a[2*k];
+        im[k*stride] = -a[2*k+1];
+    }
+#endif
+    im[0] = 0.0f;            /* DC im = 0 */
+    im[halfN*stride] = 0.0f; /* Nyquist im = 0 */
+}
+
+/* INVERSE FFT RUN, WITH THE INPUT TAKEN DIRECTLY FROM SEPARATE REAL AND IMAGINARY VECTORS (N/2+1, STRIDED) */
+void vtRunFFTinverse_split(void* planPr, float* re, float* im, int stride, float* timeData)
+{
+    vtFFT *h = (vtFFT*)planPr;
+    int halfN = (h->N)/2;
+#if !defined(FFTW)
+    if (h->mixedRadix)
+    {
+        vtMixedRadixInverse(h, re, im, stride, timeData);
+        return;
+    }
+#endif
+#if defined(VDSP)
+    /* vDSP only operates in-place on its packed format, so the input is copied to the internal buffers */
+    int k;
+    for (k=0;k<halfN;k++)
+    {
+        h->VDSP_split.realp[k] = re[k*stride];
+        h->VDSP_split.imagp[k] = im[k*stride];
+    }
+    h->VDSP_split.imagp[0] = re[halfN*stride];
+    vDSP_fft_zrip(h->FFT,&(h->VDSP_split),1, h->log2n, FFT_INVERSE);
+    vDSP_ztoc(&(h->VDSP_split),1, (DSPComplex*)timeData, 2, halfN);
+#elif defined(FFTW)
+    int k;
+    if (stride == 1 && fftwf_alignment_of(re) == h->alignment && fftwf_alignment_of(im) == h->alignment &&
+        fftwf_alignment_of(timeData) == h->alignmentTD)
+        fftwf_execute_split_dft_c2r(h->inversePlan, re, im, timeData);
+    else
+    {
+        for (k=0;k<=halfN;k++)
+        {
+            h->re[k] = re[k*stride];
+            h->im[k] = im[k*stride];
+        }
+        fftwf_execute(h->inversePlan);
+        memcpy(timeData, h->td, sizeof(float)*(h->N));
+    }
+#else
+    /* Interleaved directly into the time-domain buffer, where Ooura's inverse FFT is applied in-place. Check note (A) above */
+    int k;
+    float* a = timeData;
+    a[0] = 4.0f*re[0];
+    a[1] = 4.0f*re[halfN*stride];
+    for (k=1;k<halfN;k++)
+    {
+        a[2*k] = 4.0f*re[k*stride];
+        a[2*k+1] = -4.0f*im[k*stride];
+    }
+    rdft(h->N, -1, a, h->ip, h->w);
+#endif
+}
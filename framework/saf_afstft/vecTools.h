@@ -23,13 +23,20 @@
 #ifndef __afSTFT_MEXfile__vecTools__
 #define __afSTFT_MEXfile__vecTools__
 
-#ifdef __APPLE__
+/* FFT backend selection: define SAF_USE_FFTW to use the FFTW3 (single precision) library.
+ * Otherwise, the vDSP FFT is used for Mac OSX and Ooura's FFT is used for other platforms. */
+#if defined(SAF_USE_FFTW)
+  #define FFTW 1
+#elif defined(__APPLE__)
   #define VDSP 1
 #endif
 
 #ifdef VDSP
 #include <Accelerate/Accelerate.h>
 #endif
+#ifdef FFTW
+#include <fftw3.h>
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
@@ -42,18 +49,69 @@ typedef struct {
     float *frequencyData;
     int N;
     int log2n;
-#ifdef VDSP
+#if defined(VDSP)
     FFTSetup FFT;
     DSPSplitComplex VDSP_split;
+#elif defined(FFTW)
+    fftwf_plan forwardPlan;
+    fftwf_plan inversePlan;
+    float *re,*im,*td; /* private buffers the plans are made with, so that the caller's data is never used as workspace */
+    int alignment;
+    int alignmentTD;
 #else
     float *a,*w;
     int *ip;
 #endif
+#if !defined(FFTW)
+    /* The tables of the FFT (vDSP setup, Ooura's w, and the mixed-radix factors and twiddles) are shared read-only
+     * by all instances of the same length, and are reference counted */
+    void *tables;
+    /* Mixed-radix FFT, used instead of the above for non-power-of-two lengths. The real FFT of length N is
+     * computed via a complex FFT of length N/2, which is factorised into radices of 4, 2, 3, 5, ... */
+    int mixedRadix;
+    const int *factors;
+    const float *mrTwiddles;
+    const float *mrPostTwiddles;
+    float *mrWork;
+    float *mrScratch;
+    float *mrRe, *mrIm;
+#endif
 } vtFFT;
 
+/* Process-wide lock, which guards the caches of the tables that are shared between instances */
+void vtCacheLock(void);
+
+void vtCacheUnlock(void);
+
 void vtClr(float* vec, int N);
 
+void vtVmul(float* vec1, float* vec2, float* vec3, int N);
+
 void vtVma(float* vec1, float* vec2, float* vec3, int N);
 
+/* vec2 = scalar*vec1 */
+void vtVsmul(float* vec1, float scalar, float* vec2, int N);
+
+/* vec2 += scalar*vec1 */
+void vtVsma(float* vec1, float scalar, float* vec2, int N);
+
+/* FFTW's unnormalised inverse FFT is half of that of the Ooura/vDSP implementations */
+#if defined(FFTW)
+  #define VT_INVERSE_SPLIT_SCALE ( 2.0f )
+#else
+  #define VT_INVERSE_SPLIT_SCALE ( 1.0f )
+#endif
+
+/* Forward FFT of time-domain data (length N), written directly into separate re/im vectors of N/2+1 bins, where bin
+ * "k" is stored at re[k*stride] and im[k*stride] (e.g. re=&c[0], im=&c[1], stride=2 for interleaved complex data).
+ * Note: the time-domain data is used as workspace and is overwritten */
+void vtRunFFTforward_split(void* planPr, float* timeData, float* re, float* im, int stride);
+
+/* Inverse FFT of separate re/im vectors of N/2+1 bins (with the same "stride" as above), written directly into
+ * time-domain data (length N).
+ * Note: the output is scaled by 1/VT_INVERSE_SPLIT_SCALE relative to vtRunFFT(), the remaining factor is to be applied
+ * by the caller (e.g. folded into its synthesis window) */
+void vtRunFFTinverse_split(void* planPr, float* re, float* im, int stride, float* timeData);
+
 
 #endif /* defined(__afSTFT_MEXfile__vecTools__) */
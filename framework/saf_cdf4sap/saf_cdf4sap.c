@@ -277,7 +277,7 @@ void cdf4sap_formulate_M_and_Cr
 {
     cdf4sap *pData = (cdf4sap*)(hCdf);
     int i, j;
-    int m, n, lda, ldu, ldvt, info, lwork;
+    int m, n, lda, ldu, ldvt, info, lwork, svdFailed;
     int xsize, ysize, qsize1, qsize2;
     float lim;
     float_complex tmp;
@@ -294,6 +294,7 @@ void cdf4sap_formulate_M_and_Cr
     memset(pData->G_hat, 0, qsize1*qsize1 * sizeof(float));
     memset(pData->G, 0, ysize*ysize * sizeof(float));
     memset(pData->lambda, 0, qsize1*qsize2 * sizeof(float));
+    svdFailed = 0;
 
     float wkopt;
     float* work;
@@ -315,23 +316,30 @@ void cdf4sap_formulate_M_and_Cr
         for (j = 0; j<ysize; j++)
             pData->A_Cy[j*ysize + i] = Cy[i][j]; /* store in column-major order */
     lwork = -1;
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     sgesvd_("A", "N", (__CLPK_integer*)&m, (__CLPK_integer*)&n, pData->A_Cy, (__CLPK_integer*)&lda, pData->S_Cy, pData->U_Cy,
             (__CLPK_integer*)&ldu, pData->VT_Cy, (__CLPK_integer*)&ldvt, &wkopt, (__CLPK_integer*)&lwork, (__CLPK_integer*)&info);
-#else
+#elif defined(SAF_USE_INTEL_MKL)
     sgesvd_("A", "N", &m, &n, pData->A_Cy, &lda, pData->S_Cy, pData->U_Cy,
             &ldu, pData->VT_Cy, &ldvt, &wkopt, &lwork, &info);
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_sgesvd_work(LAPACK_COL_MAJOR, 'A', 'N', m, n, pData->A_Cy, lda, pData->S_Cy, pData->U_Cy,
+                               ldu, pData->VT_Cy, ldvt, &wkopt, lwork);
 #endif
     lwork = (int)wkopt;
     work = (float*)malloc(lwork * sizeof(float));
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     sgesvd_("A", "N", (__CLPK_integer*)&m, (__CLPK_integer*)&n, pData->A_Cy, (__CLPK_integer*)&lda, pData->S_Cy, pData->U_Cy,
             (__CLPK_integer*)&ldu, pData->VT_Cy, (__CLPK_integer*)&ldvt, work, (__CLPK_integer*)&lwork, (__CLPK_integer*)&info);
-#else
+#elif defined(SAF_USE_INTEL_MKL)
     sgesvd_("A", "N", &m, &n, pData->A_Cy, &lda, pData->S_Cy, pData->U_Cy,
             &ldu, pData->VT_Cy, &ldvt, work, &lwork, &info);
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_sgesvd_work(LAPACK_COL_MAJOR, 'A', 'N', m, n, pData->A_Cy, lda, pData->S_Cy, pData->U_Cy,
+                               ldu, pData->VT_Cy, ldvt, work, lwork);
 #endif
     free((void*)work);
+    svdFailed = svdFailed || info!=0;
     for (i = 0; i<ysize; i++)
         pData->S_Cy_Mtx[i*ysize + i] = sqrtf(MAX(2e-13f, pData->S_Cy[i]));
     cblas_sgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, ysize, ysize, ysize, 1,
@@ -345,23 +353,30 @@ void cdf4sap_formulate_M_and_Cr
         for (j = 0; j<xsize; j++)
             pData->A_Cx[j*xsize + i] = Cx[i][j];
     lwork = -1;
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     sgesvd_("A", "N", (__CLPK_integer*)&m, (__CLPK_integer*)&n, pData->A_Cx, (__CLPK_integer*)&lda, pData->S_Cx, pData->U_Cx,
             (__CLPK_integer*)&ldu, pData->VT_Cx, (__CLPK_integer*)&ldvt, &wkopt, (__CLPK_integer*)&lwork, (__CLPK_integer*)&info);
-#else
+#elif defined(SAF_USE_INTEL_MKL)
     sgesvd_("A", "N", &m, &n, pData->A_Cx, &lda, pData->S_Cx, pData->U_Cx,
             &ldu, pData->VT_Cx, &ldvt, &wkopt, &lwork, &info);
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_sgesvd_work(LAPACK_COL_MAJOR, 'A', 'N', m, n, pData->A_Cx, lda, pData->S_Cx, pData->U_Cx,
+                               ldu, pData->VT_Cx, ldvt, &wkopt, lwork);
 #endif
     lwork = (int)wkopt;
     work = (float*)malloc(lwork * sizeof(float));
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     sgesvd_("A", "N", (__CLPK_integer*)&m, (__CLPK_integer*)&n, pData->A_Cx, (__CLPK_integer*)&lda, pData->S_Cx, pData->U_Cx,
             (__CLPK_integer*)&ldu, pData->VT_Cx, (__CLPK_integer*)&ldvt, work, (__CLPK_integer*)&lwork, (__CLPK_integer*)&info);
-#else
+#elif defined(SAF_USE_INTEL_MKL)
     sgesvd_("A", "N", &m, &n, pData->A_Cx, &lda, pData->S_Cx, pData->U_Cx,
             &ldu, pData->VT_Cx, &ldvt, work, &lwork, &info);
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_sgesvd_work(LAPACK_COL_MAJOR, 'A', 'N', m, n, pData->A_Cx, lda, pData->S_Cx, pData->U_Cx,
+                               ldu, pData->VT_Cx, ldvt, work, lwork);
 #endif
     free((void*)work);
+    svdFailed = svdFailed || info!=0;
     for (i = 0; i<xsize; i++)
         pData->S_Cx_Mtx[i*xsize + i] = sqrtf(MAX(2e-13f, pData->S_Cx[i]));
     cblas_sgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, xsize, xsize, xsize, 1,
@@ -421,23 +436,30 @@ void cdf4sap_formulate_M_and_Cr
                 pData->KxQGKy, qsize2);
     m = qsize2; n = qsize1; lda = qsize2; ldu = qsize2; ldvt = qsize1;
     lwork = -1;
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     sgesvd_("A", "A", (__CLPK_integer*)&m, (__CLPK_integer*)&n, pData->KxQGKy, (__CLPK_integer*)&lda, pData->S, pData->U,
             (__CLPK_integer*)&ldu, pData->VT, (__CLPK_integer*)&ldvt, &wkopt, (__CLPK_integer*)&lwork, (__CLPK_integer*)&info);
-#else
+#elif defined(SAF_USE_INTEL_MKL)
     sgesvd_("A", "A", &m, &n, pData->KxQGKy, &lda, pData->S, pData->U,
             &ldu, pData->VT, &ldvt, &wkopt, &lwork, &info);
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_sgesvd_work(LAPACK_COL_MAJOR, 'A', 'A', m, n, pData->KxQGKy, lda, pData->S, pData->U,
+                               ldu, pData->VT, ldvt, &wkopt, lwork);
 #endif
     lwork = (int)wkopt;
     work = (float*)malloc(lwork * sizeof(float));
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     sgesvd_("A", "A", (__CLPK_integer*)&m, (__CLPK_integer*)&n, pData->KxQGKy, (__CLPK_integer*)&lda, pData->S, pData->U,
             (__CLPK_integer*)&ldu, pData->VT, (__CLPK_integer*)&ldvt, work, (__CLPK_integer*)&lwork, (__CLPK_integer*)&info);
-#else
+#elif defined(SAF_USE_INTEL_MKL)
     sgesvd_("A", "A", &m, &n, pData->KxQGKy, &lda, pData->S, pData->U,
             &ldu, pData->VT, &ldvt, work, &lwork, &info);
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_sgesvd_work(LAPACK_COL_MAJOR, 'A', 'A', m, n, pData->KxQGKy, lda, pData->S, pData->U,
+                               ldu, pData->VT, ldvt, work, lwork);
 #endif
     free((void*)work);
+    svdFailed = svdFailed || info!=0;
     cblas_sgemm(CblasColMajor, CblasTrans, CblasNoTrans, qsize1, qsize2, qsize1, 1,
                 pData->VT, qsize1, /* remember lapack returned VT not V! */
                 pData->lambda, qsize1, 0,
@@ -484,6 +506,15 @@ void cdf4sap_formulate_M_and_Cr
     }  
 
     /* output */
+    if (svdFailed) {
+        /* a decomposition did not converge: no mixing, and so the residual is all of Cy */
+        for (i = 0; i<qsize1; i++) {
+            memset(M[i], 0, qsize2 * sizeof(float));
+            for (j = 0; j<qsize1; j++)
+                Cr[i][j] = Cy[i][j];
+        }
+        return;
+    }
     for (i = 0; i<qsize1; i++)
         for (j = 0; j<qsize2; j++)
             M[i][j] = pData->M_CM[j*qsize1 + i]; /* transpose - back to row major */
@@ -509,7 +540,7 @@ void cdf4sap_formulate_M_and_Cr_cmplx
 {
     cdf4sap_cmplx *pData = (cdf4sap_cmplx*)(hCdf);
     int i, j;
-    int m, n, lda, ldu, ldvt, info, lwork;
+    int m, n, lda, ldu, ldvt, info, lwork, svdFailed;
     int xsize, ysize, qsize1, qsize2;
     float lim;
     float_complex tmp;
@@ -527,6 +558,7 @@ void cdf4sap_formulate_M_and_Cr_cmplx
     memset(pData->G_hat, 0, qsize1*qsize1 * sizeof(float_complex));
     memset(pData->G, 0, ysize*ysize * sizeof(float_complex));
     memset(pData->lambda, 0, qsize1*qsize2 * sizeof(float_complex));
+    svdFailed = 0;
     
     float* rwork;
     float_complex wkopt;
@@ -550,24 +582,31 @@ void cdf4sap_formulate_M_and_Cr_cmplx
         for (j = 0; j<ysize; j++)
             pData->A_Cy[j*ysize + i] = Cy[i][j]; /* store in column-major order */
     lwork = -1;
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     cgesvd_("A", "N", (__CLPK_integer*)&m, (__CLPK_integer*)&n, (__CLPK_complex*)pData->A_Cy, (__CLPK_integer*)&lda, pData->S_Cy_real, (__CLPK_complex*)pData->U_Cy,
             (__CLPK_integer*)&ldu, (__CLPK_complex*)pData->VH_Cy, (__CLPK_integer*)&ldvt, (__CLPK_complex*)&wkopt, (__CLPK_integer*)&lwork, rwork, (__CLPK_integer*)&info);
-#elif INTEL_MKL_VERSION
+#elif defined(SAF_USE_INTEL_MKL)
     cgesvd_("A", "N", &m, &n, (MKL_Complex8*)pData->A_Cy, &lda, pData->S_Cy_real, (MKL_Complex8*)pData->U_Cy,
             &ldu, (MKL_Complex8*)pData->VH_Cy, &ldvt, (MKL_Complex8*)&wkopt, &lwork, rwork, &info);
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_cgesvd_work(LAPACK_COL_MAJOR, 'A', 'N', m, n, (lapack_complex_float*)pData->A_Cy, lda, pData->S_Cy_real, (lapack_complex_float*)pData->U_Cy,
+                               ldu, (lapack_complex_float*)pData->VH_Cy, ldvt, (lapack_complex_float*)&wkopt, lwork, rwork);
 #endif
     lwork = (int)crealf(wkopt);
     work = (float_complex*)malloc(lwork * sizeof(float_complex));
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     cgesvd_("A", "N", (__CLPK_integer*)&m, (__CLPK_integer*)&n, (__CLPK_complex*)pData->A_Cy, (__CLPK_integer*)&lda, pData->S_Cy_real, (__CLPK_complex*)pData->U_Cy,
             (__CLPK_integer*)&ldu, (__CLPK_complex*)pData->VH_Cy, (__CLPK_integer*)&ldvt, (__CLPK_complex*)work, (__CLPK_integer*)&lwork, rwork, (__CLPK_integer*)&info);
-#elif INTEL_MKL_VERSION
+#elif defined(SAF_USE_INTEL_MKL)
     cgesvd_("A", "N", &m, &n, (MKL_Complex8*)pData->A_Cy, &lda, pData->S_Cy_real, (MKL_Complex8*)pData->U_Cy,
             &ldu, (MKL_Complex8*)pData->VH_Cy, &ldvt, (MKL_Complex8*)work, &lwork, rwork, &info);
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_cgesvd_work(LAPACK_COL_MAJOR, 'A', 'N', m, n, (lapack_complex_float*)pData->A_Cy, lda, pData->S_Cy_real, (lapack_complex_float*)pData->U_Cy,
+                               ldu, (lapack_complex_float*)pData->VH_Cy, ldvt, (lapack_complex_float*)work, lwork, rwork);
 #endif
     free((void*)work);
     free((void*)rwork);
+    svdFailed = svdFailed || info!=0;
     for (i = 0; i<ysize; i++)
         pData->S_Cy_Mtx[i*ysize + i] = cmplxf(sqrtf(MAX(pData->S_Cy_real[i], 2e-13f)), 0.0f);
     cblas_cgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, ysize, ysize, ysize, &calpha,
@@ -582,24 +621,31 @@ void cdf4sap_formulate_M_and_Cr_cmplx
         for (j = 0; j<xsize; j++)
             pData->A_Cx[j*xsize + i] = Cx[i][j];
     lwork = -1;
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     cgesvd_("A", "N", (__CLPK_integer*)&m, (__CLPK_integer*)&n, (__CLPK_complex*)pData->A_Cx, (__CLPK_integer*)&lda, pData->S_Cx_real, (__CLPK_complex*)pData->U_Cx,
             (__CLPK_integer*)&ldu, (__CLPK_complex*)pData->VH_Cx, (__CLPK_integer*)&ldvt, (__CLPK_complex*)&wkopt, (__CLPK_integer*)&lwork, rwork, (__CLPK_integer*)&info);
-#elif INTEL_MKL_VERSION
+#elif defined(SAF_USE_INTEL_MKL)
     cgesvd_("A", "N", &m, &n, (MKL_Complex8*)pData->A_Cx, &lda, pData->S_Cx_real, (MKL_Complex8*)pData->U_Cx,
             &ldu, (MKL_Complex8*)pData->VH_Cx, &ldvt, (MKL_Complex8*)&wkopt, &lwork, rwork, &info);
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_cgesvd_work(LAPACK_COL_MAJOR, 'A', 'N', m, n, (lapack_complex_float*)pData->A_Cx, lda, pData->S_Cx_real, (lapack_complex_float*)pData->U_Cx,
+                               ldu, (lapack_complex_float*)pData->VH_Cx, ldvt, (lapack_complex_float*)&wkopt, lwork, rwork);
 #endif
     lwork = (int)crealf(wkopt);
     work = (float_complex*)malloc(lwork * sizeof(float_complex));
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     cgesvd_("A", "N", (__CLPK_integer*)&m, (__CLPK_integer*)&n, (__CLPK_complex*)pData->A_Cx, (__CLPK_integer*)&lda, pData->S_Cx_real, (__CLPK_complex*)pData->U_Cx,
             (__CLPK_integer*)&ldu, (__CLPK_complex*)pData->VH_Cx, (__CLPK_integer*)&ldvt, (__CLPK_complex*)work, (__CLPK_integer*)&lwork, rwork, (__CLPK_integer*)&info);
-#elif INTEL_MKL_VERSION
+#elif defined(SAF_USE_INTEL_MKL)
     cgesvd_("A", "N", &m, &n, (MKL_Complex8*)pData->A_Cx, &lda, pData->S_Cx_real, (MKL_Complex8*)pData->U_Cx,
             &ldu, (MKL_Complex8*)pData->VH_Cx, &ldvt, (MKL_Complex8*)work, &lwork, rwork, &info);
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_cgesvd_work(LAPACK_COL_MAJOR, 'A', 'N', m, n, (lapack_complex_float*)pData->A_Cx, lda, pData->S_Cx_real, (lapack_complex_float*)pData->U_Cx,
+                               ldu, (lapack_complex_float*)pData->VH_Cx, ldvt, (lapack_complex_float*)work, lwork, rwork);
 #endif
     free((void*)work);
     free((void*)rwork);
+    svdFailed = svdFailed || info!=0;
     for (i = 0; i<xsize; i++)
         pData->S_Cx_Mtx[i*xsize + i] =  cmplxf(sqrtf(MAX(pData->S_Cx_real[i], 2e-13f)), 0.0f);
     cblas_cgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, xsize, xsize, xsize, &calpha,
@@ -660,24 +706,31 @@ void cdf4sap_formulate_M_and_Cr_cmplx
     m = qsize2; n = qsize1; lda = qsize2; ldu = qsize2; ldvt = qsize1;
     rwork = (float*)malloc(MAX( 1, 5*MIN(m,n) )*sizeof(float));
     lwork = -1;
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     cgesvd_("A", "A", (__CLPK_integer*)&m, (__CLPK_integer*)&n, (__CLPK_complex*)pData->KxQGKy, (__CLPK_integer*)&lda, pData->S_real, (__CLPK_complex*)pData->U,
             (__CLPK_integer*)&ldu, (__CLPK_complex*)pData->VH, (__CLPK_integer*)&ldvt, (__CLPK_complex*)&wkopt, (__CLPK_integer*)&lwork, rwork, (__CLPK_integer*)&info);
-#elif INTEL_MKL_VERSION
+#elif defined(SAF_USE_INTEL_MKL)
     cgesvd_("A", "A", &m, &n, (MKL_Complex8*)pData->KxQGKy, &lda, pData->S_real, (MKL_Complex8*)pData->U,
             &ldu, (MKL_Complex8*)pData->VH, &ldvt, (MKL_Complex8*)&wkopt, &lwork, rwork, &info);
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_cgesvd_work(LAPACK_COL_MAJOR, 'A', 'A', m, n, (lapack_complex_float*)pData->KxQGKy, lda, pData->S_real, (lapack_complex_float*)pData->U,
+                               ldu, (lapack_complex_float*)pData->VH, ldvt, (lapack_complex_float*)&wkopt, lwork, rwork);
 #endif
     lwork = (int)crealf(wkopt);
     work = (float_complex*)malloc(lwork * sizeof(float_complex));
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     cgesvd_("A", "A", (__CLPK_integer*)&m, (__CLPK_integer*)&n, (__CLPK_complex*)pData->KxQGKy, (__CLPK_integer*)&lda, pData->S_real, (__CLPK_complex*)pData->U,
             (__CLPK_integer*)&ldu, (__CLPK_complex*)pData->VH, (__CLPK_integer*)&ldvt, (__CLPK_complex*)work, (__CLPK_integer*)&lwork, rwork, (__CLPK_integer*)&info);
-#elif INTEL_MKL_VERSION
+#elif defined(SAF_USE_INTEL_MKL)
     cgesvd_("A", "A", &m, &n, (MKL_Complex8*)pData->KxQGKy, &lda, pData->S_real, (MKL_Complex8*)pData->U,
             &ldu, (MKL_Complex8*)pData->VH, &ldvt, (MKL_Complex8*)work, &lwork, rwork, &info);
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_cgesvd_work(LAPACK_COL_MAJOR, 'A', 'A', m, n, (lapack_complex_float*)pData->KxQGKy, lda, pData->S_real, (lapack_complex_float*)pData->U,
+                               ldu, (lapack_complex_float*)pData->VH, ldvt, (lapack_complex_float*)work, lwork, rwork);
 #endif
     free((void*)work);
     free((void*)rwork);
+    svdFailed = svdFailed || info!=0;
     cblas_cgemm(CblasColMajor, CblasConjTrans, CblasNoTrans, qsize1, qsize2, qsize1, &calpha,
                 pData->VH, qsize1, /* remember lapack returned V^H not V! */
                 pData->lambda, qsize1, &cbeta,
@@ -724,6 +777,15 @@ void cdf4sap_formulate_M_and_Cr_cmplx
     }  
     
     /* output */
+    if (svdFailed) {
+        /* a decomposition did not converge: no mixing, and so the residual is all of Cy */
+        for (i = 0; i<qsize1; i++) {
+            memset(M[i], 0, qsize2 * sizeof(float_complex));
+            for (j = 0; j<qsize1; j++)
+                Cr[i][j] = cmplxf(crealf(Cy[i][j]), 0.0f);
+        }
+        return;
+    }
     for (i = 0; i<qsize1; i++)
         for (j = 0; j<qsize2; j++)
             M[i][j] = pData->M_CM[j*qsize1 + i]; /* transpose - back to row major */
@@ -80,7 +80,7 @@ static void afAnalyse
     nTimeSlots = nSamplesTD/hopSize;
     
     /* allocate memory */
-    afSTFTinit(&(hSTFT), hopSize, nCH, 1, 0, 1);
+    afSTFTinit_analysis(&(hSTFT), hopSize, nCH, 0, 1);
     FrameTF = (complexVector**)malloc2d(nTimeSlots, nCH, sizeof(complexVector));
     for(t=0; t<nTimeSlots; t++) {
         for(ch=0; ch< nCH; ch++) {
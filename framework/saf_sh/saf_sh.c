@@ -28,10 +28,16 @@
 
 #include "saf_sh.h"
 #include "saf_sh_internal.h"
+#if defined(_WIN32)
+  #include <windows.h>
+#else
+  #include <pthread.h>
+  #include <unistd.h>
+#endif
 
 static double Jn(int n, double z)
 {
-#ifdef __APPLE__
+#ifndef _WIN32
     return jn(n,z);
 #else
     return _jn(n,z);
@@ -40,7 +46,7 @@ static double Jn(int n, double z)
 
 static double Yn(int n, double z)
 {
-#ifdef __APPLE__
+#ifndef _WIN32
     return yn(n,z);
 #else
     return _yn(n,z);
@@ -135,51 +141,6 @@ e20:    *NM=K-1;
         DK[K]=-SK[K-1]-(K+1.0)/X*SK[K];
 }
 
-/* Original Fortran code: "Fortran Routines for Computation of Special Functions":
- * jin.ece.uiuc.edu/routines/routines.html.
- * C implementation by J-P Moreau, Paris (www.jpmoreau.fr) */
-static void SPHJ(int N, double X, int *NM, double *SJ, double *DJ)
-{
-    int K, M;
-    double CS, F, F0, F1, SA, SB;
-    
-    *NM=N;
-    if (fabs(X) < 1e-100) {
-        for (K=0; K<=N; K++) {
-            SJ[K]=0.0;
-            DJ[K]=0.0;
-        }
-        SJ[0]=1.0;
-        DJ[1]=0.333333333333333;
-        return;
-    }
-    SJ[0]=sin(X)/X;
-    SJ[1]=(SJ[0]-cos(X))/X;
-    if (N >= 2) {
-        SA=SJ[0];
-        SB=SJ[1];
-        M=MSTA1(X,200);
-        if (M < N)
-            *NM=M;
-        else
-            M=MSTA2(X,N,15);
-        F0=0.0;
-        F1=1.0-100;
-        for (K=M; K>-1; K--) {
-            F=(2.0*K+3.0)*F1/X-F0;
-            if (K <= *NM)  SJ[K]=F;
-            F0=F1;
-            F1=F;
-        }
-        if (fabs(SA) > fabs(SB))  CS=SA/F;
-        if (fabs(SA) <= fabs(SB)) CS=SB/F0;
-        for (K=0; K<=*NM; K++)  SJ[K] *= CS;
-    }
-    DJ[0]=(cos(X)-sin(X)/X)/X;
-    for (K=1; K<=*NM; K++)
-        DJ[K]=SJ[K-1]-(K+1.0)*SJ[K]/X;
-}
-
 /* Original Fortran code: "Fortran Routines for Computation of Special Functions":
  * jin.ece.uiuc.edu/routines/routines.html.
  * C implementation by J-P Moreau, Paris (www.jpmoreau.fr) */
@@ -246,59 +207,176 @@ static double ENVJ(int N, double X) {
     return (0.5*log(6.28*N)-N*log(1.36*X/N));
 }
 
-/* Original Fortran code: "Fortran Routines for Computation of Special Functions":
- * jin.ece.uiuc.edu/routines/routines.html.
- * C implementation by J-P Moreau, Paris (www.jpmoreau.fr) */
-static void SPHY(int N, double X, int *NM, double *SY, double *DY)
+/* Spherical Bessel functions of the first and second kind, and their derivatives, for orders 0..N and all values in z.
+ * The recursions are those of SPHJ/SPHY in "Fortran Routines for Computation of Special Functions":
+ * jin.ece.uiuc.edu/routines/routines.html. However, here they are carried out one order at a time over the whole
+ * vector of arguments, (rather than one argument at a time over all orders), so that the inner loops are contiguous
+ * and can be vectorised. j_n uses Miller's downward recurrence, started from the MSTA1/MSTA2 order of each argument;
+ * y_n uses the upward recurrence. Either pair of outputs may be NULL. NM_j/NM_y return the highest order that could be
+ * computed for each argument, and values above this order are zeroed. Outputs are FLAT: (N+1) x nZ */
+static void sphBesselJY_vec
+(
+    int N,
+    double* z,
+    int nZ,
+    int* NM_j,
+    double* j_n,
+    double* dj_n,
+    int* NM_y,
+    double* y_n,
+    double* dy_n
+)
 {
-    int K;
-    double F, F0, F1;
-    
-    *NM=N;
-    if (X < 1e-60) {
-        for (K=0; K<=N; K++) {
-            SY[K]=-1.0e+300;
-            DY[K]=1e+300;
+    int i, k, M, maxM;
+    int* Mstart;
+    double cs, sa, sb, f;
+    double* invz, *f0, *f1;
+    
+    /* arguments close to zero are given their limiting values at the end */
+    invz = malloc(nZ*sizeof(double));
+    for(i=0; i<nZ; i++)
+        invz[i] = z[i] <= 1e-15 ? 1.0 : 1.0/z[i];
+    
+    if(j_n!=NULL){
+        if(N<2){
+            for(i=0; i<nZ; i++){
+                NM_j[i] = N;
+                j_n[i] = sin(z[i])*invz[i];
+                if(N>0)
+                    j_n[nZ+i] = (j_n[i]-cos(z[i]))*invz[i];
+            }
+        }
+        else{
+            /* starting order of the downward recurrence, per argument */
+            Mstart = malloc(nZ*sizeof(int));
+            f0 = malloc(nZ*sizeof(double));
+            f1 = malloc(nZ*sizeof(double));
+            maxM = 0;
+            for(i=0; i<nZ; i++){
+                NM_j[i] = N;
+                if(z[i] <= 1e-15)
+                    M = -1;
+                else{
+                    M = MSTA1(z[i],200);
+                    if (M < N)
+                        NM_j[i] = M;
+                    else
+                        M = MSTA2(z[i],N,15);
+                }
+                Mstart[i] = M;
+                maxM = MAX(maxM, M);
+                f0[i] = 0.0;
+                f1[i] = 1.0e-100;
+            }
+            
+            /* arguments only join the recurrence once their starting order has been reached */
+            for(k=maxM; k>-1; k--){
+                for(i=0; i<nZ; i++){
+                    if(k<=Mstart[i]){
+                        f = (2.0*k+3.0)*f1[i]*invz[i]-f0[i];
+                        f0[i] = f1[i];
+                        f1[i] = f;
+                    }
+                }
+                if(k<=N)
+                    memcpy(&j_n[k*nZ], f1, nZ*sizeof(double));
+            }
+            
+            /* normalise by whichever of j_0 and j_1 is larger */
+            for(i=0; i<nZ; i++){
+                sa = sin(z[i])*invz[i];
+                sb = (sa-cos(z[i]))*invz[i];
+                cs = fabs(sa) > fabs(sb) ? sa/j_n[i] : sb/j_n[nZ+i];
+                for(k=0; k<=NM_j[i]; k++)
+                    j_n[k*nZ+i] *= cs;
+                for(; k<=N; k++)
+                    j_n[k*nZ+i] = 0.0;
+            }
+            free(Mstart);
+            free(f0);
+            free(f1);
+        }
+        if(dj_n!=NULL){
+            for(i=0; i<nZ; i++)
+                dj_n[i] = (cos(z[i])-sin(z[i])*invz[i])*invz[i];
+            for(k=1; k<=N; k++)
+                for(i=0; i<nZ; i++)
+                    dj_n[k*nZ+i] = j_n[(k-1)*nZ+i]-(k+1.0)*j_n[k*nZ+i]*invz[i];
+        }
+        for(i=0; i<nZ; i++){
+            if(z[i] <= 1e-15){
+                NM_j[i] = N;
+                for(k=0; k<=N; k++){
+                    j_n[k*nZ+i] = k==0 ? 1.0 : 0.0;
+                    if(dj_n!=NULL)
+                        dj_n[k*nZ+i] = k==1 ? 1.0/3.0 : 0.0;
+                }
+            }
         }
-        return;
     }
-    SY[0]=-cos(X)/X;
-    SY[1]=(SY[0]-sin(X))/X;
-    F0=SY[0];
-    F1=SY[1];
-    for (K=2; K<=N; K++) {
-        F=(2.0*K-1.0)*F1/X-F0;
-        SY[K]=F;
-        if (fabs(F) >= 1e+300) goto e20;
-        F0=F1;
-        F1=F;
+    
+    if(y_n!=NULL){
+        for(i=0; i<nZ; i++){
+            NM_y[i] = N;
+            y_n[i] = -cos(z[i])*invz[i];
+            if(N>0)
+                y_n[nZ+i] = (y_n[i]-sin(z[i]))*invz[i];
+        }
+        
+        /* orders from the first overflow onwards are discarded */
+        for(k=2; k<=N; k++){
+            for(i=0; i<nZ; i++){
+                y_n[k*nZ+i] = (2.0*k-1.0)*y_n[(k-1)*nZ+i]*invz[i] - y_n[(k-2)*nZ+i];
+                if(fabs(y_n[k*nZ+i]) >= 1e+300)
+                    NM_y[i] = MIN(NM_y[i], k-1);
+            }
+        }
+        for(i=0; i<nZ; i++){
+            if(z[i] <= 1e-15)
+                NM_y[i] = -1;
+            for(k=NM_y[i]+1; k<=N; k++)
+                y_n[k*nZ+i] = 0.0;
+        }
+        if(dy_n!=NULL){
+            for(i=0; i<nZ; i++)
+                dy_n[i] = (sin(z[i])+cos(z[i])*invz[i])*invz[i];
+            for(k=1; k<=N; k++)
+                for(i=0; i<nZ; i++)
+                    dy_n[k*nZ+i] = y_n[(k-1)*nZ+i]-(k+1.0)*y_n[k*nZ+i]*invz[i];
+            for(i=0; i<nZ; i++)
+                for(k=NM_y[i]+1; k<=N; k++)
+                    dy_n[k*nZ+i] = 0.0;
+        }
+        for(i=0; i<nZ; i++)
+            if(z[i] <= 1e-15)
+                NM_y[i] = N;
     }
-e20:    *NM=K-1;
-    DY[0]=(sin(X)+cos(X)/X)/X;
-    for (K=1; K<=*NM; K++)
-        DY[K]=SY[K-1]-(K+1.0)*SY[K]/X;
+    
+    free(invz);
 }
 
 
 /* Used in the calculation of spherical harmonic rotation matrices
  * Ivanic, J., Ruedenberg, K. (1998). Rotation Matrices for Real Spherical Harmonics. Direct Determination
  * by Recursion Page: Additions and Corrections. Journal of Physical Chemistry A, 102(45), 9099?9100. */
-static float getP(int i, int l, int a, int b, float** R_1, float** R_lm1)
+static float getP(int i, int l, int a, int b, float* R_1, float* R_lm1)
 {
     float ret, ri1, rim1, ri0;
-    //ret = 0.0f;
+    int w;
 
-    ri1 = R_1[i + 1][1 + 1];
-    rim1 = R_1[i + 1][-1 + 1];
-    ri0 = R_1[i + 1][0 + 1];
+    /* R_1 is 3 x 3, and R_lm1 is (2l-1) x (2l-1); both FLAT */
+    w = 2*l-1;
+    ri1 = R_1[(i + 1)*3 + 1 + 1];
+    rim1 = R_1[(i + 1)*3 - 1 + 1];
+    ri0 = R_1[(i + 1)*3 + 0 + 1];
 
     if (b == -l)
-        ret = ri1 * R_lm1[a + l - 1][0] + rim1 * R_lm1[a + l - 1][2 * l - 2];
+        ret = ri1 * R_lm1[(a + l - 1)*w] + rim1 * R_lm1[(a + l - 1)*w + 2 * l - 2];
     else {
         if (b == l)
-            ret = ri1*R_lm1[a + l - 1][2 * l - 2] - rim1 * R_lm1[a + l - 1][0];
+            ret = ri1*R_lm1[(a + l - 1)*w + 2 * l - 2] - rim1 * R_lm1[(a + l - 1)*w];
         else
-            ret = ri0 * R_lm1[a + l - 1][b + l - 1];
+            ret = ri0 * R_lm1[(a + l - 1)*w + b + l - 1];
     }
 
     return ret;
@@ -307,7 +385,7 @@ static float getP(int i, int l, int a, int b, float** R_1, float** R_lm1)
 /* Used in the calculation of spherical harmonic rotation matrices
  * Ivanic, J., Ruedenberg, K. (1998). Rotation Matrices for Real Spherical Harmonics. Direct Determination
  * by Recursion Page: Additions and Corrections. Journal of Physical Chemistry A, 102(45), 9099?9100. */
-static float getU(int l, int m, int n, float** R_1, float** R_lm1)
+static float getU(int l, int m, int n, float* R_1, float* R_lm1)
 {
     return getP(0, l, m, n, R_1, R_lm1);
 }
@@ -315,7 +393,7 @@ static float getU(int l, int m, int n, float** R_1, float** R_lm1)
 /* Used in the calculation of spherical harmonic rotation matrices
  * Ivanic, J., Ruedenberg, K. (1998). Rotation Matrices for Real Spherical Harmonics. Direct Determination
  * by Recursion Page: Additions and Corrections. Journal of Physical Chemistry A, 102(45), 9099?9100. */
-static float getV(int l, int m, int n, float** R_1, float** R_lm1)
+static float getV(int l, int m, int n, float* R_1, float* R_lm1)
 {
     int d;
     float ret, p0, p1;
@@ -347,7 +425,7 @@ static float getV(int l, int m, int n, float** R_1, float** R_lm1)
 /* Used in the calculation of spherical harmonic rotation matrices
  * Ivanic, J., Ruedenberg, K. (1998). Rotation Matrices for Real Spherical Harmonics. Direct Determination
  * by Recursion Page: Additions and Corrections. Journal of Physical Chemistry A, 102(45), 9099?9100. */
-static float getW(int l, int m, int n, float** R_1, float** R_lm1)
+static float getW(int l, int m, int n, float* R_1, float* R_lm1)
 {
     float ret, p0, p1;
     ret = 0.0f;
@@ -486,6 +564,96 @@ void unnorm_legendreP(int n, double* x, int lenX, double* y)
     free(sqrt_n);
 }
 
+/* Number of directions processed at a time by getSHreal_block() */
+#define SH_RECUR_BLOCK_SIZE ( 64 )
+
+/* Evaluates the real spherical harmonics up to order N for (up to SH_RECUR_BLOCK_SIZE) directions, using the
+ * recursion of the fully normalised associated Legendre functions over the degree, and the angle-sum recursion of
+ * the azimuthal functions over the order. "dirs" is [azi, inclination] in radians, or [azi, elevation] in degrees if
+ * "dirsInDegrees" is 1; FLAT: nDirs x 2. "Y00" is the value of the zeroth-order component, which all other
+ * components are scaled with. The SH weights are written to Y[((n*n+n+m)*ldY + i)*incY]. No memory is allocated */
+static void getSHreal_block
+(
+    int N,
+    float* dirs,
+    int dirsInDegrees,
+    int nDirs,
+    double Y00,
+    float* Y,
+    int ldY,
+    int incY
+)
+{
+    int i, n, m;
+    double a, b, azi, incl, tmp, sqrt2;
+    double x[SH_RECUR_BLOCK_SIZE], s[SH_RECUR_BLOCK_SIZE], cos1[SH_RECUR_BLOCK_SIZE], sin1[SH_RECUR_BLOCK_SIZE];
+    double cosm[SH_RECUR_BLOCK_SIZE], sinm[SH_RECUR_BLOCK_SIZE], pmm[SH_RECUR_BLOCK_SIZE];
+    double p[SH_RECUR_BLOCK_SIZE], p1[SH_RECUR_BLOCK_SIZE], p2[SH_RECUR_BLOCK_SIZE];
+    
+    assert(nDirs<=SH_RECUR_BLOCK_SIZE);
+    sqrt2 = sqrt(2.0);
+    for(i=0; i<nDirs; i++){
+        if(dirsInDegrees){
+            azi = (double)dirs[i*2]*M_PI/180.0;
+            incl = M_PI/2.0 - (double)dirs[i*2+1]*M_PI/180.0;
+        }
+        else{
+            azi = (double)dirs[i*2];
+            incl = (double)dirs[i*2+1];
+        }
+        x[i] = cos(incl);
+        s[i] = fabs(sin(incl));
+        cos1[i] = cos(azi);
+        sin1[i] = sin(azi);
+        cosm[i] = 1.0;
+        sinm[i] = 0.0;
+        pmm[i] = Y00;
+    }
+    for(m=0; m<=N; m++){
+        if(m>0){
+            /* P_m^m from P_(m-1)^(m-1), and cos(m*azi), sin(m*azi) from those of (m-1)*azi */
+            a = sqrt((2.0*(double)m+1.0)/(2.0*(double)m));
+            for(i=0; i<nDirs; i++){
+                pmm[i] *= a*s[i];
+                tmp = cosm[i]*cos1[i] - sinm[i]*sin1[i];
+                sinm[i] = sinm[i]*cos1[i] + cosm[i]*sin1[i];
+                cosm[i] = tmp;
+            }
+        }
+        for(n=m; n<=N; n++){
+            /* P_n^m from P_(n-1)^m and P_(n-2)^m */
+            if(n==m){
+                for(i=0; i<nDirs; i++){
+                    p[i] = pmm[i];
+                    p2[i] = 0.0;
+                }
+            }
+            else{
+                a = sqrt((4.0*(double)(n*n)-1.0)/(double)(n*n-m*m));
+                b = n-1>m ? sqrt((double)((n-1)*(n-1)-m*m)/(4.0*(double)((n-1)*(n-1))-1.0)) : 0.0;
+                for(i=0; i<nDirs; i++){
+                    p[i] = a*(x[i]*p1[i] - b*p2[i]);
+                    p2[i] = p1[i];
+                }
+            }
+            for(i=0; i<nDirs; i++)
+                p1[i] = p[i];
+            
+            /* Y_n^m = sqrt(2)*P_n^|m|*cos(m*azi) for m>0, sqrt(2)*P_n^|m|*sin(|m|*azi) for m<0, and P_n^0 for m=0 */
+            if(m==0){
+                for(i=0; i<nDirs; i++)
+                    Y[((n*n+n)*ldY+i)*incY] = (float)p[i];
+            }
+            else{
+                for(i=0; i<nDirs; i++){
+                    Y[((n*n+n+m)*ldY+i)*incY] = (float)(sqrt2*p[i]*cosm[i]);
+                    Y[((n*n+n-m)*ldY+i)*incY] = (float)(sqrt2*p[i]*sinm[i]);
+                }
+            }
+        }
+    }
+}
+
 void getRSH
 (
     int N,
@@ -494,89 +662,222 @@ void getRSH
     float** Y
 )
 {
-    int i, j, nSH;
-    float scale;
-    float* Y_dir;
+    int i, nSH;
     
-    scale = sqrtf(4.0f*M_PI);
     nSH = (N+1)*(N+1);
 	if((*Y)!=NULL)
 		free(*Y);
     (*Y) = malloc(nSH*nDirs*sizeof(float));
-    Y_dir = malloc(nSH*sizeof(float));
-    for(i=0; i<nDirs; i++){
-        /* compute spherical harmonics for each direction */
-        getSHreal(N, dirs_deg[i*2]*M_PI/180.0f, M_PI/2.0f- dirs_deg[i*2+1]*M_PI/180.0f, Y_dir);
-        for( j=0; j<nSH; j++)
-            (*Y)[j*nDirs + i] = Y_dir[j]*scale;
+    
+    /* compute spherical harmonics for blocks of directions (without the 1/sqrt(4*pi) scaling) */
+    for(i=0; i<nDirs; i+=SH_RECUR_BLOCK_SIZE)
+        getSHreal_block(N, &dirs_deg[i*2], 1, MIN(SH_RECUR_BLOCK_SIZE, nDirs-i), 1.0, &((*Y)[i]), nDirs, 1);
+}
+
+/* A job that is run by one thread of runJobsInParallel() */
+typedef struct _parallelJob {
+    void (*run)(void*);
+    void* arg;
+} parallelJob;
+
+#if defined(_WIN32)
+static DWORD WINAPI parallelJob_thread(LPVOID arg)
+{
+    ((parallelJob*)arg)->run(((parallelJob*)arg)->arg);
+    return 0;
+}
+#else
+static void* parallelJob_thread(void* arg)
+{
+    ((parallelJob*)arg)->run(((parallelJob*)arg)->arg);
+    return NULL;
+}
+#endif
+
+/* returns the number of threads to use for "nThreads" (0: one per processor), and for "nBlocks" blocks of work */
+static int getNumThreads(int nThreads, int nBlocks)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO sysInfo;
+#endif
+    
+    if(nThreads<=0){
+#if defined(_WIN32)
+        GetSystemInfo(&sysInfo);
+        nThreads = (int)sysInfo.dwNumberOfProcessors;
+#else
+        nThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
     }
-    free(Y_dir);
+    return MAX(MIN(nThreads, nBlocks), 1);
 }
 
-void getSHreal
-(
-    int N,
-    float azi,
-    float incl,
-    float* Y
+/* runs run(&args[t*argSize]) for t=0..nJobs-1, each on its own thread. The first job is run by the calling thread, as
+ * are any jobs for which a thread could not be started */
+static void runJobsInParallel
+(
+    void (*run)(void*),
+    void* args,
+    size_t argSize,
+    int nJobs
 )
 {
-    int i, j, n, m, idx_Y;
-    float *p_mm, *Lnm_real, *condon, *norm_real, *Nnm_real, *CosSin, *Ynm;
-    //Nharm = (N+1)*(N+1);
+    int t;
+    parallelJob* jobs;
+#if defined(_WIN32)
+    HANDLE* threads;
+#else
+    pthread_t* threads;
+    int* started;
+#endif
+    
+    if(nJobs<=1){
+        if(nJobs==1)
+            run(args);
+        return;
+    }
+    jobs = malloc(nJobs*sizeof(parallelJob));
+    for(t=0; t<nJobs; t++){
+        jobs[t].run = run;
+        jobs[t].arg = (void*)((char*)args + t*argSize);
+    }
+#if defined(_WIN32)
+    threads = malloc(nJobs*sizeof(HANDLE));
+    for(t=1; t<nJobs; t++){
+        threads[t] = CreateThread(NULL, 0, parallelJob_thread, (LPVOID)&jobs[t], 0, NULL);
+        if(threads[t]==NULL)
+            run(jobs[t].arg);
+    }
+    run(jobs[0].arg);
+    for(t=1; t<nJobs; t++){
+        if(threads[t]!=NULL){
+            WaitForSingleObject(threads[t], INFINITE);
+            CloseHandle(threads[t]);
+        }
+    }
+#else
+    threads = malloc(nJobs*sizeof(pthread_t));
+    started = malloc(nJobs*sizeof(int));
+    for(t=1; t<nJobs; t++){
+        started[t] = pthread_create(&threads[t], NULL, parallelJob_thread, (void*)&jobs[t]) == 0;
+        if(!started[t])
+            run(jobs[t].arg);
+    }
+    run(jobs[0].arg);
+    for(t=1; t<nJobs; t++)
+        if(started[t])
+            pthread_join(threads[t], NULL);
+    free(started);
+#endif
+    free(threads);
+    free(jobs);
+}
 
-    p_mm = (float*)malloc((N+1) * sizeof(float));
-    norm_real = (float*)malloc((N+1) * sizeof(float));
-    CosSin = (float*)malloc((N*2+1) * sizeof(float));
-    Ynm = (float*)malloc((N*2+1) * sizeof(float));
-    Nnm_real = (float*)malloc((N*2+1) * sizeof(float));
-    Lnm_real = (float*)malloc((N*2+1) * sizeof(float));
-    condon = (float*)malloc((N*2+1) * sizeof(float));
+/* A contiguous range of directions [dirStart, dirEnd) of a getRSH_batch() call, evaluated by one thread */
+typedef struct _getRSH_batch_job {
+    int N;
+    float* dirs_deg;
+    int nDirs;
+    int dirStart;
+    int dirEnd;
+    double scale;
+    float* Y;
+    float_complex* Y_cmplx;
+} getRSH_batch_job;
 
-    idx_Y = 0;
-    for(n=0; n<=N; n++){
-        legendreP(n, cosf(incl), p_mm);
-        if (n != 0){
-            for(i=-n, j=0; i<=n; i++, j++){
-                condon[j] = powf(-1.0f, fabsf((float)i));
-                Lnm_real[j] = condon[j] * p_mm[abs(i)];
-            }
-        }
-        else
-            Lnm_real[0] = p_mm[0];
-        for(m=0; m <= n; m++)
-            norm_real[m] = sqrtf( (2.0f*(float)n+1.0f)* (float)factorial(n-m) / (4.0f*M_PI*(float)factorial(n+m)) );
-        if (n != 0){
-            for(i=-n, j=0; i<=n; i++, j++){
-                Nnm_real[j] = norm_real[abs(i)];
+static void getRSH_batch_run(void* arg)
+{
+    int i, j, k, nSH, nDirs_block;
+    float* Y_cmplx_f;
+    getRSH_batch_job* job = (getRSH_batch_job*)arg;
+    
+    nSH = (job->N+1)*(job->N+1);
+    for(i=job->dirStart; i<job->dirEnd; i+=SH_RECUR_BLOCK_SIZE){
+        nDirs_block = MIN(SH_RECUR_BLOCK_SIZE, job->dirEnd-i);
+        if(job->Y!=NULL)
+            getSHreal_block(job->N, &(job->dirs_deg[i*2]), 1, nDirs_block, job->scale, &(job->Y[i]), job->nDirs, 1);
+        if(job->Y_cmplx!=NULL){
+            if(job->Y!=NULL){
+                for(j=0; j<nSH; j++)
+                    for(k=i; k<i+nDirs_block; k++)
+                        job->Y_cmplx[j*(job->nDirs)+k] = cmplxf(job->Y[j*(job->nDirs)+k], 0.0f);
             }
-        }
-        else
-            Nnm_real[0] = norm_real[0];
-        memset(CosSin, 0, (2*n+1)*sizeof(float));
-        CosSin[n] = 1.0f;
-        if (n != 0){
-            for(j=0; j<2*n+1; j++){
-                if (j>n)
-                    CosSin[j] = sqrtf(2.0f)*cosf((float)(j-n)*azi);
-                else if (j<n)
-                    CosSin[j] = sqrtf(2.0f)*sinf((float)(n-j)*azi);
+            else{
+                /* write the real parts directly, and then clear the imaginary parts */
+                Y_cmplx_f = (float*)&(job->Y_cmplx[i]);
+                getSHreal_block(job->N, &(job->dirs_deg[i*2]), 1, nDirs_block, job->scale, Y_cmplx_f, job->nDirs, 2);
+                for(j=0; j<nSH; j++)
+                    for(k=0; k<nDirs_block; k++)
+                        Y_cmplx_f[(j*(job->nDirs)+k)*2+1] = 0.0f;
             }
         }
-        for(j=0; j<2*n+1; j++){
-            Ynm[j] = Nnm_real[j] * Lnm_real[j] * CosSin[j];
-            Y[idx_Y+j] = Ynm[j];
-        }
-        idx_Y = idx_Y + (2*n+1);
     }
+}
+
+void getRSH_batch
+(
+    int N,
+    float* dirs_deg,
+    int nDirs,
+    float scale,
+    int nThreads,
+    float* Y,
+    float_complex* Y_cmplx
+)
+{
+    int t, nBlocks, nBlocksPerThread;
+    getRSH_batch_job* jobs;
+    
+    if(nDirs<=0)
+        return;
+    
+    /* split the directions into contiguous ranges of whole blocks, one per thread */
+    nBlocks = (nDirs + SH_RECUR_BLOCK_SIZE - 1)/SH_RECUR_BLOCK_SIZE;
+    nThreads = getNumThreads(nThreads, nBlocks);
+    nBlocksPerThread = (nBlocks + nThreads - 1)/nThreads;
+    nThreads = (nBlocks + nBlocksPerThread - 1)/nBlocksPerThread;
+    jobs = malloc(nThreads*sizeof(getRSH_batch_job));
+    for(t=0; t<nThreads; t++){
+        jobs[t].N = N;
+        jobs[t].dirs_deg = dirs_deg;
+        jobs[t].nDirs = nDirs;
+        jobs[t].dirStart = t*nBlocksPerThread*SH_RECUR_BLOCK_SIZE;
+        jobs[t].dirEnd = MIN((t+1)*nBlocksPerThread*SH_RECUR_BLOCK_SIZE, nDirs);
+        jobs[t].scale = (double)scale;
+        jobs[t].Y = Y;
+        jobs[t].Y_cmplx = Y_cmplx;
+    }
+    runJobsInParallel(getRSH_batch_run, (void*)jobs, sizeof(getRSH_batch_job), nThreads);
+    free(jobs);
+}
 
-    free(p_mm);
-    free(norm_real);
-    free(CosSin);
-    free(Ynm);
-    free(Nnm_real);
-    free(Lnm_real);
-    free(condon);
+void getSHreal
+(
+    int N,
+    float azi,
+    float incl,
+    float* Y
+)
+{
+    float dir[2];
+    
+    dir[0] = azi;
+    dir[1] = incl;
+    getSHreal_block(N, dir, 0, 1, 1.0/sqrt(4.0*M_PI), Y, 1, 1);
+}
+
+void getSHreal_recur
+(
+    int N,
+    float* dirs_rad,
+    int nDirs,
+    float* Y
+)
+{
+    int i;
+    
+    for(i=0; i<nDirs; i+=SH_RECUR_BLOCK_SIZE)
+        getSHreal_block(N, &dirs_rad[i*2], 0, MIN(SH_RECUR_BLOCK_SIZE, nDirs-i), 1.0/sqrt(4.0*M_PI), &Y[i], nDirs, 1);
 }
 
 void yawPitchRoll2Rzyx
@@ -627,40 +928,58 @@ void getSHrotMtxReal
     int L
 )
 {
-    int i, j, M, l, m, n, d, bandIdx, denom;
-    float u, v, w;
-    float** R_1,  **R_lm1, **R_l;
+    int i, j, M, l, blockIdx, bandIdx;
+    float* RotBlocks;
     
     M = (L+1) * (L+1);
-    R_1 = (float**)calloc2d(3, 3, sizeof(float));
-    R_lm1 = (float**)calloc2d(M, M, sizeof(float));
-    R_l = (float**)calloc2d(M, M, sizeof(float));
+    RotBlocks = malloc(SH_ROT_BLOCKS_LENGTH(L)*sizeof(float));
+    getSHrotMtxReal_blocks(Rxyz, RotBlocks, L);
+    
+    /* place the per-order blocks on the diagonal */
     memset(RotMtx, 0, M*M*sizeof(float));
+    blockIdx = 0;
+    for(l = 0; l<=L; l++){
+        bandIdx = l*l;
+        for(i=0; i<2*l+1; i++)
+            for(j=0; j<2*l+1; j++)
+                RotMtx[(bandIdx + i)*M + (bandIdx + j)] = RotBlocks[blockIdx + i*(2*l+1) + j];
+        blockIdx += (2*l+1)*(2*l+1);
+    }
+    free(RotBlocks);
+}
+
+void getSHrotMtxReal_blocks
+(
+    float Rxyz[3][3],
+    float* RotBlocks,
+    int L
+)
+{
+    int l, m, n, d, denom;
+    float u, v, w;
+    float *R_1, *R_lm1, *R_l;
     
     /* zeroth-band (l=0) is invariant to rotation */
-    RotMtx[0] = 1;
+    RotBlocks[0] = 1.0f;
+    if(L<1)
+        return;
     
     /* the first band (l=1) is directly related to the rotation matrix */
-    R_1[-1+1][-1+1] = Rxyz[1][1];
-    R_1[-1+1][0+1] = Rxyz[1][2];
-    R_1[-1+1][1+1] = Rxyz[1][0];
-    R_1[ 0+1][-1+1] = Rxyz[2][1];
-    R_1[ 0+1][0+1] = Rxyz[2][2];
-    R_1[ 0+1][1+1] = Rxyz[2][0];
-    R_1[ 1+1][-1+1] = Rxyz[0][1];
-    R_1[ 1+1][0+1] = Rxyz[0][2];
-    R_1[ 1+1][1+1] = Rxyz[0][0];
-    for (i=1; i<4; i++){
-        memcpy(R_lm1[i-1], R_1[i-1], 3*sizeof(float));
-        for (j=1; j<4; j++)
-            RotMtx[i*M+j] = R_1[i-1][j-1];
-    }
+    R_1 = &RotBlocks[1];
+    R_1[(-1+1)*3 -1+1] = Rxyz[1][1];
+    R_1[(-1+1)*3 +0+1] = Rxyz[1][2];
+    R_1[(-1+1)*3 +1+1] = Rxyz[1][0];
+    R_1[( 0+1)*3 -1+1] = Rxyz[2][1];
+    R_1[( 0+1)*3 +0+1] = Rxyz[2][2];
+    R_1[( 0+1)*3 +1+1] = Rxyz[2][0];
+    R_1[( 1+1)*3 -1+1] = Rxyz[0][1];
+    R_1[( 1+1)*3 +0+1] = Rxyz[0][2];
+    R_1[( 1+1)*3 +1+1] = Rxyz[0][0];
     
-    /* compute rotation matrix of each subsequent band recursively */
-    bandIdx = 4;
+    /* compute rotation matrix of each subsequent band recursively, directly from the previous block */
+    R_lm1 = R_1;
     for(l = 2; l<=L; l++){
-        for(i=0; i<2*l+1; i++)
-            memset(R_l[i], 0, (2*l+1) * sizeof(float));
+        R_l = R_lm1 + (2*l-1)*(2*l-1);
         for(m=-l; m<=l; m++){
             for(n=-l; n<=l; n++){
                 /* compute u,v,w terms of Eq.8.1 (Table I) */
@@ -678,22 +997,125 @@ void getSHrotMtxReal
                 if (w!=0)
                     w = w* getW(l,m,n,R_1,R_lm1);
                 
-                R_l[m+l][n+l] = u+v+w;
+                R_l[(m+l)*(2*l+1) + n+l] = u+v+w;
             }
         }
-        
-        for(i=0; i<2*l+1; i++)
-            for(j=0; j<2*l+1; j++)
-				RotMtx[(bandIdx + i)*M + (bandIdx + j)] = R_l[i][j];
-                //RotMtx[(bandIdx+i)*(2*l+1) +(bandIdx+j)] = R_l[i][j];
-        for(i=0; i<2*l+1; i++)
-            memcpy(R_lm1[i], R_l[i], (2*l+1) * sizeof(float));
-        bandIdx += 2*l+1;
+        R_lm1 = R_l;
+    }
+}
+
+void applySHrotMtxReal_blocks
+(
+    float* RotBlocks,
+    int L,
+    float* inSig,
+    int nSamples,
+    float* outSig
+)
+{
+    int l, blockIdx;
+    
+    /* zeroth-band (l=0) is invariant to rotation */
+    memcpy(outSig, inSig, nSamples*sizeof(float));
+    blockIdx = 1;
+    for(l = 1; l<=L; l++){
+        cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, 2*l+1, nSamples, 2*l+1, 1.0f,
+                    &RotBlocks[blockIdx], 2*l+1,
+                    &inSig[l*l*nSamples], nSamples, 0.0f,
+                    &outSig[l*l*nSamples], nSamples);
+        blockIdx += (2*l+1)*(2*l+1);
+    }
+}
+
+void applySHrotMtxReal_blocks_xfade
+(
+    float* RotBlocks_prev,
+    float* RotBlocks,
+    int L,
+    float* inSig,
+    int nSamples,
+    float* outSig
+)
+{
+    int i, j, l, t, Ml, blockIdx;
+    float a, d, invN;
+    float *pIn, *pOut;
+    
+    /* zeroth-band (l=0) is invariant to rotation */
+    memcpy(outSig, inSig, nSamples*sizeof(float));
+    invN = 1.0f/(float)nSamples;
+    blockIdx = 1;
+    for(l = 1; l<=L; l++){
+        Ml = 2*l+1;
+        for(i=0; i<Ml; i++){
+            pOut = &outSig[(l*l+i)*nSamples];
+            memset(pOut, 0, nSamples*sizeof(float));
+            for(j=0; j<Ml; j++){
+                /* the matrix at sample t is: prev + (t+1)/nSamples * (new - prev), so the new matrix is reached at
+                 * the last sample */
+                a = RotBlocks_prev[blockIdx + i*Ml + j];
+                d = RotBlocks[blockIdx + i*Ml + j] - a;
+                pIn = &inSig[(l*l+j)*nSamples];
+                for(t=0; t<nSamples; t++)
+                    pOut[t] += (a + d*(float)(t+1)*invN) * pIn[t];
+            }
+        }
+        blockIdx += Ml*Ml;
     }
+}
+
+void applySHrotMtxReal_blocks_multi
+(
+    float** RotBlocks,
+    float** RotBlocks_prev,
+    int nListeners,
+    int L,
+    float* inSig,
+    int nSamples,
+    float*** outSig
+)
+{
+    int i, j, k, l, t, Ml, blockIdx;
+    float a, d, invN;
+    float *pIn, *pOut, *pBlock, *pBlock_prev;
     
-    free2d((void**)R_1, 3);
-    free2d((void**)R_lm1, M);
-    free2d((void**)R_l, M);
+    /* zeroth-band (l=0) is invariant to rotation */
+    for(k=0; k<nListeners; k++)
+        if(outSig[k][0]!=NULL)
+            memcpy(outSig[k][0], inSig, nSamples*sizeof(float));
+    invN = 1.0f/(float)nSamples;
+    blockIdx = 1;
+    /* orders in the outer loop and listeners in the inner loop, so that the (2l+1) input signals of each order are
+     * read from memory once, and then stay in cache while the blocks of all listeners are applied to them */
+    for(l = 1; l<=L; l++){
+        Ml = 2*l+1;
+        for(k=0; k<nListeners; k++){
+            pBlock = &RotBlocks[k][blockIdx];
+            pBlock_prev = RotBlocks_prev==NULL || RotBlocks_prev[k]==NULL ? NULL : &RotBlocks_prev[k][blockIdx];
+            for(i=0; i<Ml; i++){
+                pOut = outSig[k][l*l+i];
+                if(pOut==NULL)
+                    continue;
+                memset(pOut, 0, nSamples*sizeof(float));
+                for(j=0; j<Ml; j++){
+                    pIn = &inSig[(l*l+j)*nSamples];
+                    if(pBlock_prev==NULL){
+                        a = pBlock[i*Ml + j];
+                        for(t=0; t<nSamples; t++)
+                            pOut[t] += a * pIn[t];
+                    }
+                    else{
+                        /* same interpolation as in applySHrotMtxReal_blocks_xfade */
+                        a = pBlock_prev[i*Ml + j];
+                        d = pBlock[i*Ml + j] - a;
+                        for(t=0; t<nSamples; t++)
+                            pOut[t] += (a + d*(float)(t+1)*invN) * pIn[t];
+                    }
+                }
+            }
+        }
+        blockIdx += Ml*Ml;
+    }
 }
 
 void calcBFweights
@@ -798,15 +1220,13 @@ void generatePWDmap
     float* pmap
 )
 {
-    int i, j, nSH;
-    float_complex* Cx_Y, *Y_Cx_Y, *Cx_Y_s, *Y_grid_s;
+    int i, nSH;
+    float_complex* Cx_Y;
+    float_complex Y_Cx_Y;
     const float_complex calpha = cmplxf(1.0f, 0.0f), cbeta = cmplxf(0.0f, 0.0f);
     
     nSH = (order+1)*(order+1);
     Cx_Y = malloc(nSH * nGrid_dirs * sizeof(float_complex));
-    Y_Cx_Y = malloc(nGrid_dirs*sizeof(float_complex));
-    Cx_Y_s = malloc(nSH*sizeof(float_complex));
-    Y_grid_s = malloc(nSH*sizeof(float_complex));
     
     /* Calculate PWD powermap: real(diag(Y_grid.'*C_x*Y_grid)) */
     cblas_cgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, nSH, nGrid_dirs, nSH, &calpha,
@@ -814,83 +1234,196 @@ void generatePWDmap
                 Y_grid, nGrid_dirs, &cbeta,
                 Cx_Y, nGrid_dirs);
     for(i=0; i<nGrid_dirs; i++){
-        for(j=0; j<nSH; j++){
-            Cx_Y_s[j] = Cx_Y[j*nGrid_dirs+i];
-            Y_grid_s[j] = Y_grid[j*nGrid_dirs+i];
-        }
-        /* faster to perform the dot-product for each vector seperately */
-        utility_cvvdot(Y_grid_s, Cx_Y_s, nSH, NO_CONJ, &Y_Cx_Y[i]);
+        /* strided dot-product, so that the columns need not be copied first */
+        cblas_cdotu_sub(nSH, &Y_grid[i], nGrid_dirs, &Cx_Y[i], nGrid_dirs, &Y_Cx_Y);
+        pmap[i] = crealf(Y_Cx_Y);
     }
     
-    for(i=0; i<nGrid_dirs; i++)
-        pmap[i] = crealf(Y_Cx_Y[i]);
-    
     free(Cx_Y);
-    free(Y_Cx_Y);
-    free(Cx_Y_s);
-    free(Y_grid_s);
 }
 
-void generateMVDRmap
+void generatePWDmapReal
 (
     int order,
     float_complex* Cx,
-    float_complex* Y_grid,
+    float* Y_grid,
     int nGrid_dirs,
-    float regPar,
-    float* pmap,
-    float_complex* w_MVDR_out
+    float* pmap
 )
 {
     int i, j, nSH;
-    float Cx_trace;
-    float_complex *Cx_d, *invCx_Ygrid, *w_MVDR, *invCx_Ygrid_s, *Y_grid_s;
-    float_complex denum;
+    float* Cx_re, *Cx_Y;
     
     nSH = (order+1)*(order+1);
-    w_MVDR = malloc(nSH * nGrid_dirs*sizeof(float_complex));
-    Cx_d = malloc(nSH*nSH*sizeof(float_complex));
-    invCx_Ygrid = malloc(nSH*nGrid_dirs*sizeof(float_complex));
-    invCx_Ygrid_s = malloc(nSH*sizeof(float_complex));
-    Y_grid_s = malloc(nSH*sizeof(float_complex));
+    Cx_re = malloc(nSH*nSH*sizeof(float));
+    Cx_Y = malloc(nSH*nGrid_dirs*sizeof(float));
+    
+    /* Calculate PWD powermap: real(diag(Y_grid.'*C_x*Y_grid)) = diag(Y_grid.'*real(C_x)*Y_grid), for real Y_grid */
+    for(i=0; i<nSH*nSH; i++)
+        Cx_re[i] = crealf(Cx[i]);
+    cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, nSH, nGrid_dirs, nSH, 1.0f,
+                Cx_re, nSH,
+                Y_grid, nGrid_dirs, 0.0f,
+                Cx_Y, nGrid_dirs);
+    memset(pmap, 0, nGrid_dirs*sizeof(float));
+    for(j=0; j<nSH; j++)
+        for(i=0; i<nGrid_dirs; i++)
+            pmap[i] += Y_grid[j*nGrid_dirs+i] * Cx_Y[j*nGrid_dirs+i];
+    
+    free(Cx_re);
+    free(Cx_Y);
+}
+
+/* applies diagonal loading to the covariance matrix, and returns its Cholesky factor and the loading */
+static float getLoadedCovCholFactor
+(
+    float_complex* Cx,
+    int nSH,
+    float regPar,
+    float_complex* U
+)
+{
+    int i;
+    float Cx_trace;
     
-    /* apply diagonal loading */
     Cx_trace = 0.0f;
     for(i=0; i<nSH; i++)
         Cx_trace += crealf(Cx[i*nSH+i]);
     Cx_trace /= (float)nSH;
-    memcpy(Cx_d, Cx, nSH*nSH*sizeof(float_complex));
+    memcpy(U, Cx, nSH*nSH*sizeof(float_complex));
     for(i=0; i<nSH; i++)
-        Cx_d[i*nSH+i] = craddf(Cx_d[i*nSH+i], regPar*Cx_trace);
+        U[i*nSH+i] = craddf(U[i*nSH+i], regPar*Cx_trace);
+    utility_cchol(U, nSH, U);
+    return regPar*Cx_trace;
+}
+
+/* calculates the MVDR weights for each grid direction: (Cx^-1 * Y) * (Y^T * Cx^-1 * Y)^-1, given Cx^-1 * Y */
+static void getMVDRweights
+(
+    float_complex* Y_grid,
+    float_complex* invCx_Ygrid,
+    int ldInvCx_Ygrid,
+    int nSH,
+    int nGrid_dirs,
+    float_complex* w_MVDR
+)
+{
+    int i, j;
+    float_complex denum;
     
-    /* solve the numerator part of the MVDR weights for all grid directions: Cx^-1 * Y */
-    utility_cslslv(Cx_d, nSH, Y_grid, nGrid_dirs, invCx_Ygrid);
+    for(j=0; j<nSH; j++)
+        memcpy(&w_MVDR[j*nGrid_dirs], &invCx_Ygrid[j*ldInvCx_Ygrid], nGrid_dirs*sizeof(float_complex));
     for(i=0; i<nGrid_dirs; i++){
-        /* solve the denumerator part of the MVDR weights for each grid direction: Y^T * Cx^-1 * Y */
-        for(j=0; j<nSH; j++){
-            invCx_Ygrid_s[j] = conjf(invCx_Ygrid[j*nGrid_dirs+i]);
-            Y_grid_s[j] = Y_grid[j*nGrid_dirs+i];
-        }
-        /* faster to perform the dot-product for each vector seperately */
-        utility_cvvdot(Y_grid_s, invCx_Ygrid_s, nSH, NO_CONJ, &denum);
-        
-        /* calculate the MVDR weights per grid direction: (Cx^-1 * Y) * (Y^T * Cx^-1 * Y)^-1 */
-        for(j=0; j<nSH; j++)
-            w_MVDR[j*nGrid_dirs +i] = ccdivf(invCx_Ygrid[j*nGrid_dirs +i], denum);
+        /* Y^T * conj(Cx^-1 * Y) */
+        cblas_cdotc_sub(nSH, &invCx_Ygrid[i], ldInvCx_Ygrid, &Y_grid[i], nGrid_dirs, &denum);
+        denum = ccdivf(cmplxf(1.0f, 0.0f), denum);
+        cblas_cscal(nSH, &denum, &w_MVDR[i], nGrid_dirs);
     }
+}
+
+void generateMVDRmap
+(
+    int order,
+    float_complex* Cx,
+    float_complex* Y_grid,
+    int nGrid_dirs,
+    float regPar,
+    float* pmap,
+    float_complex* w_MVDR_out
+)
+{
+    int nSH;
+    float_complex *U, *invCx_Ygrid, *w_MVDR;
+    
+    nSH = (order+1)*(order+1);
+    w_MVDR = w_MVDR_out!=NULL ? w_MVDR_out : malloc(nSH * nGrid_dirs*sizeof(float_complex));
+    U = malloc(nSH*nSH*sizeof(float_complex));
+    invCx_Ygrid = malloc(nSH*nGrid_dirs*sizeof(float_complex));
+    
+    /* solve the numerator part of the MVDR weights for all grid directions: Cx^-1 * Y. The (diagonally loaded)
+     * covariance matrix is factorised only once */
+    getLoadedCovCholFactor(Cx, nSH, regPar, U);
+    utility_ccholslv(U, nSH, Y_grid, nGrid_dirs, invCx_Ygrid);
+    getMVDRweights(Y_grid, invCx_Ygrid, nGrid_dirs, nSH, nGrid_dirs, w_MVDR);
     
     /* generate MVDR powermap, by using the generatePWDmap function with the MVDR weights instead */
     generatePWDmap(order, Cx, w_MVDR, nGrid_dirs, pmap);
     
+    if (w_MVDR_out==NULL)
+        free(w_MVDR);
+    free(U);
+    free(invCx_Ygrid);
+}
+
+void generateMVDRmapReal
+(
+    int order,
+    float_complex* Cx,
+    float* Y_grid,
+    int nGrid_dirs,
+    float regPar,
+    float* pmap,
+    float_complex* w_MVDR_out
+)
+{
+    int i, j, nSH;
+    float loading, re, im;
+    float *denum_re, *denum_im, *sq_re, *sq_im;
+    float_complex denum, invCx_Ygrid_sq;
+    float_complex *U, *invCx_Ygrid;
+    
+    nSH = (order+1)*(order+1);
+    U = malloc(nSH*nSH*sizeof(float_complex));
+    invCx_Ygrid = malloc(nSH*nGrid_dirs*sizeof(float_complex));
+    denum_re = calloc(nGrid_dirs, sizeof(float));
+    denum_im = calloc(nGrid_dirs, sizeof(float));
+    sq_re = calloc(nGrid_dirs, sizeof(float));
+    sq_im = calloc(nGrid_dirs, sizeof(float));
+    
+    /* solve the numerator part of the MVDR weights for all grid directions: Cx^-1 * Y. The (diagonally loaded)
+     * covariance matrix is factorised only once */
+    loading = getLoadedCovCholFactor(Cx, nSH, regPar, U);
+    for(i=0; i<nSH*nGrid_dirs; i++)
+        invCx_Ygrid[i] = cmplxf(Y_grid[i], 0.0f);
+    utility_ccholslv(U, nSH, invCx_Ygrid, nGrid_dirs, invCx_Ygrid);
+    
+    /* the denumerator part of the MVDR weights, Y^T * conj(Cx^-1 * Y), along with (Cx^-1 * Y)^T * (Cx^-1 * Y), for all
+     * directions in one pass (real-by-complex, with the real and imaginary parts accumulated seperately) */
+    for(j=0; j<nSH; j++){
+        for(i=0; i<nGrid_dirs; i++){
+            re = crealf(invCx_Ygrid[j*nGrid_dirs+i]);
+            im = cimagf(invCx_Ygrid[j*nGrid_dirs+i]);
+            denum_re[i] += re * Y_grid[j*nGrid_dirs+i];
+            denum_im[i] -= im * Y_grid[j*nGrid_dirs+i];
+            sq_re[i] += re*re - im*im;
+            sq_im[i] += 2.0f*re*im;
+        }
+    }
+    
+    /* MVDR powermap: real(w^T * Cx * w), where w = (Cx^-1 * Y) / denum. Since (Cx + loading*I) * (Cx^-1 * Y) = Y (with
+     * Cx^-1 referring to the loaded matrix), it follows that: w^T * Cx * w = (conj(denum) - loading*(Cx^-1 * Y)^T *
+     * (Cx^-1 * Y)) / denum^2, and Cx need not be multiplied with the weights */
+    for(i=0; i<nGrid_dirs; i++){
+        denum = cmplxf(denum_re[i], denum_im[i]);
+        invCx_Ygrid_sq = cmplxf(sq_re[i], sq_im[i]);
+        pmap[i] = crealf(ccdivf(ccsubf(conjf(denum), crmulf(invCx_Ygrid_sq, loading)), ccmulf(denum, denum)));
+    }
+    
     /* optional output of the beamforming weights */
-    if (w_MVDR_out!=NULL)
-        memcpy(w_MVDR_out, w_MVDR, nSH * nGrid_dirs*sizeof(float_complex));
+    if (w_MVDR_out!=NULL){
+        for(i=0; i<nGrid_dirs; i++){
+            denum = ccdivf(cmplxf(1.0f, 0.0f), cmplxf(denum_re[i], denum_im[i]));
+            cblas_ccopy(nSH, &invCx_Ygrid[i], nGrid_dirs, &w_MVDR_out[i], nGrid_dirs);
+            cblas_cscal(nSH, &denum, &w_MVDR_out[i], nGrid_dirs);
+        }
+    }
     
-    free(w_MVDR);
-    free(Cx_d);
+    free(U);
     free(invCx_Ygrid);
-    free(invCx_Ygrid_s);
-    free(Y_grid_s);
+    free(denum_re);
+    free(denum_im);
+    free(sq_re);
+    free(sq_im);
 }
 
 /* EXPERIMENTAL
@@ -908,31 +1441,35 @@ void generateCroPaCLCMVmap
     float* pmap  
 )
 {
-    int i, j, k, nSH;
-    float Cx_trace, S, G;
-    float* mvdr_map;
-    float_complex* Cx_d, *A, *invCxd_A, *invCxd_A_tmp, *w_LCMV_s, *w_CroPaC, *wo, *Cx_Y, *Cx_Y_s;
-	float_complex b[2]; 
+    int i, j, nSH, nCol;
+    float S, G;
+    float_complex *U, *A, *invCxd_A, *w_MVDR, *Cx_Y;
+    float_complex m00, m01, m10, m11, s0, s1, det, Y_wo_xspec;
     const float_complex calpha = cmplxf(1.0f, 0.0f), cbeta = cmplxf(0.0f, 0.0f);
-    float_complex A_invCxd_A[2][2];
-    float_complex Y_wo_xspec;
     
-	b[0] = cmplxf(1.0f, 0.0f);
-	b[1] = cmplxf(0.0f, 0.0f);
     nSH = (order+1)*(order+1);
-    Cx_Y = malloc(nSH * nGrid_dirs * sizeof(float_complex));
-    Cx_d = malloc(nSH*nSH*sizeof(float_complex));
-    A = malloc(nSH*2*sizeof(float_complex));
-    invCxd_A = malloc(nSH*2*sizeof(float_complex));
-    invCxd_A_tmp = malloc(nSH*2*sizeof(float_complex));
-    w_LCMV_s = malloc(2*nGrid_dirs*sizeof(float_complex));
-    w_CroPaC = malloc(nSH*nGrid_dirs*sizeof(float_complex));
-    wo = malloc(nSH*sizeof(float_complex));
-    mvdr_map = malloc(nGrid_dirs*sizeof(float));
-    Cx_Y_s = malloc(nSH*sizeof(float_complex));
-    
-    /* generate MVDR map and weights to use as a basis */
-    generateMVDRmap(order, Cx, Y_grid, nGrid_dirs, regPar, mvdr_map, w_CroPaC);
+    nCol = 2*nGrid_dirs;
+    U = malloc(nSH*nSH*sizeof(float_complex));
+    A = malloc(nSH*nCol*sizeof(float_complex));
+    invCxd_A = malloc(nSH*nCol*sizeof(float_complex));
+    w_MVDR = malloc(nSH*nGrid_dirs*sizeof(float_complex));
+    Cx_Y = malloc(nSH*nGrid_dirs*sizeof(float_complex));
+    
+    /* the two constraints of every grid direction, side by side: A = [Y_grid, Y_grid.*diag(Cx)] */
+    for(j=0; j<nSH; j++){
+        for(i=0; i<nGrid_dirs; i++){
+            A[j*nCol+i] = Y_grid[j*nGrid_dirs+i];
+            A[j*nCol+nGrid_dirs+i] = ccmulf(Y_grid[j*nGrid_dirs+i], Cx[j*nSH+j]);
+        }
+    }
+    
+    /* factorise the diagonally loaded covariance matrix once, and solve for all directions: Cx^-1 * A */
+    getLoadedCovCholFactor(Cx, nSH, regPar, U);
+    utility_ccholslv(U, nSH, A, nCol, invCxd_A);
+    
+    /* generate MVDR map to use as a basis (the first half of Cx^-1 * A is Cx^-1 * Y_grid) */
+    getMVDRweights(Y_grid, invCxd_A, nCol, nSH, nGrid_dirs, w_MVDR);
+    generatePWDmap(order, Cx, w_MVDR, nGrid_dirs, pmap);
     
     /* first half of the cross-spectrum */
     cblas_cgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, nSH, nGrid_dirs, nSH, &calpha,
@@ -940,65 +1477,43 @@ void generateCroPaCLCMVmap
                 Y_grid, nGrid_dirs, &cbeta,
                 Cx_Y, nGrid_dirs);
     
-    /* apply diagonal loading to cov matrix */
-    Cx_trace = 0.0f;
-    for(i=0; i<nSH; i++)
-        Cx_trace += crealf(Cx[i*nSH+i]);
-    Cx_trace /= (float)nSH;
-    memcpy(Cx_d, Cx, nSH*nSH*sizeof(float_complex));
-    for(i=0; i<nSH; i++)
-        Cx_d[i*nSH+i] = craddf(Cx_d[i*nSH+i], regPar*Cx_trace);
-    
     /* calculate CroPaC beamforming weights for each grid direction */
     for(i=0; i<nGrid_dirs; i++){
-        for(j=0; j<nSH; j++){
-            A[j*2] = Y_grid[j*nGrid_dirs+i];
-            A[j*2+1] = ccmulf(A[j*2], Cx[j*nSH+j]);
-        }
-        
-        /* solve for minimisation problem for LCMV weights: (Cx^-1 * A) * (A^H * Cx^-1 * A)^-1 * b */
-        utility_cslslv(Cx_d, nSH, A, 2, invCxd_A);
-        for(j=0; j<nSH*2; j++)
-            invCxd_A_tmp[j] = conjf(invCxd_A[j]);
-        cblas_cgemm(CblasRowMajor, CblasConjTrans, CblasNoTrans, 2, 2, nSH, &calpha,
-                    A, 2,
-                    invCxd_A_tmp, 2, &cbeta,
-                    A_invCxd_A, 2);
-        for(j=0; j<nSH; j++)
-            for(k=0; k<2; k++)
-                invCxd_A_tmp[k*nSH+j] = invCxd_A[j*2+k];
-        utility_cglslv((float_complex*)A_invCxd_A, 2, invCxd_A_tmp, nSH, w_LCMV_s);
-        cblas_cgemm(CblasRowMajor, CblasTrans, CblasNoTrans, nSH, 1, 2, &calpha,
-                    w_LCMV_s, nSH,
-                    b, 1, &cbeta,
-                    wo, 1);
+        /* conj(A^H * Cx^-1 * A), and the cross-spectra between the static beam Y and both columns of Cx^-1 * A
+         * (strided dot-products, so that the columns need not be copied first) */
+        cblas_cdotu_sub(nSH, &A[i], nCol, &invCxd_A[i], nCol, &m00);
+        cblas_cdotu_sub(nSH, &A[i], nCol, &invCxd_A[nGrid_dirs+i], nCol, &m01);
+        cblas_cdotu_sub(nSH, &A[nGrid_dirs+i], nCol, &invCxd_A[i], nCol, &m10);
+        cblas_cdotu_sub(nSH, &A[nGrid_dirs+i], nCol, &invCxd_A[nGrid_dirs+i], nCol, &m11);
+        cblas_cdotu_sub(nSH, &invCxd_A[i], nCol, &Cx_Y[i], nGrid_dirs, &s0);
+        cblas_cdotu_sub(nSH, &invCxd_A[nGrid_dirs+i], nCol, &Cx_Y[i], nGrid_dirs, &s1);
+        m00 = conjf(m00);
+        m01 = conjf(m01);
+        m10 = conjf(m10);
+        m11 = conjf(m11);
         
-        /* calculate the cross-spectrum between static beam Y, and adaptive beam wo (LCMV) */
-        for(j=0; j<nSH; j++)
-            Cx_Y_s[j] = Cx_Y[j*nGrid_dirs+i];
-        utility_cvvdot(wo, Cx_Y_s, nSH, NO_CONJ, &Y_wo_xspec);
+        /* LCMV weights: wo = (Cx^-1 * A) * (A^H * Cx^-1 * A)^-1 * b, where b = [1 0]^T. Only the first row of the 2x2
+         * inverse is required, and the cross-spectrum between Y and wo follows directly from s0 and s1 */
+        det = ccsubf(ccmulf(m00, m11), ccmulf(m01, m10));
+        if(cabsf(det) > 0.0f)
+            Y_wo_xspec = ccdivf(ccsubf(ccmulf(m11, s0), ccmulf(m01, s1)), det);
+        else
+            Y_wo_xspec = cmplxf(0.0f, 0.0f);
         
         /* derive CroPaC weights  */
-        S = MIN(cabsf(Y_wo_xspec), mvdr_map[i]); /* ensures distortionless response */
-        G = sqrtf(S/(mvdr_map[i]+2.23e-10f));
+        S = MIN(cabsf(Y_wo_xspec), pmap[i]); /* ensures distortionless response */
+        G = sqrtf(S/(pmap[i]+2.23e-10f));
         G = MAX(lambda, G); /* optional spectral floor parameter, to control harshness of attenuation (good for demos) */
-        for(j=0; j<nSH; j++)
-            w_CroPaC[j*nGrid_dirs + i] = crmulf(w_CroPaC[j*nGrid_dirs + i], G);
+        
+        /* the CroPaC weights are the MVDR weights scaled by G, so their PWD map is the MVDR map scaled by G^2 */
+        pmap[i] *= G*G;
     }
     
-    /* generate CroPaC powermap, by using the generatePWDmap function with the CroPaC weights instead */
-    generatePWDmap(order, Cx, w_CroPaC, nGrid_dirs, pmap);
-    
-    free(mvdr_map);
-    free(Cx_d);
+    free(U);
     free(A);
     free(invCxd_A);
-    free(invCxd_A_tmp);
-    free(w_LCMV_s);
-    free(w_CroPaC);
-    free(wo);
+    free(w_MVDR);
     free(Cx_Y);
-    free(Cx_Y_s);
 }
 
 
@@ -1014,23 +1529,17 @@ void generateMUSICmap
 )
 {
     int i, j, nSH;
-    float_complex* V, *Vn, *Vn_Y;
+    float_complex* Vn, *Vn_Y;
     const float_complex calpha = cmplxf(1.0f, 0.0f), cbeta = cmplxf(0.0f, 0.0f);
     float_complex tmp;
     
     nSH = (order+1)*(order+1);
     nSources = MIN(nSources, nSH/2);
-    V = malloc(nSH*nSH*sizeof(float_complex));
     Vn = malloc(nSH*(nSH-nSources)*sizeof(float_complex));
     Vn_Y = malloc((nSH-nSources)*nGrid_dirs*sizeof(float_complex));
     
-    /* obtain eigenvectors */
-    utility_ceig(Cx, nSH, 1, NULL, V, NULL);
-    
-    /* truncate, to obtain noise sub-space */
-    for(i=0; i<nSH; i++)
-        for(j=0; j<nSH-nSources; j++)
-            Vn[i*(nSH-nSources)+j] = V[i*nSH + j + nSources];
+    /* obtain the eigenvectors of the noise sub-space only (i.e. those of the nSH-nSources smallest eigenvalues) */
+    utility_cheig(Cx, nSH, 1, nSources, nSH-1, Vn, NULL);
     
     /* derive the pseudo-spectrum value for each grid direction */
     cblas_cgemm(CblasRowMajor, CblasTrans, CblasNoTrans, nSH-nSources, nGrid_dirs, nSH, &calpha,
@@ -1044,7 +1553,6 @@ void generateMUSICmap
         pmap[i] = logScaleFlag ? logf(1.0f/(crealf(tmp)+2.23e-10f)) : 1.0f/(crealf(tmp)+2.23e-10f);
     }
     
-    free(V);
     free(Vn);
     free(Vn_Y);
 }
@@ -1060,31 +1568,24 @@ void generateMinNormMap
     float* pmap
 )
 {
-    int i, j, nSH;
-    float_complex* V, *Vn, *Vn1, *Un, *Un_Y;
+    int i, nSH;
+    float_complex* Vn, *Vn1, *Un, *Un_Y;
     const float_complex calpha = cmplxf(1.0f, 0.0f), cbeta = cmplxf(0.0f, 0.0f);
     float_complex Vn1_Vn1H;
     
     nSH = (order+1)*(order+1);
     nSources = MIN(nSources, nSH/2);
-    V = malloc(nSH*nSH*sizeof(float_complex));
     Vn = malloc(nSH*(nSH-nSources)*sizeof(float_complex));
     Vn1 = malloc((nSH-nSources)*sizeof(float_complex));
     Un = malloc(nSH*sizeof(float_complex));
     Un_Y = malloc(nGrid_dirs*sizeof(float_complex));
     
-    /* obtain eigenvectors */
-    utility_ceig(Cx, nSH, 1, NULL, V, NULL);
-    
-    /* truncate, to obtain noise sub-space */
-    for(i=0; i<nSH; i++)
-        for(j=0; j<nSH-nSources; j++)
-            Vn[i*(nSH-nSources)+j] = V[i*nSH + j + nSources];
-    for(j=0; j<nSH-nSources; j++)
-        Vn1[j] = V[j + nSources];
+    /* obtain the eigenvectors of the noise sub-space only (i.e. those of the nSH-nSources smallest eigenvalues) */
+    utility_cheig(Cx, nSH, 1, nSources, nSH-1, Vn, NULL);
+    memcpy(Vn1, Vn, (nSH-nSources)*sizeof(float_complex));
     
     /* derive the pseudo-spectrum value for each grid direction */
-    utility_cvvdot(Vn1, Vn1, nSH-nSources, NO_CONJ, &Vn1_Vn1H);
+    utility_cvvdot(Vn1, Vn1, nSH-nSources, CONJ, &Vn1_Vn1H); /* ||Vn1||^2, which does not depend on the phases of the eigenvectors */
     cblas_cgemm(CblasRowMajor, CblasNoTrans, CblasConjTrans, nSH, 1, nSH-nSources, &calpha,
                 Vn, nSH-nSources,
                 Vn1, nSH-nSources, &cbeta,
@@ -1098,13 +1599,189 @@ void generateMinNormMap
     for(i=0; i<nGrid_dirs; i++)
         pmap[i] = logScaleFlag ? logf(1.0f/(powf(cabsf(Un_Y[i]),2.0f) + 2.23e-9f)) : 1.0f/(powf(cabsf(Un_Y[i]),2.0f) + 2.23e-9f);
     
-    free(V);
     free(Vn);
     free(Vn1);
     free(Un);
     free(Un_Y);
 }
 
+void resetSubspacePASTd
+(
+    int nSH,
+    int nSources,
+    float_complex* W,
+    float* d
+)
+{
+    int k;
+    
+    /* any orthonormal basis will do as a starting point */
+    memset(W, 0, nSources*nSH*sizeof(float_complex));
+    for(k=0; k<MIN(nSources, nSH); k++)
+        W[k*nSH+k] = cmplxf(1.0f, 0.0f);
+    memset(d, 0, nSources*sizeof(float));
+}
+
+void updateSubspacePASTd
+(
+    float_complex* X,
+    int ldX,
+    int nSH,
+    int nSnapshots,
+    float scale,
+    float beta,
+    int nSources,
+    float_complex* W,
+    float* d,
+    float_complex* work
+)
+{
+    int i, k, t;
+    float y2;
+    float_complex y, a;
+    float_complex* x;
+    
+    x = work;
+    for(t=0; t<nSnapshots; t++){
+        for(i=0; i<nSH; i++)
+            x[i] = crmulf(X[i*ldX+t], scale);
+        
+        /* the eigenvectors are updated one by one, and the projection of the snapshot onto each updated eigenvector is
+         * removed (deflated) before updating the next one */
+        for(k=0; k<nSources; k++){
+            cblas_cdotc_sub(nSH, &W[k*nSH], 1, x, 1, &y);                  /* y = w^H x */
+            y2 = crealf(y)*crealf(y) + cimagf(y)*cimagf(y);
+            d[k] = beta*d[k] + y2;
+            if(d[k] < 2.23e-20f)
+                continue;
+            /* w = w + (x - w y) y^* / d */
+            cblas_csscal(nSH, 1.0f - y2/d[k], &W[k*nSH], 1);
+            a = crmulf(conjf(y), 1.0f/d[k]);
+            cblas_caxpy(nSH, &a, x, 1, &W[k*nSH], 1);
+            /* x = x - w y */
+            a = crmulf(y, -1.0f);
+            cblas_caxpy(nSH, &a, &W[k*nSH], 1, x, 1);
+        }
+    }
+}
+
+/* orthonormalises the rows of Vs (modified Gram-Schmidt) */
+static void orthonormaliseRows
+(
+    float_complex* Vs,
+    int nRows,
+    int len
+)
+{
+    int k, m;
+    float nrm;
+    float_complex a;
+    
+    for(k=0; k<nRows; k++){
+        for(m=0; m<k; m++){
+            cblas_cdotc_sub(len, &Vs[m*len], 1, &Vs[k*len], 1, &a);
+            a = crmulf(a, -1.0f);
+            cblas_caxpy(len, &a, &Vs[m*len], 1, &Vs[k*len], 1);
+        }
+        nrm = cblas_scnrm2(len, &Vs[k*len], 1);
+        if(nrm > 2.23e-9f)
+            cblas_csscal(len, 1.0f/nrm, &Vs[k*len], 1);
+        else
+            memset(&Vs[k*len], 0, len*sizeof(float_complex));
+    }
+}
+
+void generateMUSICmapFromSubspace
+(
+    int order,
+    float_complex* Vs,
+    float_complex* Y_grid,
+    int nSources,
+    int nGrid_dirs,
+    int logScaleFlag,
+    float* pmap
+)
+{
+    int i, j, k, nSH;
+    float Y_nrm2, Vs_Y_nrm2, Vn_Y_nrm2;
+    float_complex* Q, *Vs_Y;
+    const float_complex calpha = cmplxf(1.0f, 0.0f), cbeta = cmplxf(0.0f, 0.0f);
+    
+    nSH = (order+1)*(order+1);
+    nSources = MIN(nSources, nSH/2);
+    Q = malloc(nSources*nSH*sizeof(float_complex));
+    Vs_Y = malloc(nSources*nGrid_dirs*sizeof(float_complex));
+    memcpy(Q, Vs, nSources*nSH*sizeof(float_complex));
+    orthonormaliseRows(Q, nSources, nSH);
+    
+    /* since [Vs Vn] is unitary: ||Vn^T Y||^2 = ||Y||^2 - ||Vs^T Y||^2, so the noise sub-space is not needed */
+    cblas_cgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, nSources, nGrid_dirs, nSH, &calpha,
+                Q, nSH,
+                Y_grid, nGrid_dirs, &cbeta,
+                Vs_Y, nGrid_dirs);
+    for(i=0; i<nGrid_dirs; i++){
+        Y_nrm2 = Vs_Y_nrm2 = 0.0f;
+        for(j=0; j<nSH; j++)
+            Y_nrm2 += powf(cabsf(Y_grid[j*nGrid_dirs+i]), 2.0f);
+        for(k=0; k<nSources; k++)
+            Vs_Y_nrm2 += powf(cabsf(Vs_Y[k*nGrid_dirs+i]), 2.0f);
+        Vn_Y_nrm2 = MAX(Y_nrm2 - Vs_Y_nrm2, 0.0f);
+        pmap[i] = logScaleFlag ? logf(1.0f/(Vn_Y_nrm2+2.23e-10f)) : 1.0f/(Vn_Y_nrm2+2.23e-10f);
+    }
+    
+    free(Q);
+    free(Vs_Y);
+}
+
+void generateMinNormMapFromSubspace
+(
+    int order,
+    float_complex* Vs,
+    float_complex* Y_grid,
+    int nSources,
+    int nGrid_dirs,
+    int logScaleFlag,
+    float* pmap
+)
+{
+    int i, k, nSH;
+    float Vn1_Vn1H;
+    float_complex* Q, *Un, *Un_Y;
+    const float_complex calpha = cmplxf(1.0f, 0.0f), cbeta = cmplxf(0.0f, 0.0f);
+    
+    nSH = (order+1)*(order+1);
+    nSources = MIN(nSources, nSH/2);
+    Q = malloc(nSources*nSH*sizeof(float_complex));
+    Un = malloc(nSH*sizeof(float_complex));
+    Un_Y = malloc(nGrid_dirs*sizeof(float_complex));
+    memcpy(Q, Vs, nSources*nSH*sizeof(float_complex));
+    orthonormaliseRows(Q, nSources, nSH);
+    
+    /* Un = Vn*Vn1^H = (I - Vs*Vs^H)(:,1), and ||Vn1||^2 = 1 - ||Vs(1,:)||^2, so the noise sub-space is not needed */
+    Vn1_Vn1H = 1.0f;
+    for(i=0; i<nSH; i++)
+        Un[i] = cmplxf(i==0 ? 1.0f : 0.0f, 0.0f);
+    for(k=0; k<nSources; k++){
+        for(i=0; i<nSH; i++)
+            Un[i] = ccsubf(Un[i], ccmulf(Q[k*nSH+i], conjf(Q[k*nSH])));
+        Vn1_Vn1H -= powf(cabsf(Q[k*nSH]), 2.0f);
+    }
+    for(i=0; i<nSH; i++)
+        Un[i] = crmulf(Un[i], 1.0f/(MAX(Vn1_Vn1H, 0.0f) + 2.23e-9f));
+    
+    /* derive the pseudo-spectrum value for each grid direction */
+    cblas_cgemm(CblasRowMajor, CblasConjTrans, CblasNoTrans, 1, nGrid_dirs, nSH, &calpha,
+                Un, 1,
+                Y_grid, nGrid_dirs, &cbeta,
+                Un_Y, nGrid_dirs);
+    for(i=0; i<nGrid_dirs; i++)
+        pmap[i] = logScaleFlag ? logf(1.0f/(powf(cabsf(Un_Y[i]),2.0f) + 2.23e-9f)) : 1.0f/(powf(cabsf(Un_Y[i]),2.0f) + 2.23e-9f);
+    
+    free(Q);
+    free(Un);
+    free(Un_Y);
+}
+
 void bessel_Jn /* untested */
 (
     int N,
@@ -1237,43 +1914,26 @@ void bessel_jn
     double* dj_n
 )
 {
-    int n, i, NM;
+    int n, i;
+    int* NM;
     double* j_n_tmp, *dj_n_tmp;
     
-    j_n_tmp = malloc((N+1)*sizeof(double));
-    dj_n_tmp = malloc((N+1)*sizeof(double));
-    *maxN = 1e8;
+    NM = malloc(nZ*sizeof(int));
+    j_n_tmp = malloc(nZ*(N+1)*sizeof(double));
+    dj_n_tmp = dj_n==NULL ? NULL : malloc(nZ*(N+1)*sizeof(double));
+    sphBesselJY_vec(N, z, nZ, NM, j_n_tmp, dj_n_tmp, NULL, NULL, NULL);
+    *maxN = N;
     for(i=0; i<nZ; i++){
-        if(z[i] <= 1e-15){
-            if(j_n!=NULL){
-                memset(&j_n[0], 0, (N+1)*sizeof(double));
-                j_n[0] = 1.0f;
-            }
-            if(dj_n!=NULL){
-                memset(&dj_n[0], 0, (N+1)*sizeof(double));
-                if(N>0)
-                    dj_n[1] = 1.0/3.0;
-            }
-        }
-        else{
-            SPHJ(N, z[i], &NM, j_n_tmp, dj_n_tmp);
-            *maxN = MIN(NM, *maxN );
-            for(n=0; n<NM; n++){
-                if(j_n!=NULL)
-                    j_n [i*(N+1)+n] = j_n_tmp[n];
-                if(dj_n!=NULL)
-                    dj_n[i*(N+1)+n] = dj_n_tmp[n];
-            }
-            for(; n<N+1; n++){
-                if(j_n!=NULL)
-                    j_n [i*(N+1)+n] = 0.0;
-                if(dj_n!=NULL)
-                    dj_n [i*(N+1)+n] = 0.0;
-            }
+        *maxN = MIN(NM[i], *maxN); /* maximum order that could be computed */
+        for(n=0; n<N+1; n++){
+            if(j_n!=NULL)
+                j_n [i*(N+1)+n] = j_n_tmp[n*nZ+i];
+            if(dj_n!=NULL)
+                dj_n[i*(N+1)+n] = dj_n_tmp[n*nZ+i];
         }
     }
-    *maxN = *maxN==1e8 ? 0 : *maxN; /* maximum order that could be computed */
     
+    free(NM);
     free(j_n_tmp);
     free(dj_n_tmp);
 }
@@ -1339,38 +1999,26 @@ void bessel_yn
     double* dy_n
 )
 {
-    int n, i, NM;
+    int n, i;
+    int* NM;
     double* y_n_tmp, *dy_n_tmp;
     
-    y_n_tmp = malloc((N+1)*sizeof(double));
-    dy_n_tmp = malloc((N+1)*sizeof(double));
-    *maxN = 1e8;
+    NM = malloc(nZ*sizeof(int));
+    y_n_tmp = malloc(nZ*(N+1)*sizeof(double));
+    dy_n_tmp = dy_n==NULL ? NULL : malloc(nZ*(N+1)*sizeof(double));
+    sphBesselJY_vec(N, z, nZ, NULL, NULL, NULL, NM, y_n_tmp, dy_n_tmp);
+    *maxN = N;
     for(i=0; i<nZ; i++){
-        if(z[i] <= 1e-15){
+        *maxN = MIN(NM[i], *maxN); /* maximum order that could be computed */
+        for(n=0; n<N+1; n++){
             if(y_n!=NULL)
-                memset(&y_n[0], 0, (N+1)*sizeof(double));
+                y_n [i*(N+1)+n] = y_n_tmp[n*nZ+i];
             if(dy_n!=NULL)
-                memset(&dy_n[0], 0, (N+1)*sizeof(double));
-        }
-        else{
-            SPHY(N, z[i], &NM, y_n_tmp, dy_n_tmp);
-            *maxN = MIN(NM, *maxN );
-            for(n=0; n<NM; n++){
-                if(y_n!=NULL)
-                    y_n [i*(N+1)+n] = y_n_tmp[n];
-                if(dy_n!=NULL)
-                    dy_n[i*(N+1)+n] = dy_n_tmp[n];
-            }
-            for(; n<N+1; n++){
-                if(y_n!=NULL)
-                    y_n [i*(N+1)+n] = 0.0;
-                if(dy_n!=NULL)
-                    dy_n [i*(N+1)+n] = 0.0;
-            }
+                dy_n[i*(N+1)+n] = dy_n_tmp[n*nZ+i];
         }
     }
-    *maxN = *maxN==1e8 ? 0 : *maxN; /* maximum order that could be computed */
     
+    free(NM);
     free(y_n_tmp);
     free(dy_n_tmp);
 }
@@ -1431,44 +2079,37 @@ void hankel_hn1
     double_complex* dh_n1
 )
 {
-    int n, i, NM1, NM2;
+    int n, i, NM;
+    int* NM1, *NM2;
     double* j_n_tmp, *dj_n_tmp, *y_n_tmp, *dy_n_tmp;
     
-    j_n_tmp = calloc((N+1),sizeof(double));
-    dj_n_tmp = calloc((N+1),sizeof(double));
-    y_n_tmp = calloc((N+1),sizeof(double));
-    dy_n_tmp = calloc((N+1),sizeof(double));
-    *maxN = 1e8;
+    NM1 = malloc(nZ*sizeof(int));
+    NM2 = malloc(nZ*sizeof(int));
+    j_n_tmp = malloc(nZ*(N+1)*sizeof(double));
+    dj_n_tmp = dh_n1==NULL ? NULL : malloc(nZ*(N+1)*sizeof(double));
+    y_n_tmp = malloc(nZ*(N+1)*sizeof(double));
+    dy_n_tmp = dh_n1==NULL ? NULL : malloc(nZ*(N+1)*sizeof(double));
+    sphBesselJY_vec(N, z, nZ, NM1, j_n_tmp, dj_n_tmp, NM2, y_n_tmp, dy_n_tmp);
+    *maxN = N;
     for(i=0; i<nZ; i++){
-        if(z[i] <= 1e-15){
-            if(h_n1!=NULL){
-                memset(&h_n1[0], 0, (N+1)*sizeof(double_complex));
-                h_n1[0] = cmplx(1.0, 0.0);
-            }
+        NM = MIN(NM1[i], NM2[i]);
+        *maxN = MIN(NM, *maxN); /* maximum order that could be computed */
+        for(n=0; n<NM+1; n++){
+            if(h_n1!=NULL)
+                h_n1 [i*(N+1)+n] = cmplx(j_n_tmp[n*nZ+i], y_n_tmp[n*nZ+i]);
             if(dh_n1!=NULL)
-                memset(&dh_n1[0], 0, (N+1)*sizeof(double_complex));
+                dh_n1[i*(N+1)+n] = cmplx(dj_n_tmp[n*nZ+i], dy_n_tmp[n*nZ+i]);
         }
-        else{
-            SPHJ(N, z[i], &NM1, j_n_tmp, dj_n_tmp);
-            *maxN = MIN(NM1, *maxN );
-            SPHY(N, z[i], &NM2, y_n_tmp, dy_n_tmp);
-            *maxN = MIN(NM2, *maxN );
-            for(n=0; n<MIN(NM1,NM2); n++){
-                if(h_n1!=NULL)
-                    h_n1 [i*(N+1)+n] = cmplx(j_n_tmp[n], y_n_tmp[n]);
-                if(dh_n1!=NULL)
-                    dh_n1[i*(N+1)+n] = cmplx(dj_n_tmp[n], dy_n_tmp[n]);
-            }
-            for(; n<N+1; n++){
-                if(h_n1!=NULL)
-                    h_n1 [i*(N+1)+n] = cmplx(0.0,0.0);
-                if(dh_n1!=NULL)
-                    dh_n1 [i*(N+1)+n] = cmplx(0.0,0.0);
-            }
+        for(; n<N+1; n++){
+            if(h_n1!=NULL)
+                h_n1 [i*(N+1)+n] = cmplx(0.0,0.0);
+            if(dh_n1!=NULL)
+                dh_n1 [i*(N+1)+n] = cmplx(0.0,0.0);
         }
     }
-    *maxN = *maxN==1e8 ? 0 : *maxN; /* maximum order that could be computed */
     
+    free(NM1);
+    free(NM2);
     free(j_n_tmp);
     free(dj_n_tmp);
     free(y_n_tmp);
@@ -1485,44 +2126,37 @@ void hankel_hn2
     double_complex* dh_n2
 )
 {
-    int n, i, NM1, NM2;
+    int n, i, NM;
+    int* NM1, *NM2;
     double* j_n_tmp, *dj_n_tmp, *y_n_tmp, *dy_n_tmp;
     
-    j_n_tmp = calloc((N+1),sizeof(double));
-    dj_n_tmp = calloc((N+1),sizeof(double));
-    y_n_tmp = calloc((N+1),sizeof(double));
-    dy_n_tmp = calloc((N+1),sizeof(double));
-    *maxN = 1e8;
+    NM1 = malloc(nZ*sizeof(int));
+    NM2 = malloc(nZ*sizeof(int));
+    j_n_tmp = malloc(nZ*(N+1)*sizeof(double));
+    dj_n_tmp = dh_n2==NULL ? NULL : malloc(nZ*(N+1)*sizeof(double));
+    y_n_tmp = malloc(nZ*(N+1)*sizeof(double));
+    dy_n_tmp = dh_n2==NULL ? NULL : malloc(nZ*(N+1)*sizeof(double));
+    sphBesselJY_vec(N, z, nZ, NM1, j_n_tmp, dj_n_tmp, NM2, y_n_tmp, dy_n_tmp);
+    *maxN = N;
     for(i=0; i<nZ; i++){
-        if(z[i] <= 1e-15){
-            if(h_n2!=NULL){
-                memset(&h_n2[0], 0, (N+1)*sizeof(double_complex));
-                h_n2[0] = cmplx(1.0, 0.0);
-            }
+        NM = MIN(NM1[i], NM2[i]);
+        *maxN = MIN(NM, *maxN); /* maximum order that could be computed */
+        for(n=0; n<NM+1; n++){
+            if(h_n2!=NULL)
+                h_n2 [i*(N+1)+n] = cmplx(j_n_tmp[n*nZ+i], -y_n_tmp[n*nZ+i]);
             if(dh_n2!=NULL)
-                memset(&dh_n2[0], 0, (N+1)*sizeof(double_complex));
+                dh_n2[i*(N+1)+n] = cmplx(dj_n_tmp[n*nZ+i], -dy_n_tmp[n*nZ+i]);
         }
-        else{
-            SPHJ(N, z[i], &NM1, j_n_tmp, dj_n_tmp);
-            *maxN = MIN(NM1, *maxN );
-            SPHY(N, z[i], &NM2, y_n_tmp, dy_n_tmp);
-            *maxN = MIN(NM2, *maxN );
-            for(n=0; n<MIN(NM1,NM2); n++){
-                if(h_n2!=NULL)
-                    h_n2 [i*(N+1)+n] = cmplx(j_n_tmp[n], -y_n_tmp[n]);
-                if(dh_n2!=NULL)
-                    dh_n2[i*(N+1)+n] = cmplx(dj_n_tmp[n], -dy_n_tmp[n]);
-            }
-            for(; n<N+1; n++){
-                if(h_n2!=NULL)
-                    h_n2 [i*(N+1)+n] = cmplx(0.0,0.0);
-                if(dh_n2!=NULL)
-                    dh_n2 [i*(N+1)+n] = cmplx(0.0,0.0);
-            }
+        for(; n<N+1; n++){
+            if(h_n2!=NULL)
+                h_n2 [i*(N+1)+n] = cmplx(0.0,0.0);
+            if(dh_n2!=NULL)
+                dh_n2 [i*(N+1)+n] = cmplx(0.0,0.0);
         }
     }
-    *maxN = *maxN==1e8 ? 0 : *maxN; /* maximum order that could be computed */
     
+    free(NM1);
+    free(NM2);
     free(j_n_tmp);
     free(dj_n_tmp);
     free(y_n_tmp);
@@ -1541,6 +2175,7 @@ void cylModalCoeffs
     int i, n;
     double* Jn, *Jnprime;
     double_complex* Hn2, *Hn2prime;
+    const double i_n[4][2] = { {1.0, 0.0}, {0.0, 1.0}, {-1.0, 0.0}, {0.0, -1.0} }; /* 1i^n */
     
     assert(arrayType!=ARRAY_CONSTRUCTION_DIRECTIONAL);
     
@@ -1555,7 +2190,7 @@ void cylModalCoeffs
             /* modal coefficients for open spherical array (omni sensors): 1i^n * jn; */
             for(n=0; n<order; n++)
                 for(i=0; i<nBands; i++)
-                    b_N[i*(order+1)+n] = crmul(cpow(cmplx(0.0,1.0), cmplx((double)n,0.0)), Jn[i*(order+1)+n]);
+                    b_N[i*(order+1)+n] = crmul(cmplx(i_n[n%4][0], i_n[n%4][1]), Jn[i*(order+1)+n]);
             
             free(Jn);
             break;
@@ -1577,7 +2212,7 @@ void cylModalCoeffs
                     else if(kr[i] <= 1e-20)
                         b_N[i*(order+1)+n] = cmplx(0.0, 0.0);
                     else{
-                        b_N[i*(order+1)+n] = ccmul(cpow(cmplx(0.0,1.0), cmplx((double)n,0.0)), ( ccsub(cmplx(Jn[i*(order+1)+n], 0.0),
+                        b_N[i*(order+1)+n] = ccmul(cmplx(i_n[n%4][0], i_n[n%4][1]), ( ccsub(cmplx(Jn[i*(order+1)+n], 0.0),
                                                                                                        ccmul(ccdiv(cmplx(Jnprime[i*(order+1)+n],0.0), Hn2prime[i*(order+1)+n]), Hn2[i*(order+1)+n]))));
                     }
                 }
@@ -1605,74 +2240,69 @@ void sphModalCoeffs
     double_complex* b_N
 )
 {
-    int i, n, maxN, maxN_tmp;
-    double* jn, *jnprime;
-    double_complex* hn2, *hn2prime;
+    int i, n, maxN;
+    int* NM_j, *NM_y;
+    double re, im, D, jn_h2, jn_h2_im;
+    double* jn, *jnprime, *yn, *ynprime;
+    const double i_n[4][2] = { {1.0, 0.0}, {0.0, 1.0}, {-1.0, 0.0}, {0.0, -1.0} }; /* 1i^n */
+    
+    /* the spherical Bessels are evaluated for all kr at once; FLAT: (order+1) x nBands */
+    NM_j = malloc(nBands*sizeof(int));
+    NM_y = malloc(nBands*sizeof(int));
+    jn = malloc(nBands*(order+1)*sizeof(double));
+    jnprime = malloc(nBands*(order+1)*sizeof(double));
+    yn = ynprime = NULL;
+    if(arrayType==ARRAY_CONSTRUCTION_RIGID){
+        yn = malloc(nBands*(order+1)*sizeof(double));
+        ynprime = malloc(nBands*(order+1)*sizeof(double));
+    }
+    sphBesselJY_vec(order, kr, nBands, NM_j, jn, jnprime, NM_y, yn, ynprime);
     
     memset(b_N, 0, nBands*(order+1)*sizeof(double_complex));
-    switch(arrayType){
-        default:
-        case ARRAY_CONSTRUCTION_OPEN:
-            /* compute spherical Bessels of the first kind */
-            jn = malloc(nBands*(order+1)*sizeof(double));
-            bessel_jn(order, kr, nBands, &maxN, jn, NULL);
-            
-            /* modal coefficients for open spherical array (omni sensors): 4*pi*1i^n * jn; */
-            for(n=0; n<maxN; n++)
-                for(i=0; i<nBands; i++)
-                    b_N[i*(order+1)+n] = crmul(crmul(cpow(cmplx(0.0,1.0), cmplx((double)n,0.0)), 4.0*M_PI), jn[i*(order+1)+n]);
-            
-            free(jn);
-            break;
-            
-        case ARRAY_CONSTRUCTION_RIGID:
-            /* compute spherical Bessels/Hankels and their derivatives */
-            jn = malloc(nBands*(order+1)*sizeof(double));
-            jnprime = malloc(nBands*(order+1)*sizeof(double));
-            hn2 = malloc(nBands*(order+1)*sizeof(double_complex));
-            hn2prime = malloc(nBands*(order+1)*sizeof(double_complex));
-            maxN = 1e8;
-            bessel_jn(order, kr, nBands, &maxN_tmp, jn, jnprime);
-            maxN = MIN(maxN_tmp, maxN);
-            hankel_hn2(order, kr, nBands, &maxN_tmp, hn2, hn2prime);
-            maxN = MIN(maxN_tmp, maxN); /* maxN being the minimum highest order that was computed for all values in kr */
-            
-            /* modal coefficients for rigid spherical array: 4*pi*1i^n * (jn-(jnprime./hn2prime).*hn2); */
-            for(i=0; i<nBands; i++){
-                for(n=0; n<maxN; n++){
-                    if(n==0 && kr[i]<=1e-20)
-                        b_N[i*(order+1)+n] = cmplx(4.0*M_PI, 0.0);
-                    else if(kr[i] <= 1e-20)
-                        b_N[i*(order+1)+n] = cmplx(0.0, 0.0);
+    for(i=0; i<nBands; i++){
+        /* maximum order that could be computed for this kr */
+        maxN = arrayType==ARRAY_CONSTRUCTION_RIGID ? MIN(NM_j[i], NM_y[i]) : NM_j[i];
+        for(n=0; n<maxN+1; n++){
+            switch(arrayType){
+                default:
+                case ARRAY_CONSTRUCTION_OPEN:
+                    /* modal coefficients for open spherical array (omni sensors): 4*pi*1i^n * jn; */
+                    re = jn[n*nBands+i];
+                    im = 0.0;
+                    break;
+                    
+                case ARRAY_CONSTRUCTION_RIGID:
+                    /* modal coefficients for rigid spherical array: 4*pi*1i^n * (jn-(jnprime./hn2prime).*hn2); */
+                    if(kr[i] <= 1e-20){
+                        re = n==0 ? 1.0 : 0.0;
+                        im = 0.0;
+                    }
                     else{
-                        b_N[i*(order+1)+n] = ccmul(crmul(cpow(cmplx(0.0,1.0), cmplx((double)n,0.0)), 4.0*M_PI), ( ccsub(cmplx(jn[i*(order+1)+n], 0.0),
-                                             ccmul(ccdiv(cmplx(jnprime[i*(order+1)+n],0.0), hn2prime[i*(order+1)+n]), hn2[i*(order+1)+n]))));
+                        /* with hn2 = jn - 1i*yn, (jnprime/hn2prime)*hn2 = jnprime*conj(hn2prime)*hn2/|hn2prime|^2 */
+                        D = jnprime[n*nBands+i]*jnprime[n*nBands+i] + ynprime[n*nBands+i]*ynprime[n*nBands+i];
+                        jn_h2    = jnprime[n*nBands+i]*jn[n*nBands+i] + ynprime[n*nBands+i]*yn[n*nBands+i];
+                        jn_h2_im = ynprime[n*nBands+i]*jn[n*nBands+i] - jnprime[n*nBands+i]*yn[n*nBands+i];
+                        re = jn[n*nBands+i] - jnprime[n*nBands+i]*jn_h2/D;
+                        im = -jnprime[n*nBands+i]*jn_h2_im/D;
                     }
-                }
+                    break;
+                    
+                case ARRAY_CONSTRUCTION_DIRECTIONAL:
+                    /* modal coefficients for open spherical array (directional sensors): 4*pi*1i^n * (dirCoeff*jn - 1i*(1-dirCoeff)*jnprime); */
+                    re = dirCoeff*jn[n*nBands+i];
+                    im = -(1.0-dirCoeff)*jnprime[n*nBands+i];
+                    break;
             }
-            
-            free(jn);
-            free(jnprime);
-            free(hn2);
-            free(hn2prime);
-            break;
-            
-        case ARRAY_CONSTRUCTION_DIRECTIONAL:
-            /* compute spherical Bessels of the first kind + derivatives */
-            jn = malloc(nBands*(order+1)*sizeof(double));
-            jnprime = malloc(nBands*(order+1)*sizeof(double));
-            bessel_jn(order, kr, nBands, &maxN, jn, jnprime);
-            
-            /* modal coefficients for open spherical array (directional sensors): 4*pi*1i^n * (dirCoeff*jn - 1i*(1-dirCoeff)*jnprime); */
-            for(n=0; n<maxN; n++)
-                for(i=0; i<nBands; i++)
-                    b_N[i*(order+1)+n] = ccmul(crmul(cpow(cmplx(0.0,1.0), cmplx((double)n,0.0)), 4.0*M_PI), ccsub(cmplx(dirCoeff*jn[i*(order+1)+n], 0.0),
-                                         cmplx(0.0, (1.0-dirCoeff)*jnprime[i*(order+1)+n]))  );
-            
-            free(jn);
-            free(jnprime);
-            break;
+            b_N[i*(order+1)+n] = cmplx(4.0*M_PI*(i_n[n%4][0]*re - i_n[n%4][1]*im), 4.0*M_PI*(i_n[n%4][0]*im + i_n[n%4][1]*re));
+        }
     }
+    
+    free(NM_j);
+    free(NM_y);
+    free(jn);
+    free(jnprime);
+    free(yn);
+    free(ynprime);
 }
 
 void simulateCylArray /*untested*/
@@ -1727,6 +2357,78 @@ void simulateCylArray /*untested*/
     free(b_NC);
 }
 
+/* Number of plane-wave directions simulated at a time by simulateSphArray() */
+#define SIM_SPH_BLOCK_SIZE ( 64 )
+
+/* A contiguous range of plane-wave directions [srcStart, srcEnd) of a simulateSphArray() call, simulated by one thread */
+typedef struct _simulateSphArray_job {
+    int order;
+    int nBands;
+    double* b_N_ri;
+    float* U_sensors;
+    int N_sensors;
+    float* U_srcs;
+    int N_srcs;
+    int srcStart;
+    int srcEnd;
+    float_complex* H_array;
+} simulateSphArray_job;
+
+static void simulateSphArray_run(void* arg)
+{
+    int i, j, n, band, src0, nBlk, nCol, order, nBands, N_sensors, N_srcs;
+    float cosangle;
+    double* x, *P, *H_ri;
+    simulateSphArray_job* job = (simulateSphArray_job*)arg;
+    
+    order = job->order;
+    nBands = job->nBands;
+    N_sensors = job->N_sensors;
+    N_srcs = job->N_srcs;
+    
+    /* Compute angular-dependent part of the array responses, for a block of plane waves at a time */
+    x = malloc(N_sensors*SIM_SPH_BLOCK_SIZE*sizeof(double));
+    P = malloc((order+1)*N_sensors*SIM_SPH_BLOCK_SIZE*sizeof(double));
+    H_ri = malloc(2*nBands*N_sensors*SIM_SPH_BLOCK_SIZE*sizeof(double));
+    for(src0=job->srcStart; src0<job->srcEnd; src0+=SIM_SPH_BLOCK_SIZE){
+        nBlk = MIN(SIM_SPH_BLOCK_SIZE, job->srcEnd-src0);
+        nCol = N_sensors*nBlk;
+        
+        /* cosine of the angle between each sensor and plane wave; column j*nBlk+i */
+        for(j=0; j<N_sensors; j++){
+            for(i=0; i<nBlk; i++){
+                utility_svvdot((const float*)&(job->U_sensors[j*3]), (const float*)&(job->U_srcs[(src0+i)*3]), 3, &cosangle);
+                x[j*nBlk+i] = (double)cosangle;
+            }
+        }
+        
+        /* Legendre polynomials correspond to the angular dependency; all orders are obtained from the one (Bonnet)
+         * recursion: n*P_n(x) = (2n-1)*x*P_{n-1}(x) - (n-1)*P_{n-2}(x) */
+        for(i=0; i<nCol; i++)
+            P[i] = 1.0;
+        if(order>0)
+            memcpy(&P[nCol], x, nCol*sizeof(double));
+        for(n=2; n<order+1; n++)
+            for(i=0; i<nCol; i++)
+                P[n*nCol+i] = ((2.0*(double)n-1.0)*x[i]*P[(n-1)*nCol+i] - ((double)n-1.0)*P[(n-2)*nCol+i])/(double)n;
+        cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, 2*nBands, nCol, order+1, 1.0,
+                    job->b_N_ri, order+1,
+                    P, nCol, 0.0,
+                    H_ri, nCol);
+        
+        /* store array response per frequency, sensors and plane wave dirs */
+        for(band=0; band<nBands; band++)
+            for(j=0; j<N_sensors; j++)
+                for(i=0; i<nBlk; i++)
+                    job->H_array[band*N_sensors*N_srcs + j*N_srcs + src0+i] = cmplxf((float)H_ri[band*nCol + j*nBlk+i],
+                                                                                     (float)H_ri[(nBands+band)*nCol + j*nBlk+i]);
+    }
+    
+    free(x);
+    free(P);
+    free(H_ri);
+}
+
 void simulateSphArray
 (
     int order,
@@ -1738,21 +2440,33 @@ void simulateSphArray
     int N_srcs,
     ARRAY_CONSTRUCTION_TYPES arrayType,
     double dirCoeff,
+    int nThreads,
     float_complex* H_array
 )
 {
-    int i, j, n, band;
-    double dcosangle;
-    double *ppm;
-    float cosangle;
+    int i, n, t, band, nBlocks, nBlocksPerThread;
     float* U_sensors, *U_srcs;
-    double_complex* b_N, *P, *b_NP;
-    const double_complex calpha = cmplx(1.0, 0.0), cbeta = cmplx(0.0, 0.0);
+    double* b_N_ri;
+    double_complex* b_N;
+    simulateSphArray_job* jobs;
+    
+    if(N_srcs<=0)
+        return;
     
     /* calculate modal coefficients */
     b_N = malloc(nBands * (order+1) * sizeof(double_complex));
     sphModalCoeffs(order, kr, nBands, arrayType, dirCoeff, b_N); /* double precision recommended for high orders of sph Bessels  */
     
+    /* since the angular-dependent part is real, the real and imaginary parts of the modal coefficients are stacked
+     * and weighted by (2n+1)/(4pi), so that a single real matrix multiplication yields both; FLAT: 2nBands x (order+1) */
+    b_N_ri = malloc(2*nBands*(order+1)*sizeof(double));
+    for(band=0; band<nBands; band++){
+        for(n=0; n<order+1; n++){
+            b_N_ri[band*(order+1)+n] = (2.0*(double)n+1.0)/(4.0*M_PI) * creal(b_N[band*(order+1)+n]);
+            b_N_ri[(nBands+band)*(order+1)+n] = (2.0*(double)n+1.0)/(4.0*M_PI) * cimag(b_N[band*(order+1)+n]);
+        }
+    }
+    
     /* calculate (unit) cartesian coords for sensors and plane waves */
     U_sensors = malloc(N_sensors*3*sizeof(float));
     U_srcs = malloc(N_srcs*3*sizeof(float));
@@ -1761,37 +2475,31 @@ void simulateSphArray
     for(i=0; i<N_srcs; i++)
         unitSph2Cart(src_dirs_deg[i*2]*M_PI/180.0f, src_dirs_deg[i*2+1]*M_PI/180.0f, (float*)&U_srcs[i*3]);
     
-    /* Compute angular-dependent part of the array responses */
-    ppm = malloc((order+1)*sizeof(double));
-    P = malloc((order+1)*N_sensors*sizeof(double_complex));
-    b_NP = malloc(nBands*N_sensors*sizeof(double_complex));
-    for(i=0; i<N_srcs; i++){
-        for(j=0; j<N_sensors; j++){
-            utility_svvdot((const float*)&U_sensors[j*3], (const float*)&U_srcs[i*3], 3, &cosangle);
-            for(n=0; n<order+1; n++){
-                /* Legendre polynomials correspond to the angular dependency */
-                dcosangle = (double)cosangle;
-                unnorm_legendreP(n, &dcosangle, 1, ppm);
-                P[n*N_sensors+j] = cmplx((2.0*(double)n+1.0)/(4.0*M_PI) * ppm[0], 0.0);
-            }
-        }
-        cblas_zgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, nBands, N_sensors, order+1, &calpha,
-                    b_N, order+1,
-                    P, N_sensors, &cbeta,
-                    b_NP, N_sensors);
-        
-        /* store array response per frequency, sensors and plane wave dirs */
-        for(band=0; band<nBands; band++)
-            for(j=0; j<N_sensors; j++)
-                H_array[band*N_sensors*N_srcs + j*N_srcs + i] = cmplxf((float)creal(b_NP[band*N_sensors+j]), (float)cimag(b_NP[band*N_sensors+j]));
+    /* split the plane waves into contiguous ranges of whole blocks, one per thread */
+    nBlocks = (N_srcs + SIM_SPH_BLOCK_SIZE - 1)/SIM_SPH_BLOCK_SIZE;
+    nThreads = getNumThreads(nThreads, nBlocks);
+    nBlocksPerThread = (nBlocks + nThreads - 1)/nThreads;
+    nThreads = (nBlocks + nBlocksPerThread - 1)/nBlocksPerThread;
+    jobs = malloc(nThreads*sizeof(simulateSphArray_job));
+    for(t=0; t<nThreads; t++){
+        jobs[t].order = order;
+        jobs[t].nBands = nBands;
+        jobs[t].b_N_ri = b_N_ri;
+        jobs[t].U_sensors = U_sensors;
+        jobs[t].N_sensors = N_sensors;
+        jobs[t].U_srcs = U_srcs;
+        jobs[t].N_srcs = N_srcs;
+        jobs[t].srcStart = t*nBlocksPerThread*SIM_SPH_BLOCK_SIZE;
+        jobs[t].srcEnd = MIN((t+1)*nBlocksPerThread*SIM_SPH_BLOCK_SIZE, N_srcs);
+        jobs[t].H_array = H_array;
     }
+    runJobsInParallel(simulateSphArray_run, (void*)jobs, sizeof(simulateSphArray_job), nThreads);
     
+    free(jobs);
     free(U_sensors);
     free(U_srcs);
     free(b_N);
-    free(ppm);
-    free(P);
-    free(b_NP);
+    free(b_N_ri);
 }
 
 void evaluateSHTfilters
@@ -1814,7 +2522,7 @@ void evaluateSHTfilters
     const float_complex calpha = cmplxf(1.0f, 0.0f), cbeta = cmplxf(0.0f, 0.0f);
     float w_uni_grid, lSH_n, lSH_nm;
     float_complex cSH_n, cSH_nm, yre_yre_dot, yre_yid_dot;
-    float_complex *y_recon_kk, *y_recon_nm, *w_y_recon_nm, *y_ideal_nm, *MH_M, *EigV;
+    float_complex *y_recon_kk, *y_recon_nm, *w_y_recon_nm, *y_ideal_nm, *MH_M;
     
     nSH = (order+1)*(order+1);
     w_uni_grid = 1.0f/(float)nDirs;
@@ -1823,7 +2531,6 @@ void evaluateSHTfilters
     w_y_recon_nm = malloc(nDirs*sizeof(float_complex));
     y_ideal_nm = malloc(nDirs*sizeof(float_complex));
     MH_M = malloc(nSensors*nSensors*sizeof(float_complex));
-    EigV = malloc(nSensors*nSensors*sizeof(float_complex));
     for(band=0; band<nBands; band++){
         cblas_cgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, nSH, nDirs, nSensors, &calpha,
                     &M_array2SH[band*nSH*nSensors], nSensors,
@@ -1853,13 +2560,14 @@ void evaluateSHTfilters
     
 #if 0
     /* find maximum noise amplification of all filters in matrix */
+    float maxEigV;
     for(band=0; band<nBands; band++){
         cblas_cgemm(CblasRowMajor, CblasConjTrans, CblasNoTrans, nSensors, nSensors, nSH, &calpha,
                     &M_array2SH[band*nSH*nSensors], nSensors,
                     &M_array2SH[band*nSH*nSensors], nSensors, &cbeta,
                     MH_M, nSensors);
-        utility_ceig(MH_M, nSensors, 1, NULL, NULL, EigV); /* eigenvalues in decending order */
-        WNG[band] = 10.0f*log10f(crealf(EigV[0])+2.23e-9f);
+        utility_cheig(MH_M, nSensors, 1, 0, 0, NULL, &maxEigV); /* only the largest eigenvalue is needed */
+        WNG[band] = 10.0f*log10f(maxEigV+2.23e-9f);
     }
 #endif
     
@@ -1868,7 +2576,6 @@ void evaluateSHTfilters
     free(w_y_recon_nm);
     free(y_ideal_nm);
     free(MH_M);
-    free(EigV);
 }
 
 
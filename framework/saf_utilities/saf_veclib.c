@@ -20,9 +20,8 @@
  *     complex number wrappers. Optimised linear algebra routines utilising BLAS and LAPACK
  *     are also included.
  * Dependencies:
- *     Windows users only: Intel's MKL must be installed, which can be freely aquired via:
- *     https://software.intel.com/en-us/articles/free-ipsxe-tools-and-libraries
- *     Mac users only: saf_utilities will utilise Apple's Accelerate library.
+ *     A performance library comprising CBLAS and LAPACK routines is required. Refer to
+ *     saf_veclib.h for the supported libraries and how to select them.
  * Author, date created:
  *     Leo McCormack, 11.07.2016
  */
@@ -94,27 +93,19 @@ static void sortf
 
 void utility_svvcopy(const float* a, const int len, float* c)
 {
-#if defined(__ACCELERATE__) || defined(INTEL_MKL_VERSION)
     cblas_scopy(len, a, 1, c, 1);
-#else
-    memcpy(c, a, len*sizeof(float));
-#endif
 }
 
 void utility_cvvcopy(const float_complex* a, const int len, float_complex* c)
 {
-#if defined(__ACCELERATE__) || defined(INTEL_MKL_VERSION)
     cblas_ccopy(len, a, 1, c, 1);
-#else
-    memcpy(c, a, len*sizeof(float_complex));
-#endif
 }
 
 /*------------------------- vector-vector multiplication (?vvmul) ---------------------------*/
 
 void utility_svvmul(float* a, const float* b, const int len, float* c)
 {
-#ifdef __ACCELERATE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     if(c==NULL){
         float* tmp;
         tmp=malloc(len*sizeof(float));
@@ -124,12 +115,15 @@ void utility_svvmul(float* a, const float* b, const int len, float* c)
     }
     else
         vDSP_vmul(a, 1, b, 1, c, 1, len);
-#elif INTEL_MKL_VERSION
-	vsMul(len, a, b, c);
+#elif defined(SAF_USE_INTEL_MKL)
+    vsMul(len, a, b, c==NULL ? a : c);
 #else
-	int i;
-	for (i = 0; i < len; i++)
-		c[i] = a[i] * b[i];
+    int i;
+    if(c==NULL){
+        c = a;
+    }
+    for (i = 0; i < len; i++)
+        c[i] = a[i] * b[i];
 #endif
 }
 
@@ -137,19 +131,11 @@ void utility_svvmul(float* a, const float* b, const int len, float* c)
 
 void utility_svvdot(const float* a, const float* b, const int len, float* c)
 {
-#if defined(__ACCELERATE__) || defined(INTEL_MKL_VERSION)
     c[0] = cblas_sdot (len, a, 1, b, 1);
-#else
-    int i;
-    c[0] = 0.0f;
-    for(i=0; i<len; i++)
-        c[0] += a[i] * b[i];
-#endif
 }
 
 void utility_cvvdot(const float_complex* a, const float_complex* b, const int len, CONJ_FLAG flag, float_complex* c)
 {
-#if defined(__ACCELERATE__) || defined(INTEL_MKL_VERSION)
     switch(flag){
         default:
         case NO_CONJ:
@@ -159,49 +145,29 @@ void utility_cvvdot(const float_complex* a, const float_complex* b, const int le
             cblas_cdotc_sub(len, a, 1, b, 1, c);
             break;
     }
-#else
-    int i;
-    c[0] = cmplxf(0.0f,0.0f);
-    switch(flag){
-        default:
-        case NO_CONJ:
-            for(i=0; i<len; i++)
-                c[0] = ccaddf(c[0], ccmulf(a[i], b[i]));
-            break;
-        case CONJ:
-            for(i=0; i<len; i++)
-                c[0] = ccaddf(c[0], ccmulf(conjf(a[i]), b[i]));
-            break;
-    }
-#endif
 }
 
 /*------------------------------ vector-scalar product (?vsmul) -----------------------------*/
 
 void utility_svsmul(float* a, const float* s, const int len, float* c)
 {
-#ifdef __ACCELERATE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     if(c==NULL)
         cblas_sscal(len, s[0], a, 1);
     else
         vDSP_vsmul(a, 1, s, c, 1, len);
-#elif INTEL_MKL_VERSION
+#else
 	if (c == NULL)
 		cblas_sscal(len, s[0], a, 1);
 	else {
 		memcpy(c, a, len*sizeof(float));
 		cblas_sscal(len, s[0], c, 1);
 	}
-#else
-    int i;
-    for(i=0; i<len; i++)
-        c[i] = a[i] * s[0];
 #endif
 }
 
 void utility_cvsmul(float_complex* a, const float_complex* s, const int len, float_complex* c)
 {
-#if defined(__ACCELERATE__) || defined(INTEL_MKL_VERSION)
 	if (c == NULL)
 		cblas_cscal(len, s, a, 1);
 	else {
@@ -209,11 +175,6 @@ void utility_cvsmul(float_complex* a, const float_complex* s, const int len, flo
 		for (i = 0; i<len; i++)
 			c[i] = ccmulf(a[i], s[0]);
 	}
-#else
-    int i;
-    for(i=0; i<len; i++)
-        c[i] = ccmulf(a[i], s[0]);
-#endif
 }
 
 /*----------------------------- vector-scalar division (?vsdiv) -----------------------------*/
@@ -224,7 +185,7 @@ void utility_svsdiv(float* a, const float* s, const int len, float* c)
         memset(c, 0, len*sizeof(float));
         return;
     }
-#ifdef __ACCELERATE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     vDSP_vsdiv(a, 1, s, c, 1, len);
 #else
     int i;
@@ -237,7 +198,7 @@ void utility_svsdiv(float* a, const float* s, const int len, float* c)
 
 void utility_svsadd(float* a, const float* s, const int len, float* c)
 {
-#ifdef __ACCELERATE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     vDSP_vsadd(a, 1, s, c, 1, len);
 #else
     int i;
@@ -273,12 +234,20 @@ void utility_ssvd(const float* A, const int dim1, const int dim2, float** U, flo
         for(j=0; j<dim2; j++)
             a[j*dim1+i] = A[i*dim2 +j];
     lwork = -1;
+#if defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_sgesvd_work(LAPACK_COL_MAJOR, 'A', 'A', m, n, a, lda, s, u, ldu, vt, ldvt, &wkopt, lwork);
+#else
     sgesvd_( "A", "A", &m, &n, a, &lda, s, u, &ldu, vt, &ldvt, &wkopt, &lwork,
            &info );
+#endif
     lwork = (int)wkopt;
     work = (float*)malloc( lwork*sizeof(float) );
+#if defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_sgesvd_work(LAPACK_COL_MAJOR, 'A', 'A', m, n, a, lda, s, u, ldu, vt, ldvt, work, lwork);
+#else
     sgesvd_( "A", "A", &m, &n, a, &lda, s, u, &ldu, vt, &ldvt, work, &lwork,
            &info );
+#endif
     free(*U);
     free(*S);
     free(*V);
@@ -331,10 +300,18 @@ void utility_sseig(const float* A, const int dim, int sortDecFLAG, float* V, flo
     
     /* solve the eigenproblem */
     lwork = -1;
+#if defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_ssyev_work(LAPACK_COL_MAJOR, 'V', 'U', n, a, lda, w, &wkopt, lwork);
+#else
     ssyev_( "Vectors", "Upper", &n, a, &lda, w, &wkopt, &lwork, &info );
+#endif
     lwork = (int)wkopt;
     work = (float*)malloc( lwork*sizeof(float) );
+#if defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_ssyev_work(LAPACK_COL_MAJOR, 'V', 'U', n, a, lda, w, work, lwork);
+#else
     ssyev_( "Vectors", "Upper", &n, a, &lda, w, work, &lwork, &info );
+#endif
 
     /* output */
     memset(D, 0, dim*dim*sizeof(float));
@@ -364,6 +341,95 @@ void utility_sseig(const float* A, const int dim, int sortDecFLAG, float* V, flo
     free(work);
 }
 
+/*----------------------- Hermitian eigenvalue decomposition (?heig) -----------------------*/
+
+void utility_cheig(const float_complex* A, const int dim, int sortDecFLAG, int first, int last, float_complex* V, float* D)
+{
+    int i, k, n, lda, ldz, il, iu, m, info, lwork, lrwork, liwork, iwkopt, nEig;
+    int* isuppz, *iwork;
+    float vl, vu, abstol, rwkopt;
+    float* w, *rwork;
+    float_complex wkopt;
+    float_complex* a, *z, *work;
+    char jobz;
+    
+    nEig = last-first+1;
+    n = lda = ldz = dim;
+    jobz = V==NULL ? 'N' : 'V';
+    vl = vu = 0.0f;   /* not referenced, since the eigenvalues are selected by index */
+    abstol = 0.0f;    /* default tolerance */
+    m = 0;
+    a = malloc(dim*dim*sizeof(float_complex));
+    w = malloc(dim*sizeof(float));
+    z = malloc(dim*nEig*sizeof(float_complex));
+    isuppz = malloc(2*dim*sizeof(int));
+    
+    /* the row-major Hermitian A is conj(A) in column-major order, which has the same eigenvalues, and the conjugates
+     * of the eigenvectors of A. Therefore, no transpose is required */
+    memcpy(a, A, dim*dim*sizeof(float_complex));
+    
+    /* indices of the requested eigenvalues (1-based, and in ascending order) */
+    il = sortDecFLAG ? dim-last : first+1;
+    iu = sortDecFLAG ? dim-first : last+1;
+    
+    /* solve the eigenproblem */
+    lwork = lrwork = liwork = -1;
+#if defined(SAF_USE_APPLE_ACCELERATE)
+    cheevr_( &jobz, "I", "U", &n, (__CLPK_complex*)a, &lda, &vl, &vu, &il, &iu, &abstol, &m, w, (__CLPK_complex*)z, &ldz,
+            isuppz, (__CLPK_complex*)&wkopt, &lwork, &rwkopt, &lrwork, &iwkopt, &liwork, &info );
+#elif defined(SAF_USE_INTEL_MKL)
+    cheevr_( &jobz, "I", "U", &n, (MKL_Complex8*)a, &lda, &vl, &vu, &il, &iu, &abstol, &m, w, (MKL_Complex8*)z, &ldz,
+            isuppz, (MKL_Complex8*)&wkopt, &lwork, &rwkopt, &lrwork, &iwkopt, &liwork, &info );
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_cheevr_work(LAPACK_COL_MAJOR, jobz, 'I', 'U', n, (lapack_complex_float*)a, lda, vl, vu, il, iu, abstol, &m, w,
+                               (lapack_complex_float*)z, ldz, isuppz, (lapack_complex_float*)&wkopt, lwork, &rwkopt, lrwork, &iwkopt, liwork);
+#endif
+    lwork = (int)crealf(wkopt);
+    lrwork = (int)rwkopt;
+    liwork = iwkopt;
+    work = malloc(lwork*sizeof(float_complex));
+    rwork = malloc(lrwork*sizeof(float));
+    iwork = malloc(liwork*sizeof(int));
+#if defined(SAF_USE_APPLE_ACCELERATE)
+    cheevr_( &jobz, "I", "U", &n, (__CLPK_complex*)a, &lda, &vl, &vu, &il, &iu, &abstol, &m, w, (__CLPK_complex*)z, &ldz,
+            isuppz, (__CLPK_complex*)work, &lwork, rwork, &lrwork, iwork, &liwork, &info );
+#elif defined(SAF_USE_INTEL_MKL)
+    cheevr_( &jobz, "I", "U", &n, (MKL_Complex8*)a, &lda, &vl, &vu, &il, &iu, &abstol, &m, w, (MKL_Complex8*)z, &ldz,
+            isuppz, (MKL_Complex8*)work, &lwork, rwork, &lrwork, iwork, &liwork, &info );
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_cheevr_work(LAPACK_COL_MAJOR, jobz, 'I', 'U', n, (lapack_complex_float*)a, lda, vl, vu, il, iu, abstol, &m, w,
+                               (lapack_complex_float*)z, ldz, isuppz, (lapack_complex_float*)work, lwork, rwork, lrwork, iwork, liwork);
+#endif
+    
+    /* output */
+    if( info != 0 || m != nEig ) {
+        /* failed to converge and find the eigenvalues */
+        if(V!=NULL)
+            memset(V, 0, dim*nEig*sizeof(float_complex));
+        if(D!=NULL)
+            memset(D, 0, nEig*sizeof(float));
+    }
+    else{
+        for(k=0; k<nEig; k++){
+            /* LAPACK returns them in ascending order */
+            il = sortDecFLAG ? nEig-k-1 : k;
+            if(V!=NULL)
+                for(i=0; i<dim; i++)
+                    V[i*nEig+k] = conjf(z[il*dim+i]); /* back to row-major, and the eigenvectors of A */
+            if(D!=NULL)
+                D[k] = w[il];
+        }
+    }
+    
+    free(a);
+    free(w);
+    free(z);
+    free(isuppz);
+    free(work);
+    free(rwork);
+    free(iwork);
+}
+
 /*-----------------------------  eigenvalue decomposition (?eig) ----------------------------*/
 
 void utility_ceig(const float_complex* A, const int dim, int sortDecFLAG, float_complex* VL, float_complex* VR, float_complex* D)
@@ -387,19 +453,25 @@ void utility_ceig(const float_complex* A, const int dim, int sortDecFLAG, float_
     
     /* solve the eigenproblem */
     lwork = -1;
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     cgeev_( "Vectors", "Vectors", &n, (__CLPK_complex*)a, &lda, (__CLPK_complex*)w, (__CLPK_complex*)vl,
            &ldvl, (__CLPK_complex*)vr, &ldvr, (__CLPK_complex*)&wkopt, &lwork, rwork, &info );
-#elif INTEL_MKL_VERSION
+#elif defined(SAF_USE_INTEL_MKL)
     cgeev_( "Vectors", "Vectors", &n, (MKL_Complex8*)a, &lda, (MKL_Complex8*)w, (MKL_Complex8*)vl, &ldvl, (MKL_Complex8*)vr, &ldvr, (MKL_Complex8*)&wkopt, &lwork, rwork, &info );
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_cgeev_work(LAPACK_COL_MAJOR, 'V', 'V', n, (lapack_complex_float*)a, lda, (lapack_complex_float*)w, (lapack_complex_float*)vl,
+                              ldvl, (lapack_complex_float*)vr, ldvr, (lapack_complex_float*)&wkopt, lwork, rwork);
 #endif
     lwork = (int)crealf(wkopt);
     work = (float_complex*)malloc( lwork*sizeof(float_complex) );
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     cgeev_( "Vectors", "Vectors", &n, (__CLPK_complex*)a, &lda, (__CLPK_complex*)w, (__CLPK_complex*)vl,
            &ldvl, (__CLPK_complex*)vr, &ldvr, (__CLPK_complex*)work, &lwork, rwork, &info );
-#elif INTEL_MKL_VERSION
+#elif defined(SAF_USE_INTEL_MKL)
     cgeev_( "Vectors", "Vectors", &n, (MKL_Complex8*)a, &lda, (MKL_Complex8*)w, (MKL_Complex8*)vl, &ldvl, (MKL_Complex8*)vr, &ldvr, (MKL_Complex8*)work, &lwork, rwork, &info );
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_cgeev_work(LAPACK_COL_MAJOR, 'V', 'V', n, (lapack_complex_float*)a, lda, (lapack_complex_float*)w, (lapack_complex_float*)vl,
+                              ldvl, (lapack_complex_float*)vr, ldvr, (lapack_complex_float*)work, lwork, rwork);
 #endif
     
     /* sort the eigenvalues */
@@ -464,7 +536,11 @@ void utility_sglslv(const float* A, const int dim, float* B, int nCol, float* X)
             b[j*dim+i] = B[i*nCol+j];
     
     /* solve Ax = b for each column in b (b is replaced by the solution: x) */
+#if defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_sgesv_work(LAPACK_COL_MAJOR, n, nrhs, a, lda, IPIV, b, ldb);
+#else
     sgesv_( &n, &nrhs, a, &lda, IPIV, b, &ldb, &info );
+#endif
     
     if(info>0){
         /* A is singular, solution not possible */
@@ -500,10 +576,12 @@ void utility_cglslv(const float_complex* A, const int dim, float_complex* B, int
             b[j*dim+i] = B[i*nCol+j];
     
     /* solve Ax = b for each column in b (b is replaced by the solution: x) */
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     cgesv_( &n, &nrhs, (__CLPK_complex*)a, &lda, IPIV, (__CLPK_complex*)b, &ldb, &info );
-#elif INTEL_MKL_VERSION
+#elif defined(SAF_USE_INTEL_MKL)
     cgesv_( &n, &nrhs, (MKL_Complex8*)a, &lda, IPIV, (MKL_Complex8*)b, &ldb, &info );
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_cgesv_work(LAPACK_COL_MAJOR, n, nrhs, (lapack_complex_float*)a, lda, IPIV, (lapack_complex_float*)b, ldb);
 #endif
     
     if(info>0){
@@ -540,7 +618,11 @@ void utility_sslslv(const float* A, const int dim, float* B, int nCol, float* X)
             b[j*dim+i] = B[i*nCol+j];
     
     /* solve Ax = b for each column in b (b is replaced by the solution: x) */
+#if defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_sposv_work(LAPACK_COL_MAJOR, 'U', n, nrhs, a, lda, b, ldb);
+#else
     sposv_( "U", &n, &nrhs, a, &lda, b, &ldb, &info );
+#endif
     
     if(info>0){
         /* A is not positive definate, solution not possible */
@@ -573,10 +655,12 @@ void utility_cslslv(const float_complex* A, const int dim, float_complex* B, int
             b[j*dim+i] = B[i*nCol+j];
     
     /* solve Ax = b for each column in b (b is replaced by the solution: x) */
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     cposv_( "U", &n, &nrhs, (__CLPK_complex*)a, &lda, (__CLPK_complex*)b, &ldb, &info );
-#elif INTEL_MKL_VERSION
+#elif defined(SAF_USE_INTEL_MKL)
     cposv_( "U", &n, &nrhs, (MKL_Complex8*)a, &lda, (MKL_Complex8*)b, &ldb, &info );
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_cposv_work(LAPACK_COL_MAJOR, 'U', n, nrhs, (lapack_complex_float*)a, lda, (lapack_complex_float*)b, ldb);
 #endif
     
     if(info>0){
@@ -594,7 +678,52 @@ void utility_cslslv(const float_complex* A, const int dim, float_complex* B, int
     free(b);
 }
 
+/*--------------------------- Cholesky factorisation and solver (?chol) ---------------------*/
+
+void utility_cchol(const float_complex* A, const int dim, float_complex* U)
+{
+    int i, n = dim, lda = dim, info;
+    
+    if(U!=A)
+        memcpy(U, A, dim*dim*sizeof(float_complex));
+    
+    /* the row-major Hermitian A is conj(A) in column-major order, so its lower factor (conj(A) = L*L^H) is, when read
+     * in row-major order, the upper factor U = L^T for which A = U^H*U. Therefore, no transposes are required */
+#if defined(SAF_USE_APPLE_ACCELERATE)
+    cpotrf_( "L", &n, (__CLPK_complex*)U, &lda, &info );
+#elif defined(SAF_USE_INTEL_MKL)
+    cpotrf_( "L", &n, (MKL_Complex8*)U, &lda, &info );
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_cpotrf_work(LAPACK_COL_MAJOR, 'L', n, (lapack_complex_float*)U, lda);
+#endif
+    
+    if(info!=0){
+        /* A is not positive definate, factorisation not possible */
+        memset(U, 0, dim*dim*sizeof(float_complex));
+    }
+    else{
+        /* the part below the diagonal is not referenced by the factorisation */
+        for(i=1; i<dim; i++)
+            memset(&U[i*dim], 0, i*sizeof(float_complex));
+    }
+}
 
+void utility_ccholslv(const float_complex* U, const int dim, float_complex* B, int nCol, float_complex* X)
+{
+    const float_complex calpha = cmplxf(1.0f, 0.0f);
+    
+    if(crealf(U[0]) <= 0.0f){
+        /* the factorisation failed, solution not possible */
+        memset(X, 0, dim*nCol*sizeof(float_complex));
+        return;
+    }
+    if(X!=B)
+        memcpy(X, B, dim*nCol*sizeof(float_complex));
+    
+    /* A*X = U^H*(U*X) = B; solve U^H*Z = B, followed by U*X = Z (both in place) */
+    cblas_ctrsm(CblasRowMajor, CblasLeft, CblasUpper, CblasConjTrans, CblasNonUnit, dim, nCol, &calpha, U, dim, X, nCol);
+    cblas_ctrsm(CblasRowMajor, CblasLeft, CblasUpper, CblasNoTrans, CblasNonUnit, dim, nCol, &calpha, U, dim, X, nCol);
+}
 
 /*----------------------------- matrix pseudo-inverse (?pinv) -------------------------------*/
 
@@ -616,20 +745,24 @@ void utility_spinv(const float* inM, const int dim1, const int dim2, float* outM
     u = (float*)malloc(ldu*k*sizeof(float));
     vt = (float*)malloc(ldvt*n*sizeof(float));
     lwork = -1;
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     sgesvd_("S", "S", (__CLPK_integer*)&m, (__CLPK_integer*)&n, a, (__CLPK_integer*)&lda,
             s, u, (__CLPK_integer*)&ldu, vt, (__CLPK_integer*)&ldvt, &wkopt, (__CLPK_integer*)&lwork, (__CLPK_integer*)&info);
-#else
+#elif defined(SAF_USE_INTEL_MKL)
     sgesvd_("S", "S", &m, &n, a, &lda, s, u, &ldu, vt, &ldvt, &wkopt, &lwork, &info);
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_sgesvd_work(LAPACK_COL_MAJOR, 'S', 'S', m, n, a, lda, s, u, ldu, vt, ldvt, &wkopt, lwork);
 #endif
     lwork = (int)wkopt;
     work = (float*)malloc(lwork*sizeof(float));
     
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     sgesvd_("S", "S", (__CLPK_integer*)&m, (__CLPK_integer*)&n, a, (__CLPK_integer*)&lda,
             s, u, (__CLPK_integer*)&ldu, vt, (__CLPK_integer*)&ldvt, work, (__CLPK_integer*) &lwork, (__CLPK_integer*)&info); /* Compute SVD */
-#else
+#elif defined(SAF_USE_INTEL_MKL)
     sgesvd_("S", "S", &m, &n, a, &lda, s, u, &ldu, vt, &ldvt, work, &lwork, &info ); /* Compute SVD */
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_sgesvd_work(LAPACK_COL_MAJOR, 'S', 'S', m, n, a, lda, s, u, ldu, vt, ldvt, work, lwork); /* Compute SVD */
 #endif
     if( info > 0 ) {
         memset(outM, 0, dim1*dim2*sizeof(float));
@@ -685,20 +818,24 @@ void utility_dpinv(const double* inM, const int dim1, const int dim2, double* ou
     u = (double*)malloc(ldu*k*sizeof(double));
     vt = (double*)malloc(ldvt*n*sizeof(double));
     lwork = -1;
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     dgesvd_("S", "S", (__CLPK_integer*)&m, (__CLPK_integer*)&n, a, (__CLPK_integer*)&lda,
             s, u, (__CLPK_integer*)&ldu, vt, (__CLPK_integer*)&ldvt, &wkopt, (__CLPK_integer*)&lwork, (__CLPK_integer*)&info);
-#else
+#elif defined(SAF_USE_INTEL_MKL)
     dgesvd_("S", "S", &m, &n, a, &lda, s, u, &ldu, vt, &ldvt, &wkopt, &lwork, &info);
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_dgesvd_work(LAPACK_COL_MAJOR, 'S', 'S', m, n, a, lda, s, u, ldu, vt, ldvt, &wkopt, lwork);
 #endif
     lwork = (int)wkopt;
     work = (double*)malloc(lwork*sizeof(double));
     
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     dgesvd_("S", "S", (__CLPK_integer*)&m, (__CLPK_integer*)&n, a, (__CLPK_integer*)&lda,
             s, u, (__CLPK_integer*)&ldu, vt, (__CLPK_integer*)&ldvt, work, (__CLPK_integer*) &lwork, (__CLPK_integer*)&info); /* Compute SVD */
-#else
+#elif defined(SAF_USE_INTEL_MKL)
     dgesvd_("S", "S", &m, &n, a, &lda, s, u, &ldu, vt, &ldvt, work, &lwork, &info ); /* Compute SVD */
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    info = LAPACKE_dgesvd_work(LAPACK_COL_MAJOR, 'S', 'S', m, n, a, lda, s, u, ldu, vt, ldvt, work, lwork); /* Compute SVD */
 #endif
     if( info > 0 ) {
         memset(outM, 0, dim1*dim2*sizeof(float));
@@ -748,14 +885,25 @@ void utility_sinv(float * A, const int N)
     WORK = (float*)malloc(LWORK * sizeof(float));
     int INFO;
     
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     sgetrf_((__CLPK_integer*)&N, (__CLPK_integer*)&N, A, (__CLPK_integer*)&N, (__CLPK_integer*)IPIV, (__CLPK_integer*)&INFO);
-    sgetri_((__CLPK_integer*)&N, A, (__CLPK_integer*)&N, (__CLPK_integer*)IPIV, WORK, (__CLPK_integer*)&LWORK, (__CLPK_integer*)&INFO);
-#elif INTEL_MKL_VERSION
+    if(INFO==0)
+        sgetri_((__CLPK_integer*)&N, A, (__CLPK_integer*)&N, (__CLPK_integer*)IPIV, WORK, (__CLPK_integer*)&LWORK, (__CLPK_integer*)&INFO);
+#elif defined(SAF_USE_INTEL_MKL)
     sgetrf_(&N, &N, A, &N, IPIV, &INFO);
-    sgetri_(&N, A, &N, IPIV, WORK, &LWORK, &INFO);
+    if(INFO==0)
+        sgetri_(&N, A, &N, IPIV, WORK, &LWORK, &INFO);
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    INFO = LAPACKE_sgetrf_work(LAPACK_COL_MAJOR, N, N, A, N, IPIV);
+    if(INFO==0)
+        INFO = LAPACKE_sgetri_work(LAPACK_COL_MAJOR, N, A, N, IPIV, WORK, LWORK);
 #endif
     
+    if(INFO!=0){
+        /* A is singular, inversion not possible */
+        memset(A, 0, N*N*sizeof(float));
+    }
+    
     free(IPIV);
     free(WORK);
 }
@@ -769,14 +917,25 @@ void utility_dinv(double* A, const int N)
     WORK = malloc( LWORK*sizeof(double));
     int INFO;
     
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     dgetrf_((__CLPK_integer*)&N, (__CLPK_integer*)&N, A, (__CLPK_integer*)&N, (__CLPK_integer*)IPIV, (__CLPK_integer*)&INFO);
-    dgetri_((__CLPK_integer*)&N, A, (__CLPK_integer*)&N, (__CLPK_integer*)IPIV, WORK, (__CLPK_integer*)&LWORK, (__CLPK_integer*)&INFO);
-#elif INTEL_MKL_VERSION
+    if(INFO==0)
+        dgetri_((__CLPK_integer*)&N, A, (__CLPK_integer*)&N, (__CLPK_integer*)IPIV, WORK, (__CLPK_integer*)&LWORK, (__CLPK_integer*)&INFO);
+#elif defined(SAF_USE_INTEL_MKL)
     dgetrf_(&N, &N, A, &N, IPIV, &INFO);
-    dgetri_(&N, A, &N, IPIV, WORK, &LWORK, &INFO);
+    if(INFO==0)
+        dgetri_(&N, A, &N, IPIV, WORK, &LWORK, &INFO);
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    INFO = LAPACKE_dgetrf_work(LAPACK_COL_MAJOR, N, N, A, N, IPIV);
+    if(INFO==0)
+        INFO = LAPACKE_dgetri_work(LAPACK_COL_MAJOR, N, A, N, IPIV, WORK, LWORK);
 #endif
     
+    if(INFO!=0){
+        /* A is singular, inversion not possible */
+        memset(A, 0, N*N*sizeof(double));
+    }
+    
     free((void*)IPIV);
     free((void*)WORK);
 }
@@ -790,14 +949,25 @@ void utility_cinv(float_complex * A, const int N)
     WORK = (float_complex*)malloc(LWORK * sizeof(float_complex));
     int INFO;
     
-#ifdef __APPLE__
+#if defined(SAF_USE_APPLE_ACCELERATE)
     cgetrf_((__CLPK_integer*)&N, (__CLPK_integer*)&N, (__CLPK_complex*)A, (__CLPK_integer*)&N, (__CLPK_integer*)IPIV, (__CLPK_integer*)&INFO);
-    cgetri_((__CLPK_integer*)&N, (__CLPK_complex*)A, (__CLPK_integer*)&N, (__CLPK_integer*)IPIV, (__CLPK_complex*)WORK, (__CLPK_integer*)&LWORK, (__CLPK_integer*)&INFO);
-#elif INTEL_MKL_VERSION
+    if(INFO==0)
+        cgetri_((__CLPK_integer*)&N, (__CLPK_complex*)A, (__CLPK_integer*)&N, (__CLPK_integer*)IPIV, (__CLPK_complex*)WORK, (__CLPK_integer*)&LWORK, (__CLPK_integer*)&INFO);
+#elif defined(SAF_USE_INTEL_MKL)
     cgetrf_(&N, &N, (MKL_Complex8*)A, &N, IPIV, &INFO);
-    cgetri_(&N, (MKL_Complex8*)A, &N, IPIV, (MKL_Complex8*)WORK, &LWORK, &INFO);
+    if(INFO==0)
+        cgetri_(&N, (MKL_Complex8*)A, &N, IPIV, (MKL_Complex8*)WORK, &LWORK, &INFO);
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+    INFO = LAPACKE_cgetrf_work(LAPACK_COL_MAJOR, N, N, (lapack_complex_float*)A, N, IPIV);
+    if(INFO==0)
+        INFO = LAPACKE_cgetri_work(LAPACK_COL_MAJOR, N, (lapack_complex_float*)A, N, IPIV, (lapack_complex_float*)WORK, LWORK);
 #endif
     
+    if(INFO!=0){
+        /* A is singular, inversion not possible */
+        memset(A, 0, N*N*sizeof(float_complex));
+    }
+    
     free(IPIV);
     free(WORK);
 }
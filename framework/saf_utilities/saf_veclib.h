@@ -20,9 +20,14 @@
  *     complex number wrappers. Optimised linear algebra routines utilising BLAS and LAPACK
  *     are also included.
  * Dependencies:
- *     Windows users only: Intel's MKL must be installed, which can be freely aquired via:
- *     https://software.intel.com/en-us/articles/free-ipsxe-tools-and-libraries
- *     Mac users only: saf_utilities will utilise Apple's Accelerate library.
+ *     A performance library comprising CBLAS and LAPACK routines is required. The library
+ *     is selected at compile-time by defining ONE of the following flags:
+ *         SAF_USE_INTEL_MKL             - Intel's MKL, which can be freely aquired via:
+ *             https://software.intel.com/en-us/articles/free-ipsxe-tools-and-libraries
+ *         SAF_USE_OPEN_BLAS_AND_LAPACKE - OpenBLAS and LAPACKE. Any other CBLAS+LAPACKE
+ *             implementation (e.g. the netlib reference libraries) may also be used.
+ *         SAF_USE_APPLE_ACCELERATE      - Apple's Accelerate library (Mac OSX only).
+ *     If no flag is defined, then Accelerate is used for Mac OSX and MKL for other platforms.
  * Author, date created:
  *     Leo McCormack, 11.07.2016
  */
@@ -35,14 +40,26 @@
 #include <stdio.h>
 #include <string.h>
 /* a performance library is required: */
-#ifdef __APPLE__
+#if !defined(SAF_USE_INTEL_MKL) && !defined(SAF_USE_OPEN_BLAS_AND_LAPACKE) && !defined(SAF_USE_APPLE_ACCELERATE)
+  #ifdef __APPLE__
+    #define SAF_USE_APPLE_ACCELERATE
+  #else
+    #define SAF_USE_INTEL_MKL
+  #endif
+#endif
+#if (defined(SAF_USE_INTEL_MKL) + defined(SAF_USE_OPEN_BLAS_AND_LAPACKE) + defined(SAF_USE_APPLE_ACCELERATE)) > 1
+  #error Only one performance library flag may be defined
+#endif
+#if defined(SAF_USE_APPLE_ACCELERATE)
   /* it is highly recommended to use the Accelerate performance library for Mac OSX */
   #include "Accelerate/Accelerate.h"
-#else
-  /* it is highly recommended to use Intel's MKL performance library for Windows.
-   Otherwise, one may replace the BLAS/LAPACK functions with custom functions; i.e
-   rewrite saf_veclib, and the changes will be made throughout the framework. */
-  #include "mkl.h" 
+#elif defined(SAF_USE_INTEL_MKL)
+  /* it is highly recommended to use Intel's MKL performance library for Windows */
+  #include "mkl.h"
+#elif defined(SAF_USE_OPEN_BLAS_AND_LAPACKE)
+  /* OpenBLAS (or any other CBLAS implementation) and LAPACKE, e.g. for Linux */
+  #include "cblas.h"
+  #include "lapacke.h"
 #endif
 #include "saf_complex.h"
 #ifdef CBLAS_H
@@ -154,6 +171,19 @@ void utility_sseig(const float* A,         /* in symmetric square matrix; flat:
                   float* V,                /* Eigen vectors; dim x dim */
                   float* D);               /* Eigen values along the diagonal; dim x dim */
 
+/*----------------------- Hermitian eigenvalue decomposition (?heig) -----------------------*/
+
+/* c, row-major, eigenvalue decomposition of a Hermitian matrix: single precision complex. The eigenvalues are real, and
+ * only those with (sorted) indices first..last (and their eigenvectors) are computed, e.g. first=0, last=dim-1 for
+ * all of them, or only the signal or noise sub-space */
+void utility_cheig(const float_complex* A,  /* in Hermitian square matrix; flat: dim x dim */
+                   const int dim,           /* dimensions for the square matrix, A */
+                   int sortDecFLAG,         /* 1: sort eigen values and vectors in decending order. 0: ascending */
+                   int first,               /* index of the first eigenvalue to compute (after sorting), 0..dim-1 */
+                   int last,                /* index of the last eigenvalue to compute (after sorting), first..dim-1 */
+                   float_complex* V,        /* Eigen vectors (set to NULL if not needed); dim x (last-first+1) */
+                   float* D);               /* Eigen values (set to NULL if not needed); (last-first+1) x 1 */
+
 /*-----------------------------  eigenvalue decomposition (?eig) ----------------------------*/
 
 /* s, row-major, eigenvalue decomposition of a nonsymmetric matrix: single precision complex */
@@ -196,6 +226,23 @@ void utility_cslslv(const float_complex* A,  /* square symmetric positive-defina
                     int nCol,                /* number of columns in right hand side matrix */
                     float_complex* X);       /* the solution; dim x nCol */
 
+/*--------------------------- Cholesky factorisation and solver (?chol) ---------------------*/
+
+/* c, row-major, Cholesky factorisation (A = U^H*U) of a Hermitian positive-definate 'A', so that the factor may be
+ * reused with utility_ccholslv for any number of right hand sides: single precision complex.
+ * U is all zeros if 'A' is not positive-definate. 'A' and 'U' may point to the same memory */
+void utility_cchol(const float_complex* A,   /* square Hermitian positive-definate matrix; flat: dim x dim */
+                   const int dim,            /* dimensions for the square matrix, A */
+                   float_complex* U);        /* upper triangular factor; flat: dim x dim */
+
+/* c, row-major, linear solver (AX=B) using the Cholesky factor of 'A' from utility_cchol: single precision complex.
+ * 'B' and 'X' may point to the same memory */
+void utility_ccholslv(const float_complex* U, /* upper triangular factor of A; flat: dim x dim */
+                      const int dim,          /* dimensions for the square matrix, A */
+                      float_complex* B,       /* right hand side matrix; flat: dim x nCol */
+                      int nCol,               /* number of columns in right hand side matrix */
+                      float_complex* X);      /* the solution; dim x nCol */
+
 /*------------------------------- matrix pseudo-inverse (?pinv) -----------------------------*/
 
 /* s, row-major, general matrix pseudo-inverse (the svd way): single precision */
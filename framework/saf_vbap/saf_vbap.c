@@ -126,7 +126,7 @@ void generateVBAPgainTable3D_srcs
         if(needDummy[0] || needDummy[1]){
             /* remove the gains for the dummy loudspeakers, they have served their purpose and can now be laid to rest */
             for(i=0; i<N_points; i++)
-                memcpy(&(*gtable)[i*L], &(*gtable)[i*numOutVertices], L*sizeof(float));
+                memmove(&(*gtable)[i*L], &(*gtable)[i*numOutVertices], L*sizeof(float));
             (*gtable) = realloc((*gtable), N_points*L*sizeof(float));
         }
     }
@@ -273,7 +273,7 @@ void generateVBAPgainTable3D
     if(enableDummies){
         if(needDummy[0] || needDummy[1]){
             for(i=0; i<N_points; i++)
-                memcpy(&(*gtable)[i*L], &(*gtable)[i*numOutVertices], L*sizeof(float));
+                memmove(&(*gtable)[i*L], &(*gtable)[i*numOutVertices], L*sizeof(float));
             (*gtable) = realloc((*gtable), N_points*L*sizeof(float));
         }
     }
@@ -308,6 +308,142 @@ void generateVBAPgainTable3D
     free(ele);
 }
 
+void vbap_create
+(
+    void** const phVbap,
+    float* ls_dirs_deg,
+    int L,
+    int omitLargeTriangles,
+    int enableDummies,
+    int* nTriangles
+)
+{
+    vbap_data* pData;
+    int i, L_d, numOutVertices, numOutFaces;
+    int* out_faces;
+    float *out_vertices, *layoutInvMtx;
+    int needDummy[2] = {1, 1};
+    float* ls_dirs_d_deg;
+    
+    (*phVbap) = NULL;
+    (*nTriangles) = 0;
+    
+    /* find loudspeaker triangles */
+    out_vertices = NULL;
+    out_faces = NULL;
+    needDummy[0] = needDummy[1] = enableDummies;
+    for(i=0; i<L && enableDummies; i++){
+        /* scan the loudspeaker directions to see if dummies need to be added */
+        if(ls_dirs_deg[i*2+1] <= -ADD_DUMMY_LIMIT)
+            needDummy[0] = 0;
+        if(ls_dirs_deg[i*2+1] >=  ADD_DUMMY_LIMIT)
+            needDummy[1] = 0;
+    }
+    if(needDummy[0] || needDummy[1]){
+        /* add dummies to the extreme top/bottom as required */
+        L_d = L+needDummy[0]+needDummy[1];
+        ls_dirs_d_deg = malloc(L_d*2*sizeof(float));
+        memcpy(ls_dirs_d_deg, ls_dirs_deg, L*2*sizeof(float));
+        i = L;
+        if (needDummy[0]){
+            ls_dirs_d_deg[i*2+0] = 0.0f;
+            ls_dirs_d_deg[i*2+1] = -90.0f;
+            i++;
+        }
+        if (needDummy[1]){
+            ls_dirs_d_deg[i*2+0] = 0.0f;
+            ls_dirs_d_deg[i*2+1] = 90.0f;
+        }
+        findLsTriplets(ls_dirs_d_deg, L_d, omitLargeTriangles, &out_vertices, &numOutVertices, &out_faces, &numOutFaces);
+        free(ls_dirs_d_deg);
+    }
+    else
+        findLsTriplets(ls_dirs_deg, L, omitLargeTriangles, &out_vertices, &numOutVertices, &out_faces, &numOutFaces);
+    if(out_faces==NULL){
+        free(out_vertices);
+        return;
+    }
+    
+    /* Invert matrices and find the triangle neighbours */
+    layoutInvMtx = NULL;
+    invertLsMtx3D(out_vertices, out_faces, numOutFaces, &layoutInvMtx);
+    pData = malloc(sizeof(vbap_data));
+    pData->L = L;
+    pData->nFaces = numOutFaces;
+    pData->ls_groups = out_faces;
+    pData->layoutInvMtx = layoutInvMtx;
+    pData->neighbours = malloc(3*numOutFaces*sizeof(int));
+    findLsTripletNeighbours(out_faces, numOutFaces, pData->neighbours);
+    pData->prevFace = 0;
+    free(out_vertices);
+    
+    (*phVbap) = (void*)pData;
+    (*nTriangles) = numOutFaces;
+}
+
+void vbap_destroy
+(
+    void** const phVbap
+)
+{
+    vbap_data* pData = (vbap_data*)(*phVbap);
+    
+    if(pData != NULL){
+        free(pData->ls_groups);
+        free(pData->neighbours);
+        free(pData->layoutInvMtx);
+        free(pData);
+        (*phVbap) = NULL;
+    }
+}
+
+void vbap_query
+(
+    void* const hVbap,
+    float azi_deg,
+    float elev_deg,
+    int idx[3],
+    float gains[3]
+)
+{
+    vbap_data* pData = (vbap_data*)(hVbap);
+    int i, face;
+    float azi_rad, elev_rad, g_rms;
+    float u[3], g[3];
+    
+    azi_rad  = azi_deg*M_PI/180.0f;
+    elev_rad = elev_deg*M_PI/180.0f;
+    u[0] = cosf(azi_rad)*cosf(elev_rad);
+    u[1] = sinf(azi_rad)*cosf(elev_rad);
+    u[2] = sinf(elev_rad);
+    face = findEnclosingLsTriplet(u, pData->nFaces, pData->layoutInvMtx, pData->neighbours, pData->prevFace, g);
+    if(face==-1){
+        for(i=0; i<3; i++){
+            idx[i] = 0;
+            gains[i] = 0.0f;
+        }
+        return;
+    }
+    pData->prevFace = face;
+    g_rms = 0.0f;
+    for(i=0; i<3; i++){
+        idx[i] = pData->ls_groups[face*3+i];
+        gains[i] = MAX(g[i], 0.0f);
+        if(idx[i]>=pData->L){
+            /* dummy loudspeaker */
+            idx[i] = 0;
+            gains[i] = 0.0f;
+        }
+        g_rms += gains[i]*gains[i];
+    }
+    
+    /* energy normalise over the remaining (real) loudspeakers */
+    g_rms = sqrtf(g_rms);
+    if(g_rms>2.23e-13f)
+        for(i=0; i<3; i++)
+            gains[i] /= g_rms;
+}
+
 void compressVBAPgainTable3D
 (
     float* vbap_gtable,
@@ -364,6 +500,161 @@ void compressVBAPgainTable3D
 #endif
 }
 
+void generateVBAPgainTable3D_compressed
+(
+    float* ls_dirs_deg,
+    int L,
+    int az_res_deg,
+    int el_res_deg,
+    int omitLargeTriangles,
+    int enableDummies,
+    float** vbap_gtableComp, /* N_gtable x 3  */
+    int** vbap_gtableIdx,    /* N_gtable x 3  */
+    int* N_gtable,
+    int* nTriangles
+)
+{
+    int i, j, k, n, nt, N_azi, N_ele, idx_tmp, n_tmp;
+    int idx_nt[3];
+    float fi, gains_sum, g_tmp;
+    float gains_nt[3];
+    float* azi, *ele;
+    void* hVbap;
+    
+    (*vbap_gtableComp) = NULL;
+    (*vbap_gtableIdx) = NULL;
+    vbap_create(&hVbap, ls_dirs_deg, L, omitLargeTriangles, enableDummies, nTriangles);
+    if(hVbap==NULL)
+        return;
+    
+    /* the same grid as generateVBAPgainTable3D */
+    N_azi = (int)((360.0f/(float)az_res_deg) + 1.5f);
+    N_ele = (int)((180.0f/(float)el_res_deg) + 1.5f);
+    azi = malloc(N_azi * sizeof(float));
+    ele = malloc(N_ele * sizeof(float));
+    for(fi = -180.0f, i = 0; i<N_azi; fi+=(float)az_res_deg, i++)
+        azi[i] = fi;
+    for(fi = -90.0f,  i = 0; i<N_ele; fi+=(float)el_res_deg, i++)
+        ele[i] = fi;
+    (*N_gtable) = N_azi*N_ele;
+    (*vbap_gtableComp) = calloc((*N_gtable)*3, sizeof(float));
+    (*vbap_gtableIdx) = calloc((*N_gtable)*3, sizeof(int));
+    
+    /* keep only the non-zero gains in ascending loudspeaker order (as in compressVBAPgainTable3D), and convert to
+     * AMPLITUDE NORMALISED */
+    for(i = 0; i<N_ele; i++){
+        for(j=0; j<N_azi; j++){
+            nt = i*N_azi + j;
+            vbap_query(hVbap, azi[j], ele[i], idx_nt, gains_nt);
+            for(k=0, n=0; k<3; k++){
+                if(gains_nt[k]>0.0f){
+                    gains_nt[n] = gains_nt[k];
+                    idx_nt[n] = idx_nt[k];
+                    n++;
+                }
+            }
+            for(k=1; k<n; k++){
+                for(idx_tmp=k; idx_tmp>0 && idx_nt[idx_tmp-1]>idx_nt[idx_tmp]; idx_tmp--){
+                    n_tmp = idx_nt[idx_tmp-1];
+                    idx_nt[idx_tmp-1] = idx_nt[idx_tmp];
+                    idx_nt[idx_tmp] = n_tmp;
+                    g_tmp = gains_nt[idx_tmp-1];
+                    gains_nt[idx_tmp-1] = gains_nt[idx_tmp];
+                    gains_nt[idx_tmp] = g_tmp;
+                }
+            }
+            gains_sum = 0.0f;
+            for(k=0; k<n; k++)
+                gains_sum += gains_nt[k];
+            for(k=0; k<n; k++){
+                (*vbap_gtableComp)[nt*3+k] = MAX(gains_nt[k]/gains_sum, 0.0f);
+                (*vbap_gtableIdx)[nt*3+k] = idx_nt[k];
+            }
+        }
+    }
+    
+    free(azi);
+    free(ele);
+    vbap_destroy(&hVbap);
+}
+
+void generateVBAPgainTable3D_srcs_sparse
+(
+    float* src_dirs_deg,
+    int S,
+    float* ls_dirs_deg,
+    int L,
+    int omitLargeTriangles,
+    int enableDummies,
+    int interpTable,
+    vbapSparseTable** gtable,
+    int* nTriangles
+)
+{
+    int i, k, ns, nnz;
+    int idx_ns[3];
+    float gains_sum;
+    float gains_ns[3];
+    void* hVbap;
+    vbapSparseTable* pTable;
+    
+    (*gtable) = NULL;
+    vbap_create(&hVbap, ls_dirs_deg, L, omitLargeTriangles, enableDummies, nTriangles);
+    if(hVbap==NULL)
+        return;
+    
+    /* at most 3 non-zero gains per source direction */
+    pTable = malloc(sizeof(vbapSparseTable));
+    pTable->nRows = S;
+    pTable->nCols = L;
+    pTable->rowPtr = malloc((S+1)*sizeof(int));
+    pTable->colIdx = malloc(3*S*sizeof(int));
+    pTable->gains = malloc(3*S*sizeof(float));
+    nnz = 0;
+    for(ns=0; ns<S; ns++){
+        pTable->rowPtr[ns] = nnz;
+        vbap_query(hVbap, src_dirs_deg[ns*2], src_dirs_deg[ns*2+1], idx_ns, gains_ns);
+        gains_sum = 0.0f;
+        for(k=0; k<3; k++)
+            gains_sum += gains_ns[k];
+        for(k=0; k<3; k++){
+            if(gains_ns[k]>0.0f){
+                /* insert in ascending loudspeaker order */
+                for(i=nnz; i>pTable->rowPtr[ns] && pTable->colIdx[i-1]>idx_ns[k]; i--){
+                    pTable->colIdx[i] = pTable->colIdx[i-1];
+                    pTable->gains[i] = pTable->gains[i-1];
+                }
+                pTable->colIdx[i] = idx_ns[k];
+                pTable->gains[i] = interpTable ? gains_ns[k]/gains_sum : gains_ns[k];
+                nnz++;
+            }
+        }
+    }
+    pTable->rowPtr[S] = nnz;
+    pTable->nnz = nnz;
+    pTable->colIdx = realloc(pTable->colIdx, MAX(nnz,1)*sizeof(int));
+    pTable->gains = realloc(pTable->gains, MAX(nnz,1)*sizeof(float));
+    
+    (*gtable) = pTable;
+    vbap_destroy(&hVbap);
+}
+
+void destroyVBAPsparseTable
+(
+    vbapSparseTable** const gtable
+)
+{
+    vbapSparseTable* pTable = (*gtable);
+    
+    if(pTable != NULL){
+        free(pTable->rowPtr);
+        free(pTable->colIdx);
+        free(pTable->gains);
+        free(pTable);
+        (*gtable) = NULL;
+    }
+}
+
 void VBAPgainTable2InterpTable
 (
     float* vbap_gtable,
@@ -472,6 +763,73 @@ void generateVBAPgainTable2D
         free(layoutInvMtx);
 }
 
+void generateVBAPgainTable2D_sparse
+(
+    float* ls_dirs_deg,
+    int L,
+    int az_res_deg,
+    vbapSparseTable** gtable,
+    int* nPairs
+)
+{
+    int i, ls, N_azi, numOutPairs, nnz, capacity;
+    int* out_pairs;
+    float fi;
+    float *layoutInvMtx, *ls_vertices, *gains;
+    vbapSparseTable* pTable;
+    
+    out_pairs = NULL;
+    findLsPairs(ls_dirs_deg, L, &out_pairs, &numOutPairs);
+    ls_vertices = malloc(L*2*sizeof(float));
+    for(i=0; i<L; i++){
+        ls_vertices[i*2+0] = cosf(ls_dirs_deg[i*2]*M_PI/180.0f);
+        ls_vertices[i*2+1] = sinf(ls_dirs_deg[i*2]*M_PI/180.0f);
+    }
+    
+    /* Invert matrix */
+    layoutInvMtx = NULL;
+    invertLsMtx2D(ls_vertices, out_pairs, numOutPairs, &layoutInvMtx);
+    
+    /* Calculate VBAP gains for each direction of the grid, and keep only the non-zero gains */
+    N_azi = (int)((360.0f/(float)az_res_deg) + 1.5f);
+    gains = malloc(L*sizeof(float));
+    capacity = 2*N_azi;
+    pTable = malloc(sizeof(vbapSparseTable));
+    pTable->nRows = N_azi;
+    pTable->nCols = L;
+    pTable->rowPtr = malloc((N_azi+1)*sizeof(int));
+    pTable->colIdx = malloc(capacity*sizeof(int));
+    pTable->gains = malloc(capacity*sizeof(float));
+    nnz = 0;
+    for(fi = -180.0f, i = 0; i<N_azi; fi+=(float)az_res_deg, i++){
+        pTable->rowPtr[i] = nnz;
+        vbap2Dgains(fi, L, out_pairs, numOutPairs, layoutInvMtx, gains);
+        for(ls=0; ls<L; ls++){
+            if(gains[ls]>0.0f){
+                if(nnz==capacity){
+                    capacity *= 2;
+                    pTable->colIdx = realloc(pTable->colIdx, capacity*sizeof(int));
+                    pTable->gains = realloc(pTable->gains, capacity*sizeof(float));
+                }
+                pTable->colIdx[nnz] = ls;
+                pTable->gains[nnz] = gains[ls];
+                nnz++;
+            }
+        }
+    }
+    pTable->rowPtr[N_azi] = nnz;
+    pTable->nnz = nnz;
+    (*gtable) = pTable;
+    (*nPairs) = numOutPairs;
+    
+    free(gains);
+    free(ls_vertices);
+    if(out_pairs!=NULL)
+        free(out_pairs);
+    if(layoutInvMtx!=NULL)
+        free(layoutInvMtx);
+}
+
 
 /* Laitinen, M., Vilkamo, J., Jussila, K., Politis, A., Pulkki, V. (2014). Gain normalisation in amplitude panning as a function of
  * frequency and room reverberance. 55th International Conference of the AES. Helsinki, Finland. */
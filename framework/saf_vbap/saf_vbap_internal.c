@@ -51,27 +51,6 @@ int cmp_desc_REAL(const void *a,const void *b) {
     else return 0;
 }
 
-typedef struct sort_int {
-    int val;
-    int idx;
-}sort_int;
-
-int cmp_asc_int(const void *a,const void *b) {
-    struct sort_int *a1 = (struct sort_int*)a;
-    struct sort_int *a2 = (struct sort_int*)b;
-    if((*a1).val<(*a2).val)return -1;
-    else if((*a1).val>(*a2).val)return 1;
-    else return 0;
-}
-
-int cmp_desc_int(const void *a,const void *b) {
-    struct sort_int *a1 = (struct sort_int*)a;
-    struct sort_int *a2 = (struct sort_int*)b;
-    if((*a1).val>(*a2).val)return -1;
-    else if((*a1).val<(*a2).val)return 1;
-    else return 0;
-}
-
 static void please_sort_REAL
 (
     REAL* in_vec,    /* vector[len] to be sorted */
@@ -104,135 +83,72 @@ static void please_sort_REAL
     free(data);
 }
 
-static void please_sort_int
+/* A face of the convex hull being constructed by convhull_3d() */
+typedef struct _convhull_face {
+    int v[3];        /* vertex indices; counter-clockwise when viewed from outside of the hull */
+    int nb[3];       /* index of the neighbouring face across the edge v[k] -> v[(k+1)%3] */
+    int outside;     /* first point (of a linked list) that lies outside of this face, or -1 */
+    int alive;       /* 0: face has been deleted */
+    int visStamp;    /* iteration in which the visibility of this face was last determined */
+    int visible;     /* visibility of the face from the current eye point */
+}convhull_face;
+
+/* Exact orientation test on the integer grid: >0 if point 'p' lies outside of the plane of face (a,b,c), <0 if it
+ * lies inside, and 0 if the four points are coplanar. For the grid used, the result cannot overflow 64 bits */
+static long long convhull_orient
 (
-    int* in_vec,     /* vector[len] to be sorted */
-    int* out_vec,    /* if NULL, then in_vec is sorted "in-place" */
-    int* new_idices, /* set to NULL if you don't need them */
-    int len,         /* number of elements in vectors, must be consistent with the input data */
-    int descendFLAG  /* !1:ascending, 1:descending */
+    long long* P,
+    int a,
+    int b,
+    int c,
+    int p
 )
 {
-    int i;
-    struct sort_int *data;
+    long long u[3], v[3], w[3];
+    int j;
     
-    data = malloc(len*sizeof(sort_int));
-    for(i=0;i<len;i++) {
-        data[i].val=in_vec[i];
-        data[i].idx=i;
-    }
-    if(descendFLAG)
-        qsort(data,len,sizeof(data[0]),cmp_desc_int);
-    else
-        qsort(data,len,sizeof(data[0]),cmp_asc_int);
-    for(i=0;i<len;i++){
-        if (out_vec!=NULL)
-            out_vec[i] = data[i].val;
-        else
-            in_vec[i] = data[i].val; /* overwrite input vector */
-        if(new_idices!=NULL)
-            new_idices[i] = data[i].idx;
-    }
-    free(data);
-}
-
-/* calculates the determinent of a 4x4 matrix */
-REAL convhull_det_4x4(REAL* m) {
-    return
-    m[3] * m[6] * m[9] * m[12] - m[2] * m[7] * m[9] * m[12] -
-    m[3] * m[5] * m[10] * m[12] + m[1] * m[7] * m[10] * m[12] +
-    m[2] * m[5] * m[11] * m[12] - m[1] * m[6] * m[11] * m[12] -
-    m[3] * m[6] * m[8] * m[13] + m[2] * m[7] * m[8] * m[13] +
-    m[3] * m[4] * m[10] * m[13] - m[0] * m[7] * m[10] * m[13] -
-    m[2] * m[4] * m[11] * m[13] + m[0] * m[6] * m[11] * m[13] +
-    m[3] * m[5] * m[8] * m[14] - m[1] * m[7] * m[8] * m[14] -
-    m[3] * m[4] * m[9] * m[14] + m[0] * m[7] * m[9] * m[14] +
-    m[1] * m[4] * m[11] * m[14] - m[0] * m[5] * m[11] * m[14] -
-    m[2] * m[5] * m[8] * m[15] + m[1] * m[6] * m[8] * m[15] +
-    m[2] * m[4] * m[9] * m[15] - m[0] * m[6] * m[9] * m[15] -
-    m[1] * m[4] * m[10] * m[15] + m[0] * m[5] * m[10] * m[15];
-}
-
-/* Calculates the coefficients of the equation of a PLANE in 3D.
- * Copyright (c) 2014, George Papazafeiropoulos
- * All rights reserved. Distributed under the BSD (2-clause) license
- */
-static void convhull_plane_3d
-(
-    REAL* p,
-    REAL* c,
-    REAL* d
-)
-{
-    int i, j, k, l;
-    int m;
-    int* r;
-    REAL sign, det, norm_c;
-    REAL* pdiff, *pdiff_s;
-
-    m=3;
-    pdiff = malloc( (m-1)*m *sizeof(REAL));
-    for(i=0; i<m-1; i++)
-        for(j=0; j<m; j++)
-            pdiff[i*m+j] = p[(i+1)*3+j] - p[i*3+j];
-    memset(c, 0, m*sizeof(REAL));
-    sign = 1.0;
-    r=malloc(m*sizeof(int));
-    for(i=0; i<m; i++)
-        r[i] = i;
-    pdiff_s = malloc((m-1)*(m-1)*sizeof(REAL));
-    for(i=0; i<m; i++){
-        for(j=0; j<m-1; j++){
-            for(k=0, l=0; k<m; k++){
-                if(r[k]!=i){
-                    pdiff_s[j*(m-1)+l] = pdiff[j*m+k];
-                    l++;
-                }
-            }
-        }
-        det = pdiff_s[0*(m-1)+0]*pdiff_s[1*(m-1)+1] -
-              pdiff_s[1*(m-1)+0]*pdiff_s[0*(m-1)+1];
-        c[i] = sign * det;
-        sign *= -1.0;
+    for(j=0; j<3; j++){
+        u[j] = P[b*3+j] - P[a*3+j];
+        v[j] = P[c*3+j] - P[a*3+j];
+        w[j] = P[p*3+j] - P[a*3+j];
     }
-    norm_c = 0.0;
-    for(i=0; i<m; i++)
-        norm_c += (pow(c[i], 2.0));  
-    norm_c = sqrt(norm_c);
-    for(i=0; i<m; i++)
-        c[i] /= norm_c;
-    (*d) = 0.0;
-    for(i=0; i<m; i++)
-        (*d) += -p[i] * c[i];
-
-    free(pdiff);
-    free(r);
-    free(pdiff_s);
+    return (u[1]*v[2]-u[2]*v[1])*w[0] + (u[2]*v[0]-u[0]*v[2])*w[1] + (u[0]*v[1]-u[1]*v[0])*w[2];
 }
 
-static void convhull_ismember
+/* appends a face to the hull (growing the face array if needed), and returns its index */
+static int convhull_addFace
 (
-    int* pLeft,
-    int* pRight,
-    int* pOut,     /* contains 0's and 1's; [nLeftElements]*/
-    int nLeftElements,
-    int nRightElements
+    convhull_face** faces,
+    int* nFaces,
+    int* maxFaces,
+    int a,
+    int b,
+    int c
 )
 {
-    int i, j;
-    memset(pOut, 0, nLeftElements*sizeof(int));
-    for(i=0; i< nLeftElements; i++)
-        for(j=0; j< nRightElements; j++)
-            if(pLeft[i] == pRight[j] )
-                pOut[i] = 1;
+    convhull_face* f;
+    
+    if(*nFaces == *maxFaces){
+        *maxFaces *= 2;
+        *faces = realloc(*faces, (*maxFaces)*sizeof(convhull_face));
+    }
+    f = &(*faces)[*nFaces];
+    f->v[0] = a;
+    f->v[1] = b;
+    f->v[2] = c;
+    f->nb[0] = f->nb[1] = f->nb[2] = -1;
+    f->outside = -1;
+    f->alive = 1;
+    f->visStamp = -1;
+    f->visible = 0;
+    return (*nFaces)++;
 }
 
-/* a stripped down C version of the 3D convex hull matlab implementation from here:
- * https://www.mathworks.com/matlabcentral/fileexchange/48509-computational-geometry-toolbox?focused=3851550&tab=example
- * (*out_faces) is returned as NULL, if triangulation fails *
- * Copyright (c) 2014, George Papazafeiropoulos
- * All rights reserved. Distributed under the BSD (2-clause) license
- */
+/* Computes the 3D convex hull of a set of points using the quickhull algorithm. The points are snapped to an integer
+ * grid (CONVHULL_3D_GRID steps per unit), and all orientation tests are carried out exactly on this grid; therefore,
+ * no random jitter is required and the output is deterministic. Points that are coincident, or coplanar with a face of
+ * the hull, do not become vertices of the hull. Vertices should lie within the unit sphere.
+ * (*out_faces) is returned as NULL, if triangulation fails (i.e. if all points are coplanar) */
 static void convhull_3d
 (
     REAL* vertices,
@@ -241,428 +157,239 @@ static void convhull_3d
     int* nOut_faces
 )
 {
-    int i, j, k, l, h;
-    int d, nFaces, p;
-    int* aVec, *faces;
-    REAL dfi, v, max_p, min_p;
-    REAL* points, *cf, *cfi, *df, *p_s, *span;
+    int i, j, k, n, f, g, a, b, eye, p, nextp, nFaces, maxFaces, nNew, nStack, maxStack, nHorizon, iter, tmp;
+    int ini[4];
+    int* next, *stack, *horizon, *newFaces, *startFace, *endFace, *visList;
+    long long o, maxO;
+    long long* P;
+    double d, maxD, cr[3];
+    convhull_face* faces;
+    
+    (*out_faces) = NULL;
+    (*nOut_faces) = 0;
+    if(nVert<4)
+        return;
     
-    /* if (*out_faces) returns as NULL, then the triangulation failed */
-    d = 3; /* number of dimensions */ 
-    span = malloc(d*sizeof(REAL));
-    for(j=0; j<d; j++){
-        max_p = 2.23e-13; min_p = 2.23e+13;
-        for(i=0; i<nVert; i++){
-            max_p = MAX(max_p, vertices[i*d+j]);
-            min_p = MIN(min_p, vertices[i*d+j]);
+    /* snap to the integer grid */
+    P = malloc(nVert*3*sizeof(long long));
+    for(i=0; i<nVert*3; i++)
+        P[i] = (long long)floor(vertices[i]*CONVHULL_3D_GRID + 0.5);
+    
+    /* initial simplex: the first point, the point furthest from it, the point furthest from the line through these two,
+     * and the point furthest from the plane through all three */
+    ini[0] = 0;
+    ini[1] = ini[2] = ini[3] = -1;
+    maxD = 0.0;
+    for(i=1; i<nVert; i++){
+        for(j=0, d=0.0; j<3; j++)
+            d += (double)(P[i*3+j]-P[j])*(double)(P[i*3+j]-P[j]);
+        if(d>maxD){
+            maxD = d;
+            ini[1] = i;
         }
-        span[j] = max_p - min_p;
     }
-    points = malloc(nVert*(d+1)*sizeof(REAL));
-    for(i=0; i<nVert; i++){
-        for(j=0; j<3; j++)
-            points[i*4+j] = vertices[i*3 + j];
-        points[i*4+3] = 1.0f; /* add a last column of ones. Used only for determinant calculation */
+    if(ini[1]==-1){
+        free(P);
+        return; /* all points are coincident */
     }
-    
-    /* The initial convex hull is a simplex with (d+1) facets */
-    nFaces = d+1;
-    faces = calloc(nFaces*d, sizeof(int));
-    aVec = malloc(nFaces*sizeof(int));
-    for(i=0; i<nFaces; i++)
-        aVec[i] = i;
-    
-    /* Each column of cf contains the coefficients of a plane */
-    cf = malloc(nFaces*d*sizeof(REAL));
-    cfi = malloc(d*sizeof(REAL));
-    df = malloc(nFaces*sizeof(REAL));
-    p_s = malloc(d*d*sizeof(REAL));
-    for(i=0; i<nFaces; i++){
-        /* Set the indices of the points defining the face  */
-        for(j=0, k=0; j<d+1; j++){
-            if(aVec[j]!=i){
-                faces[i*d+k] = aVec[j];
-                k++;
-            }
+    maxD = 0.0;
+    for(i=1; i<nVert; i++){
+        /* (exact cross product on the grid) */
+        cr[0] = (double)((P[ini[1]*3+1]-P[1])*(P[i*3+2]-P[2]) - (P[ini[1]*3+2]-P[2])*(P[i*3+1]-P[1]));
+        cr[1] = (double)((P[ini[1]*3+2]-P[2])*(P[i*3+0]-P[0]) - (P[ini[1]*3+0]-P[0])*(P[i*3+2]-P[2]));
+        cr[2] = (double)((P[ini[1]*3+0]-P[0])*(P[i*3+1]-P[1]) - (P[ini[1]*3+1]-P[1])*(P[i*3+0]-P[0]));
+        d = cr[0]*cr[0] + cr[1]*cr[1] + cr[2]*cr[2];
+        if(d>maxD){
+            maxD = d;
+            ini[2] = i;
         }
-        
-        /* Calculate and store the plane coefficients of the face */
-        for(j=0; j<d; j++)
-            for(k=0; k<d; k++)
-                p_s[j*d+k] = points[(faces[i*d+j])*(d+1) + k];
-        
-        /* Calculate and store the plane coefficients of the face */
-        convhull_plane_3d(p_s, cfi, &dfi);
-        for(j=0; j<d; j++)
-            cf[i*d+j] = cfi[j];
-        df[i] = dfi;
     }
-    REAL *A;
-    int *bVec, *fVec, *asfVec, *face_tmp;
-    
-    /* Check to make sure that faces are correctly oriented */
-    bVec = malloc((d+1)*sizeof(int));
-    for(i=0; i<d+1; i++)
-        bVec[i] = i;
-    
-    /* A contains the coordinates of the points forming a simplex */
-    A = calloc((d+1)*(d+1), sizeof(REAL));
-    face_tmp = malloc(d*sizeof(int));
-    fVec = malloc(d*sizeof(int));
-    asfVec = malloc(d*sizeof(int));
-    for(k=0; k<d+1; k++){
-        /* Get the point that is not on the current face (point p) */
-        for(i=0; i<d; i++)
-            fVec[i] = faces[k*d+i];
-        please_sort_int(fVec, NULL, NULL, d, 0); /* sort accending */
-        p=k;
-        for(i=0; i<d; i++)
-            for(j=0; j<d+1; j++)
-                A[i*(d+1)+j] = points[(faces[k*d+i])*(d+1) + j];
-        for(; i<d+1; i++)
-            for(j=0; j<d+1; j++)
-                A[i*(d+1)+j] = points[p*(d+1)+j];
-        
-        /* det(A) determines the orientation of the face */
-        v = convhull_det_4x4(A);
-        
-        /* Orient so that each point on the original simplex can't see the opposite face */
-        if(v<0){
-            /* Reverse the order of the last two vertices to change the volume */
-            for(j=0; j<d; j++)
-                face_tmp[j] = faces[k*d+j];
-            for(j=0, l=d-2; j<d-1; j++, l++)
-                faces[k*d+l] = face_tmp[d-j-1];
-            
-            /* Modify the plane coefficients of the properly oriented faces */
-            for(j=0; j<d; j++)
-                cf[k*d+j] = -cf[k*d+j];
-            df[k] = -df[k];
-            for(i=0; i<d; i++)
-                for(j=0; j<d+1; j++)
-                    A[i*(d+1)+j] = points[(faces[k*d+i])*(d+1) + j];
-            for(; i<d+1; i++)
-                for(j=0; j<d+1; j++)
-                    A[i*(d+1)+j] = points[p*(d+1)+j];
+    if(ini[2]==-1){
+        free(P);
+        return; /* all points are collinear */
+    }
+    maxO = 0;
+    for(i=1; i<nVert; i++){
+        o = convhull_orient(P, ini[0], ini[1], ini[2], i);
+        if(llabs(o)>llabs(maxO)){
+            maxO = o;
+            ini[3] = i;
         }
     }
+    if(ini[3]==-1){
+        free(P);
+        return; /* all points are coplanar */
+    }
+    if(maxO>0){
+        /* so that the fourth point lies inside of face (0,1,2) */
+        tmp = ini[1];
+        ini[1] = ini[2];
+        ini[2] = tmp;
+    }
     
-    /* Coordinates of the center of the point set */
-    REAL* meanp, *absdist, *reldist, *desReldist;
-    meanp = calloc(d, sizeof(REAL));
-    for(i=d+1; i<nVert; i++)
-        for(j=0; j<d; j++)
-            meanp[j] += points[i*(d+1)+j];
-    for(j=0; j<d; j++)
-        meanp[j] = meanp[j]/(REAL)(nVert-d-1);
-    
-    /* Absolute distance of points from the center */
-    absdist = malloc((nVert-d-1)*d * sizeof(REAL));
-    for(i=d+1, k=0; i<nVert; i++, k++)
-        for(j=0; j<d; j++)
-            absdist[k*d+j] = (points[i*(d+1)+j] -  meanp[j])/span[j];
-    
-    /* Relative distance of points from the center */
-    reldist = calloc((nVert-d-1), sizeof(REAL));
-    desReldist = malloc((nVert-d-1) * sizeof(REAL));
-    for(i=0; i<(nVert-d-1); i++)
-        for(j=0; j<d; j++)
-            reldist[i] += pow(absdist[i*d+j], 2.0);
-    
-    /* Sort from maximum to minimum relative distance */
-    int num_pleft, cnt;
-    int* ind, *pleft;
-    ind = malloc((nVert-d-1) * sizeof(int));
-    pleft = malloc((nVert-d-1) * sizeof(int));
-    please_sort_REAL(reldist, desReldist, ind, (nVert-d-1), 1);
-    
-    /* Initialize the vector of points left. The points with the larger relative
-       distance from the center are scanned first. */
-    num_pleft = (nVert-d-1);
-    for(i=0; i<num_pleft; i++)
-        pleft[i] = ind[i]+d+1;
-    
-    /* Loop over all remaining points that are not deleted. Deletion of points
-       occurs every #iter2del# iterations of this while loop */
-    memset(A, 0, (d+1)*(d+1) * sizeof(REAL));
-    
-    /* cnt is equal to the points having been selected without deletion of
-       nonvisible points (i.e. points inside the current convex hull) */
-    cnt=0;
+    /* simplex faces, oriented outwards */
+    maxFaces = 4*nVert;
+    nFaces = 0;
+    faces = malloc(maxFaces*sizeof(convhull_face));
+    convhull_addFace(&faces, &nFaces, &maxFaces, ini[0], ini[1], ini[2]);
+    convhull_addFace(&faces, &nFaces, &maxFaces, ini[0], ini[3], ini[1]);
+    convhull_addFace(&faces, &nFaces, &maxFaces, ini[1], ini[3], ini[2]);
+    convhull_addFace(&faces, &nFaces, &maxFaces, ini[2], ini[3], ini[0]);
+    for(f=0; f<4; f++)
+        for(k=0; k<3; k++)
+            for(g=0; g<4; g++)
+                for(n=0; n<3; n++)
+                    if(faces[g].v[n]==faces[f].v[(k+1)%3] && faces[g].v[(n+1)%3]==faces[f].v[k])
+                        faces[f].nb[k] = g;
+    
+    /* assign each remaining point to the first face that it lies outside of */
+    next = malloc(nVert*sizeof(int));
+    for(i=0; i<nVert; i++){
+        if(i==ini[0] || i==ini[1] || i==ini[2] || i==ini[3])
+            continue;
+        for(f=0; f<4; f++){
+            if(convhull_orient(P, faces[f].v[0], faces[f].v[1], faces[f].v[2], i)>0){
+                next[i] = faces[f].outside;
+                faces[f].outside = i;
+                break;
+            }
+        }
+    }
     
-    /* The main loop: */
-    REAL detA;
-    REAL* points_cf, *points_s;
-    int* visible_ind, *visible, *nonvisible_faces, *f0, *face_s, *u, *gVec, *horizon, *hVec, *pp, *hVec_mem_face;
-    int num_visible_ind, num_nonvisible_faces, n_newfaces, count, vis;
-    int f0_sum, u_len, start, num_p, index, horizon_size1;
-    int FUCKED;
-    FUCKED = 0;
-	u = horizon = NULL;
-    nFaces = d+1;
-    visible_ind = malloc(nFaces*sizeof(int));
-    points_cf = malloc(nFaces*sizeof(REAL));
-    points_s = malloc(d*sizeof(REAL));
-    face_s = malloc(d*sizeof(int));
-    gVec = malloc(d*sizeof(int));
-    int HARD_STOP =0;
-    while( (num_pleft>0) ){//}&& (HARD_STOP != 10 )){
-        HARD_STOP++;
-        /* i is the first point of the points left */
-        i = pleft[0];
-        
-        /* Delete the point selected */
-        for(j=0; j<num_pleft-1; j++)
-            pleft[j] = pleft[j+1];
-        num_pleft--;
-        if(num_pleft == 0)
-            free(pleft);
-        else
-            pleft = realloc(pleft, num_pleft*sizeof(int));
+    /* main loop (the hull never has more than 2*nVert faces, which bounds the number of visible and new faces) */
+    maxStack = maxFaces;
+    stack = malloc(maxStack*sizeof(int));
+    visList = malloc(4*nVert*sizeof(int));
+    horizon = malloc(4*nVert*3*sizeof(int));
+    newFaces = malloc(4*nVert*sizeof(int));
+    startFace = malloc(nVert*sizeof(int));
+    endFace = malloc(nVert*sizeof(int));
+    for(f=0; f<4; f++)
+        stack[f] = f;
+    nStack = 4;
+    iter = 0;
+    while(nStack>0){
+        f = stack[--nStack];
+        if(!faces[f].alive || faces[f].outside==-1)
+            continue;
         
-        /* Update point selection counter */
-        cnt++;
-        
-        /* find visible faces */
-        for(j=0; j<d; j++)
-            points_s[j] = points[i*(d+1)+j];
-        points_cf = realloc(points_cf, nFaces*sizeof(REAL));
-        visible_ind = realloc(visible_ind, nFaces*sizeof(int));
-        cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasTrans, 1, nFaces, d, 1.0,
-                     points_s, d,
-                     cf, d, 0.0,
-                     points_cf, nFaces);
-        num_visible_ind = 0;
-        for(j=0; j<nFaces; j++){
-            if(points_cf[j] + df[j] > 0.0){
-                num_visible_ind++; /* will sum to 0 if none are visible */
-                visible_ind[j] = 1;
+        /* the eye point is the point furthest from this face */
+        eye = faces[f].outside;
+        maxO = 0;
+        for(p=faces[f].outside; p!=-1; p=next[p]){
+            o = convhull_orient(P, faces[f].v[0], faces[f].v[1], faces[f].v[2], p);
+            if(o>maxO){
+                maxO = o;
+                eye = p;
             }
-            else
-                visible_ind[j] = 0;
         }
-        num_nonvisible_faces = nFaces - num_visible_ind;
         
-        /* proceed if there are any visible faces */
-        if(num_visible_ind!=0){
-            /* Find visible face indices */
-            visible = malloc(num_visible_ind*sizeof(int));
-            for(j=0, k=0; j<nFaces; j++){
-                if(visible_ind[j]==1){
-                    visible[k]=j;
-                    k++;
+        /* find all faces that are visible from the eye point (they form a connected region), and the horizon edges
+         * between these faces and the remaining ones */
+        faces[f].visStamp = iter;
+        faces[f].visible = 1;
+        visList[0] = f;
+        n = 1;
+        nHorizon = 0;
+        for(i=0; i<n; i++){
+            for(k=0; k<3; k++){
+                g = faces[visList[i]].nb[k];
+                if(faces[g].visStamp != iter){
+                    faces[g].visStamp = iter;
+                    faces[g].visible = convhull_orient(P, faces[g].v[0], faces[g].v[1], faces[g].v[2], eye)>0;
+                    if(faces[g].visible)
+                        visList[n++] = g;
                 }
-            }
-            
-            /* Find nonvisible faces */
-            nonvisible_faces = malloc(num_nonvisible_faces*d*sizeof(int));
-            f0 = malloc(num_nonvisible_faces*d*sizeof(int));
-            for(j=0, k=0; j<nFaces; j++){
-                if(visible_ind[j]==0){
-                    for(l=0; l<d; l++)
-                        nonvisible_faces[k*d+l]= faces[j*d+l];
-                    k++;
+                if(!faces[g].visible){
+                    horizon[nHorizon*3+0] = faces[visList[i]].v[k];
+                    horizon[nHorizon*3+1] = faces[visList[i]].v[(k+1)%3];
+                    horizon[nHorizon*3+2] = g;
+                    nHorizon++;
                 }
             }
-            
-            /* Create horizon (count is the number of the edges of the horizon) */
-            count=0;
-            for(j=0; j<num_visible_ind; j++){
-                /* visible face */
-                vis = visible[j];
-                for(k=0; k<d; k++)
-                    face_s[k] = faces[vis*d+k];
-                please_sort_int(face_s, NULL, NULL, d, 0);
-                convhull_ismember(nonvisible_faces, face_s, f0, num_nonvisible_faces*d, d);
-                u_len = 0;
-                
-                /* u are the nonvisible faces connected to the face v, if any */
-                for(k=0; k<num_nonvisible_faces; k++){
-                    f0_sum = 0;
-                    for(l=0; l<d; l++)
-                        f0_sum += f0[k*d + l];
-                    if(f0_sum == d-1){
-                        u_len++;
-                        if(u_len==1)
-                            u=malloc(u_len*sizeof(int));
-                        else
-                            u=realloc(u, u_len*sizeof(int));
-                        u[u_len-1] = k;
-                    }
-                }
-                for(k=0; k<u_len; k++){
-                    /* The boundary between the visible face v and the k(th) nonvisible face connected to the face v forms part of the horizon */
-                    count++;
-                    if(count==1)
-                        horizon = malloc(count*(d-1)*sizeof(int));
-                    else
-                        horizon = realloc(horizon, count*(d-1)*sizeof(int));
-                    for(l=0; l<d; l++)
-                        gVec[l] = nonvisible_faces[u[k]*d+l];
-                    for(l=0, h=0; l<d; l++){
-                        if(f0[u[k]*d+l]){
-                            horizon[(count-1)*(d-1)+h] = gVec[l];
-                            h++;
-                        }
+        }
+        iter++;
+        
+        /* replace the visible faces with a cone of new faces, from the horizon to the eye point */
+        for(i=0; i<nHorizon; i++){
+            a = horizon[i*3+0];
+            b = horizon[i*3+1];
+            g = horizon[i*3+2];
+            newFaces[i] = convhull_addFace(&faces, &nFaces, &maxFaces, a, b, eye);
+            faces[newFaces[i]].nb[0] = g;
+            for(k=0; k<3; k++)
+                if(faces[g].v[k]==b && faces[g].v[(k+1)%3]==a)
+                    faces[g].nb[k] = newFaces[i];
+            startFace[a] = newFaces[i];
+            endFace[b] = newFaces[i];
+        }
+        for(i=0; i<nHorizon; i++){
+            faces[newFaces[i]].nb[1] = startFace[horizon[i*3+1]];
+            faces[newFaces[i]].nb[2] = endFace[horizon[i*3+0]];
+        }
+        
+        /* reassign the points of the deleted faces to the new faces */
+        nNew = nHorizon;
+        for(i=0; i<n; i++){
+            faces[visList[i]].alive = 0;
+            for(p=faces[visList[i]].outside; p!=-1; p=nextp){
+                nextp = next[p];
+                if(p==eye)
+                    continue;
+                for(j=0; j<nNew; j++){
+                    g = newFaces[j];
+                    if(convhull_orient(P, faces[g].v[0], faces[g].v[1], faces[g].v[2], p)>0){
+                        next[p] = faces[g].outside;
+                        faces[g].outside = p;
+                        break;
                     }
                 }
-                if(u_len!=0)
-                    free(u);
             }
-            horizon_size1 = count;
-            for(j=0, l=0; j<nFaces; j++){
-                if(!visible_ind[j]){
-                    /* Delete visible faces */
-                    for(k=0; k<d; k++)
-                        faces[l*d+k] = faces[j*d+k];
-                    
-                    /* Delete the corresponding plane coefficients of the faces */
-                    for(k=0; k<d; k++)
-                        cf[l*d+k] = cf[j*d+k];
-                    df[l] = df[j];
-                    l++;
-                }
-            }
-            
-            /* Update the number of faces */
-            nFaces = nFaces-num_visible_ind;
-            faces = realloc(faces, nFaces*d*sizeof(int));
-            cf = realloc(cf, nFaces*d*sizeof(REAL));
-            df = realloc(df, nFaces*sizeof(REAL));
-            
-            /* start is the first row of the new faces */
-            start=nFaces;
-            
-            /* Add faces connecting horizon to the new point */
-            n_newfaces = horizon_size1;
-            for(j=0; j<n_newfaces; j++){
-                nFaces++;
-                faces = realloc(faces, nFaces*d*sizeof(int));
-                cf = realloc(cf, nFaces*d*sizeof(REAL));
-                df = realloc(df, nFaces*sizeof(REAL));
-                for(k=0; k<d-1; k++)
-                    faces[(nFaces-1)*d+k] = horizon[j*(d-1)+k];
-                faces[(nFaces-1)*d+(d-1)] = i;
-                
-                /* Calculate and store appropriately the plane coefficients of the faces */
-                for(k=0; k<d; k++)
-                    for(l=0; l<d; l++)
-                        p_s[k*d+l] = points[(faces[(nFaces-1)*d+k])*(d+1) + l];
-                convhull_plane_3d(p_s, cfi, &dfi);
-                for(k=0; k<d; k++)
-                    cf[(nFaces-1)*d+k] = cfi[k];
-                df[(nFaces-1)] = dfi;
-                if(nFaces > MAX_NUM_FACES){
-                    FUCKED = 1;
-                    nFaces = 0;
-                    break; 
-                }
-            }
-            
-            /* Orient each new face properly */
-            hVec = malloc( nFaces*sizeof(int));
-            hVec_mem_face = malloc( nFaces*sizeof(int));
-            for(j=0; j<nFaces; j++)
-                hVec[j] = j;
-            for(k=start; k<nFaces; k++){
-                for(j=0; j<d; j++)
-                    face_s[j] = faces[k*d+j];
-                please_sort_int(face_s, NULL, NULL, d, 0);
-                convhull_ismember(hVec, face_s, hVec_mem_face, nFaces, d);
-                num_p = 0;
-                for(j=0; j<nFaces; j++)
-                    if(!hVec_mem_face[j])
-                        num_p++;
-                pp=malloc(num_p*sizeof(int));
-                for(j=0, l=0; j<nFaces; j++){
-                    if(!hVec_mem_face[j]){
-                        pp[l] = hVec[j];
-                        l++;
-                    }
-                }
-                index = 0;
-                detA = 0.0;
-                
-                /* While new point is coplanar, choose another point */
-                while(detA==0.0){
-                    for(j=0;j<d; j++)
-                        for(l=0; l<d+1; l++)
-                            A[j*(d+1)+l] = points[(faces[k*d+j])*(d+1) + l];
-                    for(; j<d+1; j++)
-                        for(l=0; l<d+1; l++)
-                            A[j*(d+1)+l] = points[pp[index]*(d+1)+l];
-                    index++;
-                    detA = convhull_det_4x4(A);
-                }
-                
-                /* Orient faces so that each point on the original simplex can't see the opposite face */
-                if (detA<0.0){
-                    /* If orientation is improper, reverse the order to change the volume sign */
-                    for(j=0; j<d; j++)
-                        face_tmp[j] = faces[k*d+j];
-                    for(j=0, l=d-2; j<d-1; j++, l++)
-                        faces[k*d+l] = face_tmp[d-j-1];
-                    
-                    /* Modify the plane coefficients of the properly oriented faces */
-                    for(j=0; j<d; j++)
-                        cf[k*d+j] = -cf[k*d+j];
-                    df[k] = -df[k];
-                    for(l=0; l<d; l++)
-                        for(j=0; j<d+1; j++)
-                            A[l*(d+1)+j] = points[(faces[k*d+l])*(d+1) + j];
-                    for(; l<d+1; l++)
-                        for(j=0; j<d+1; j++)
-                            A[l*(d+1)+j] = points[pp[index]*(d+1)+j];
-                }
-                free(pp);
-            }
-            free(horizon);
-            free(f0);
-            free(nonvisible_faces);
-            free(visible);
-            free(hVec);
-            free(hVec_mem_face);
+            faces[visList[i]].outside = -1;
         }
-        if(FUCKED){
-            break;
+        
+        /* new faces that have points outside of them are processed next */
+        if(nStack+nNew > maxStack){
+            maxStack = maxFaces;
+            stack = realloc(stack, maxStack*sizeof(int));
         }
+        for(j=0; j<nNew; j++)
+            if(faces[newFaces[j]].outside!=-1)
+                stack[nStack++] = newFaces[j];
     }
     
     /* output */
-    if(FUCKED){
-        (*out_faces) = NULL;
-        (*nOut_faces) = nFaces;
-    }
-    else{
-        (*out_faces) = (int*)malloc(nFaces*d*sizeof(int));
-        memcpy((*out_faces),faces, nFaces*d*sizeof(int));
-        (*nOut_faces) = nFaces;
+    for(f=0, n=0; f<nFaces; f++)
+        if(faces[f].alive)
+            n++;
+    (*out_faces) = (int*)malloc(n*3*sizeof(int));
+    (*nOut_faces) = n;
+    for(f=0, n=0; f<nFaces; f++){
+        if(faces[f].alive){
+            for(k=0; k<3; k++)
+                (*out_faces)[n*3+k] = faces[f].v[k];
+            n++;
+        }
     }
     
-    /* clean-up */
-    free(visible_ind);
-    free(points_cf);
-    free(points_s);
-    free(face_s);
-    free(gVec); 
-    free(meanp);
-    free(absdist);
-    free(reldist);
-    free(desReldist);
-    free(ind);
-    free(span);
-    free(points);
+    free(P);
     free(faces);
-    free(aVec);
-    free(cf);
-    free(cfi);
-    free(df);
-    free(p_s);
-    free(face_tmp);
-    free(fVec);
-    free(asfVec);
-    free(bVec);
-    free(A);
+    free(next);
+    free(stack);
+    free(visList);
+    free(horizon);
+    free(newFaces);
+    free(startFace);
+    free(endFace);
+}
+
+/* lexicographic comparison of two faces (based on their first and second vertex indices) */
+static int convhull_cmp_faces(const void *a,const void *b) {
+    const int* f1 = (const int*)a;
+    const int* f2 = (const int*)b;
+    if(f1[0]!=f2[0]) return f1[0]<f2[0] ? -1 : 1;
+    else if(f1[1]!=f2[1]) return f1[1]<f2[1] ? -1 : 1;
+    else return 0;
 }
 
 static void ccross(float a[3], float b[3], float c[3]){
@@ -683,11 +410,11 @@ void findLsTriplets
 )
 {
     int i, j, k, numValidFaces, minIntVal, minIdx, nFaces;
-    int tmp3[3], circface[3];
+    int circface[3];
     int* validFacesID, *valid_faces, *valid_faces2, *faces;
     float dotcc, aperture_lim;
     float vecs[3][3], cvec[3], centroid[3], a[3], b[3], abc[3];
-    REAL r, rcoselev;
+    REAL rcoselev;
     REAL* vertices;
     
     /* Find the convex hull of the points on the sphere - in this special case the
@@ -696,26 +423,12 @@ void findLsTriplets
     (*numOutVertices)  = L;
     (*out_vertices) = (float*)malloc(L*3*sizeof(float));
     for ( i = 0; i < L; i++) {
-        if(L>1000)
-            r = 1.0 + (REAL)rand()/(REAL)RAND_MAX*0.00001; /* add some noise to the data (it helps) */
-        else
-            r = 1.0 + (REAL)rand()/(REAL)RAND_MAX*0.001; /* add some noise to the data (it helps) */
-        (*out_vertices)[i*3+2] = (float)(r* (REAL)sin((double)ls_dirs_deg[i*2+1]*M_PI/180.0));
-        rcoselev = r*(REAL)cos((double)ls_dirs_deg[i*2+1]*M_PI/180.0);
-        (*out_vertices)[i*3+0] = (float)(rcoselev * (REAL)cos((double)ls_dirs_deg[i*2+0]*M_PI/180.0));
-        (*out_vertices)[i*3+1] = (float)(rcoselev * (REAL)sin((double)ls_dirs_deg[i*2+0]*M_PI/180.0));
-        if(L>1000) {/* starts becoming unstable past this point */
-            for(j=0; j<3; j++)
-                vertices[i*3+j] = (REAL)(*out_vertices)[i*3+j] + (REAL)rand()/(REAL)RAND_MAX*0.000001; /* add some noise to the data (it helps) */
-        }
-        else if(L>100){
-            for(j=0; j<3; j++)
-                vertices[i*3+j] = (REAL)(*out_vertices)[i*3+j] + (REAL)rand()/(REAL)RAND_MAX*0.001; /* add some noise to the data (it helps) */
-        }
-        else{
-            for(j=0; j<3; j++)
-                vertices[i*3+j] = (REAL)(*out_vertices)[i*3+j] + (REAL)rand()/(REAL)RAND_MAX*0.01; /* add some noise to the data (it helps) */
-        }
+        vertices[i*3+2] = (REAL)sin((double)ls_dirs_deg[i*2+1]*M_PI/180.0);
+        rcoselev = (REAL)cos((double)ls_dirs_deg[i*2+1]*M_PI/180.0);
+        vertices[i*3+0] = rcoselev * (REAL)cos((double)ls_dirs_deg[i*2+0]*M_PI/180.0);
+        vertices[i*3+1] = rcoselev * (REAL)sin((double)ls_dirs_deg[i*2+0]*M_PI/180.0);
+        for(j=0; j<3; j++)
+            (*out_vertices)[i*3+j] = (float)vertices[i*3+j];
     }
     faces = NULL;
     convhull_3d(vertices, L, &faces, &nFaces);
@@ -744,45 +457,8 @@ void findLsTriplets
             faces[i*3+j] = circface[j];
     }
     
-    /* sort indices in accending order for the first dimension */
-    for (j=0; j<nFaces - 1; j++)  {
-        for (i=0; i<nFaces - 1; i++) {
-            if (faces[(i+1)*3+0] < faces[i*3+0])  {
-                for(k=0; k<3; k++){
-                    tmp3[k] = faces[i*3+k];
-                    faces[i*3+k] = faces[(i+1)*3+k];
-                    faces[(i+1)*3+k] = tmp3[k];
-                }
-            }
-        }
-    }
-    
-    /* sort indices in accending order for the second dimension */
-    for (j=0; j<nFaces - 1; j++)  {
-        for (i=0; i<nFaces - 1; i++) {
-            if ( (faces[(i+1)*3+1] < faces[i*3+1]) && (faces[(i+1)*3+0] == faces[i*3+0]) ) {
-                for(k=0; k<3; k++){
-                    tmp3[k] = faces[i*3+k];
-                    faces[i*3+k] = faces[(i+1)*3+k];
-                    faces[(i+1)*3+k] = tmp3[k];
-                }
-            }
-        }
-    }
-#if 0
-    /* sort indices in accending order for the third dimension */
-    for (j=0; j<nFaces - 1; j++)  {
-        for (i=0; i<nFaces - 1; i++) {
-            if ( (faces[(i+1)*3+2] < faces[i*3+2]) && (faces[(i+1)*3+0] == faces[i*3+0]) && (faces[(i+1)*3+1] == faces[i*3+1])) {
-                for(k=0; k<3; k++){
-                    tmp3[k] = faces[i*3+k];
-                    faces[i*3+k] = faces[(i+1)*3+k];
-                    faces[(i+1)*3+k] = tmp3[k];
-                }
-            }
-        }
-    }
-#endif
+    /* sort in accending order of the first, and then the second, vertex indices */
+    qsort(faces, nFaces, 3*sizeof(int), convhull_cmp_faces);
     
     /* Omit triplets if their normals and the centroid to the triplets have an angle larger than pi/2 */
     numValidFaces = 0;
@@ -916,72 +592,115 @@ void invertLsMtx3D
     free(tempGroup);
 }
 
-void vbap3D
+void findLsTripletNeighbours
 (
-    float* src_dirs,
-    int src_num,
-    int ls_num,
     int* ls_groups,
     int nFaces,
-    float* layoutInvMtx,
-    float** GainMtx
+    int* neighbours
 )
 {
-    int i, j, ns;
-    float azi_rad, elev_rad, min_val, g_tmp_rms, gains_rms;
-    float u[3], g_tmp[3], ls_invMtx_s[3];
-    float* gains;
+    int i, j, nEdges;
+    int* edges;
     
-    (*GainMtx) = malloc(src_num*ls_num*sizeof(float));
-    gains = malloc(ls_num*sizeof(float)); 
+    /* sort the edges by their (min,max) vertex indices, so that each shared edge appears as two consecutive entries */
+    nEdges = 3*nFaces;
+    edges = malloc(nEdges*3*sizeof(int));
+    for(i=0; i<nFaces; i++){
+        for(j=0; j<3; j++){
+            edges[(i*3+j)*3+0] = MIN(ls_groups[i*3+(j+1)%3], ls_groups[i*3+(j+2)%3]);
+            edges[(i*3+j)*3+1] = MAX(ls_groups[i*3+(j+1)%3], ls_groups[i*3+(j+2)%3]);
+            edges[(i*3+j)*3+2] = i*3+j;
+            neighbours[i*3+j] = -1;
+        }
+    }
+    qsort(edges, nEdges, 3*sizeof(int), convhull_cmp_faces);
+    for(i=0; i<nEdges-1; i++){
+        if(edges[i*3+0]==edges[(i+1)*3+0] && edges[i*3+1]==edges[(i+1)*3+1]){
+            neighbours[edges[i*3+2]] = edges[(i+1)*3+2]/3;
+            neighbours[edges[(i+1)*3+2]] = edges[i*3+2]/3;
+            i++;
+        }
+    }
+    free(edges);
+}
+
+int findEnclosingLsTriplet
+(
+    float u[3],
+    int nFaces,
+    float* layoutInvMtx,
+    int* neighbours,
+    int startFace,
+    float g[3]
+)
+{
+    int i, face, nSteps, j_min;
+    float* inv;
+    
+    /* walk across the triangulation, starting from startFace, by stepping over the edge opposite the most negative
+     * gain. Neighbouring source directions usually fall into the same, or an adjacent, triangle. If the walk leaves
+     * the triangulation or fails to settle, the faces are instead scanned in order */
+    face = nFaces>0 ? startFace : -1;
+    for(nSteps=0; nSteps<nFaces && face!=-1; nSteps++){
+        inv = &layoutInvMtx[face*9];
+        g[0] = inv[0]*u[0] + inv[1]*u[1] + inv[2]*u[2];
+        g[1] = inv[3]*u[0] + inv[4]*u[1] + inv[5]*u[2];
+        g[2] = inv[6]*u[0] + inv[7]*u[1] + inv[8]*u[2];
+        j_min = g[0] < g[1] ? 0 : 1;
+        j_min = g[2] < g[j_min] ? 2 : j_min;
+        if(g[j_min]>-0.001)
+            return face;
+        face = neighbours[face*3+j_min];
+    }
+    for(i=0; i<nFaces; i++){
+        inv = &layoutInvMtx[i*9];
+        g[0] = inv[0]*u[0] + inv[1]*u[1] + inv[2]*u[2];
+        g[1] = inv[3]*u[0] + inv[4]*u[1] + inv[5]*u[2];
+        g[2] = inv[6]*u[0] + inv[7]*u[1] + inv[8]*u[2];
+        if(MIN(MIN(g[0], g[1]), g[2])>-0.001)
+            return i;
+    }
+    return -1;
+}
+
+void vbap3D
+(
+    float* src_dirs,
+    int src_num,
+    int ls_num,
+    int* ls_groups,
+    int nFaces,
+    float* layoutInvMtx,
+    float** GainMtx
+)
+{
+    int j, ns, face, prev_face;
+    int* neighbours;
+    float azi_rad, elev_rad, g_tmp_rms;
+    float u[3], g_tmp[3];
+    
+    (*GainMtx) = calloc(src_num*ls_num, sizeof(float));
+    neighbours = malloc(3*nFaces*sizeof(int));
+    findLsTripletNeighbours(ls_groups, nFaces, neighbours);
+    prev_face = 0;
     for(ns=0; ns<src_num; ns++){
         azi_rad  = src_dirs[ns*2+0]*M_PI/180.0f;
         elev_rad = src_dirs[ns*2+1]*M_PI/180.0f;
         u[0] = cosf(azi_rad)*cosf(elev_rad);
         u[1] = sinf(azi_rad)*cosf(elev_rad);
         u[2] = sinf(elev_rad);
-        memset(gains, 0, ls_num*sizeof(float));
-        for(i=0; i<nFaces; i++){
-            for(j=0; j<3; j++)
-                ls_invMtx_s[j] = layoutInvMtx[i*9+j];
-            cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, 1, 1, 3, 1.0,
-                        ls_invMtx_s, 3,
-                        u, 3, 0.0,
-                        &g_tmp[0], 1);
-            for(j=0; j<3; j++)
-                ls_invMtx_s[j] = layoutInvMtx[i*9+j+3];
-            cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, 1, 1, 3, 1.0,
-                        ls_invMtx_s, 3,
-                        u, 3, 0.0,
-                        &g_tmp[1], 1);
+        face = findEnclosingLsTriplet(u, nFaces, layoutInvMtx, neighbours, prev_face, g_tmp);
+        
+        /* only the three loudspeakers of the triangle receive gains, the rest of the row remains zero */
+        if(face!=-1){
+            g_tmp_rms = sqrtf(g_tmp[0]*g_tmp[0] + g_tmp[1]*g_tmp[1] + g_tmp[2]*g_tmp[2]);
             for(j=0; j<3; j++)
-                ls_invMtx_s[j] = layoutInvMtx[i*9+j+6];
-            cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, 1, 1, 3, 1.0,
-                        ls_invMtx_s, 3,
-                        u, 3, 0.0,
-                        &g_tmp[2], 1);
-            min_val = 2.23e13f;
-            g_tmp_rms = 0.0;
-            for(j=0; j<3; j++){
-                min_val = MIN(min_val, g_tmp[j]);
-                g_tmp_rms +=  powf(g_tmp[j], 2.0f);
-            }
-            g_tmp_rms = sqrtf(g_tmp_rms);
-            if(min_val>-0.001){
-                for(j=0; j<3; j++)
-                    gains[ls_groups[i*3+j]] = g_tmp[j]/g_tmp_rms;
-                break;
-            }
+                (*GainMtx)[ns*ls_num+ls_groups[face*3+j]] = MAX(g_tmp[j]/g_tmp_rms, 0.0f);
+            prev_face = face;
         }
-        gains_rms = 0.0;
-        for(i=0; i<ls_num; i++)
-            gains_rms += powf(gains[i], 2.0f);
-        gains_rms = sqrtf(gains_rms);
-        for(i=0; i<ls_num; i++)
-            (*GainMtx)[ns*ls_num+i] = MAX(gains[i]/gains_rms, 0.0f); 
     }
     
-    free(gains);
+    free(neighbours);
 }
 
 void findLsPairs
@@ -1056,6 +775,41 @@ void invertLsMtx2D
     free(tempGroup);
 }
 
+void vbap2Dgains
+(
+    float azi_deg,
+    int ls_num,
+    int* ls_pairs,
+    int N_pairs,
+    float* layoutInvMtx,
+    float* gains
+)
+{
+    int i, j;
+    float azi_rad, g_tmp_rms, gains_rms;
+    float u[2], g_tmp[2];
+    
+    azi_rad  = azi_deg*M_PI/180.0f;
+    u[0] = cosf(azi_rad);
+    u[1] = sinf(azi_rad);
+    memset(gains, 0, ls_num*sizeof(float));
+    for(i=0; i<N_pairs; i++){
+        g_tmp[0] = layoutInvMtx[i*4+0]*u[0] + layoutInvMtx[i*4+1]*u[1];
+        g_tmp[1] = layoutInvMtx[i*4+2]*u[0] + layoutInvMtx[i*4+3]*u[1];
+        if(MIN(g_tmp[0], g_tmp[1])>-0.001){
+            g_tmp_rms = sqrtf(g_tmp[0]*g_tmp[0] + g_tmp[1]*g_tmp[1]);
+            for(j=0; j<2; j++)
+                gains[ls_pairs[i*2+j]] = g_tmp[j]/g_tmp_rms;
+        }
+    }
+    gains_rms = 0.0;
+    for(i=0; i<ls_num; i++)
+        gains_rms += powf(gains[i], 2.0f);
+    gains_rms = sqrtf(gains_rms);
+    for(i=0; i<ls_num; i++)
+        gains[i] = MAX(gains[i]/gains_rms, 0.0f);
+}
+
 void vbap2D
 (
     float* src_dirs,
@@ -1067,58 +821,9 @@ void vbap2D
     float** GainMtx
 )
 {
-    int i, j, ns;
-    float azi_rad, min_val, g_tmp_rms, gains_rms;
-    float u[2], g_tmp[2], ls_invMtx_s[2];
-    float* gains;
+    int ns;
     
     (*GainMtx) = malloc(src_num*ls_num*sizeof(float));
-    gains = malloc(ls_num*sizeof(float));
-    for(ns=0; ns<src_num; ns++){
-        azi_rad  = src_dirs[ns]*M_PI/180.0f;
-        u[0] = cosf(azi_rad);
-        u[1] = sinf(azi_rad);
-        memset(gains, 0, ls_num*sizeof(float));
-        for(i=0; i<N_pairs; i++){
-            for(j=0; j<2; j++)
-                ls_invMtx_s[j] = layoutInvMtx[i*4+j];
-            cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, 1, 1, 2, 1.0,
-                        ls_invMtx_s, 2,
-                        u, 2, 0.0,
-                        &g_tmp[0], 1);
-            for(j=0; j<2; j++)
-                ls_invMtx_s[j] = layoutInvMtx[i*4+j+2];
-            cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, 1, 1, 2, 1.0,
-                        ls_invMtx_s, 2,
-                        u, 2, 0.0,
-                        &g_tmp[1], 1);
-            min_val = 2.23e13f;
-            g_tmp_rms = 0.0;
-            for(j=0; j<2; j++){
-                min_val = MIN(min_val, g_tmp[j]);
-                g_tmp_rms +=  powf(g_tmp[j], 2.0f);
-            }
-            g_tmp_rms = sqrtf(g_tmp_rms);
-            if(min_val>-0.001){
-                for(j=0; j<2; j++)
-                    gains[ls_pairs[i*2+j]] = g_tmp[j]/g_tmp_rms;
-            }
-        }
-        gains_rms = 0.0;
-        for(i=0; i<ls_num; i++)
-            gains_rms += powf(gains[i], 2.0f);
-        gains_rms = sqrtf(gains_rms);
-        for(i=0; i<ls_num; i++)
-            (*GainMtx)[ns*ls_num+i] = MAX(gains[i]/gains_rms, 0.0f);
-    }
-    
-    free(gains);
+    for(ns=0; ns<src_num; ns++)
+        vbap2Dgains(src_dirs[ns], ls_num, ls_pairs, N_pairs, layoutInvMtx, &(*GainMtx)[ns*ls_num]);
 }
-
-
-
-
-
-
-
-
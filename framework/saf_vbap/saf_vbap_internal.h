@@ -39,12 +39,23 @@ extern "C" {
 #endif
  
 #define ADD_DUMMY_LIMIT ( 60.0f )             /* in degrees, if no ls_dirs have elevation +/- this value. Dummies are placed at +/- 90 elevation.  */
-#define MAX_NUM_FACES ( 5000 )                /* avoids infinite loops in the 3d convexhull main loop */
+#define CONVHULL_3D_GRID ( 262144.0 )         /* 2^18; vertices are snapped to this grid, so that the 3d convexhull orientation tests are exact in 64-bit */
 #define APERTURE_LIMIT_DEG ( 180.0f )         /* if omitLargeTriangles==1, triangles with an aperture larger than this are discarded */
 #ifndef M_PI
   #define M_PI ( 3.14159265359f )
 #endif
     
+/* persistent 3-D VBAP data; see vbap_create() */
+typedef struct _vbap_data {
+    int L;                                    /* number of loudspeakers, excluding any dummies */
+    int nFaces;                               /* number of loudspeaker triangles */
+    int* ls_groups;                           /* loudspeaker triangle indices; FLAT: nFaces x 3 */
+    int* neighbours;                          /* triangle neighbours; FLAT: nFaces x 3 */
+    float* layoutInvMtx;                      /* inverted 3x3 loudspeaker matrices; FLAT: nFaces x 9 */
+    int prevFace;                             /* triangle found by the previous query */
+    
+}vbap_data;
+    
 /* Calculates the 3D convex-hull of a spherical grid of loudspeaker directions */
 void findLsTriplets(float* ls_dirs_deg,       /* loudspeaker/source directions; FLAT: L x 2 */
                     int L,                    /* number of loudspeakers */
@@ -60,6 +71,20 @@ void invertLsMtx3D(float* U_spkr,             /* loudspeaker directions in carte
                    int N_group,               /* number of true loudspeaker triangles */
                    float** layoutInvMtx);     /* & inverted 3x3 loudspeaker matrices per group; FLAT: N_group x 9 */
     
+/* Finds the neighbouring triangle across each edge of the loudspeaker triangles */
+void findLsTripletNeighbours(int* ls_groups,  /* true loudspeaker triangle indices; FLAT: nFaces x 3 */
+                             int nFaces,      /* number of true loudspeaker triangles */
+                             int* neighbours); /* triangle across the edge opposite each vertex, -1 if none; FLAT: nFaces x 3 */
+    
+/* Finds the loudspeaker triangle enclosing a direction (by walking from startFace over the neighbours), and returns its
+ * index, or -1 if there is none. The unnormalised VBAP gains for the three loudspeakers of this triangle are also returned */
+int findEnclosingLsTriplet(float u[3],                  /* source direction, unit-length cartesian vector; 3 x 1 */
+                           int nFaces,                  /* number of true loudspeaker triangles */
+                           float* layoutInvMtx,         /* inverted 3x3 loudspeaker matrix flattened; FLAT: nFaces x 9 */
+                           int* neighbours,             /* triangle neighbours, see findLsTripletNeighbours; FLAT: nFaces x 3 */
+                           int startFace,               /* triangle to start the search from, e.g. that of the previous direction */
+                           float g[3]);                 /* VBAP gains for the returned triangle; 3 x 1 */
+    
 /* Calculates 3D VBAP gains for pre-calculated loudspeaker triangles and predefined source positions */
 void vbap3D(float* src_dirs,                  /* source directions; FLAT: src_num x 2 */
             int src_num,                      /* number of sources */
@@ -81,6 +106,14 @@ void invertLsMtx2D(float* U_spkr,             /* loudspeaker directions in carte
                    int N_pairs,               /* number of loudspeaker pairs */
                    float** layoutInvMtx);     /* & inverted 2x2 loudspeaker matrix flattened; FLAT: N_group x 4 */
     
+/* Calculates 2D VBAP gains for pre-calculated loudspeaker pairs and one source position */
+void vbap2Dgains(float azi_deg,               /* source azimuth in degrees */
+                 int ls_num,                  /* number of loudspeakers */
+                 int* ls_pairs,               /* loudspeaker pair indices; FLAT: N_pairs x 2 */
+                 int N_pairs,                 /* number of loudspeaker pairs */
+                 float* layoutInvMtx,         /* inverted 2x2 loudspeaker matrix flattened; FLAT: N_pairs x 4 */
+                 float* gains);               /* Loudspeaker VBAP gains ENERGY NORMALISED; ls_num x 1 */
+    
 /* Calculates 2D VBAP gains for pre-calculated loudspeaker pairs and predefined source positions */
 void vbap2D(float* src_dirs,                  /* source directions; FLAT: src_num x 1 */
             int src_num,                      /* number of sources */